@@ -5,10 +5,49 @@
 #include <system_error>
 #include <string>
 #include <iostream>
+#include <cstdio>
 
+#ifdef _WIN32
 #include <WS2tcpip.h>
 
 #pragma comment (lib, "ws2_32")
+#else
+// POSIX sockets under the Winsock names used by this project
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cerrno>
+typedef int SOCKET;
+typedef sockaddr SOCKADDR;
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#define MAKEWORD(low, high) (static_cast<unsigned short>((low) | ((high) << 8)))
+struct WSAData {};
+typedef WSAData WSADATA;
+inline int WSAStartup(unsigned short, WSADATA*) { return 0; }
+inline int WSACleanup() { return 0; }
+inline int WSAGetLastError() { return errno; }
+inline int closesocket(SOCKET sock) { return close(sock); }
+#endif
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <cstring>
+#define UDP_SOCKET_HAS_RECVMMSG (1)
+#ifdef SO_RXQ_OVFL
+#define UDP_SOCKET_HAS_RXQ_OVFL (1)
+#endif
+#ifdef SO_REUSEPORT
+#define UDP_SOCKET_HAS_REUSEPORT (1)
+#endif
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+#include <linux/filter.h>
+#define UDP_SOCKET_HAS_REUSEPORT_CBPF (1)
+#endif
+#endif
+#define UDP_SOCKET_MAX_BATCH (64)
 
 class WSASession
 {
@@ -62,21 +101,69 @@ public:
     sockaddr_in RecvFrom(char* buffer, int len, int flags, int* outReadDataSize)
     {
         sockaddr_in from;
-        int size = sizeof(from);
+        socklen_t size = sizeof(from);
         int ret = recvfrom(sock, buffer, len, flags, reinterpret_cast<SOCKADDR*>(&from), &size);
         
         // make the buffer zero terminated        
         *outReadDataSize = ret;
         return from;
     }
+    // Receive up to maxCount datagrams with one call, buffers[i] gets the i-th datagram.
+    // Blocks until the first datagram arrives, returns the number received (0 on timeout or error).
+    // Without recvmmsg only one datagram is received per call.
+    int RecvBatch(char** buffers, int len, int maxCount, int* outReadDataSizes)
+    {
+        if (maxCount > UDP_SOCKET_MAX_BATCH)
+            maxCount = UDP_SOCKET_MAX_BATCH;
+        if (maxCount <= 0)
+            return 0;
+#if UDP_SOCKET_HAS_RECVMMSG
+        mmsghdr msgs[UDP_SOCKET_MAX_BATCH];
+        iovec iovs[UDP_SOCKET_MAX_BATCH];
+#if UDP_SOCKET_HAS_RXQ_OVFL
+        char controls[UDP_SOCKET_MAX_BATCH][CMSG_SPACE(sizeof(unsigned int))];
+#endif
+        for (int i = 0; i < maxCount; ++i)
+        {
+            iovs[i].iov_base = buffers[i];
+            iovs[i].iov_len = len;
+            memset(&msgs[i], 0, sizeof(mmsghdr));
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+#if UDP_SOCKET_HAS_RXQ_OVFL
+            if (dropCounterEnabled)
+            {
+                msgs[i].msg_hdr.msg_control = controls[i];
+                msgs[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+            }
+#endif
+        }
+        int ret = recvmmsg(sock, msgs, maxCount, MSG_WAITFORONE, nullptr);
+        if (ret < 0)
+            return 0;
+        for (int i = 0; i < ret; ++i)
+        {
+            outReadDataSizes[i] = static_cast<int>(msgs[i].msg_len);
+        }
+#if UDP_SOCKET_HAS_RXQ_OVFL
+        // The counter is cumulative, the last datagram carries the newest value
+        if (dropCounterEnabled)
+            ReadDropCounter(&msgs[ret - 1].msg_hdr);
+#endif
+        return ret;
+#else
+        RecvFrom(buffers[0], len, 0, &outReadDataSizes[0]);
+        return outReadDataSizes[0] < 0 ? 0 : 1;
+#endif
+    }
     void Bind(unsigned short port)
     {
         sockaddr_in add;
         add.sin_family = AF_INET;
         add.sin_addr.s_addr = htonl(INADDR_ANY);
         add.sin_port = htons(port);
-        char option = 1;
-        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+        int option = 1;
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<char*>(&option), sizeof(option));
         struct timeval optVal = { 5, 0 };
 
         int optLen = sizeof(optVal);
@@ -87,7 +174,88 @@ public:
         if (ret < 0)
             printf("Bind failed");
     }
+    // Let several sockets bind the same port, the kernel spreads datagrams among them by flow hash.
+    // Must be called before Bind. Returns false where the platform has no SO_REUSEPORT.
+    bool EnableReusePort()
+    {
+#if UDP_SOCKET_HAS_REUSEPORT
+        int option = 1;
+        return setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &option, sizeof(option)) == 0;
+#else
+        return false;
+#endif
+    }
+    // Replace flow hashing in this socket's SO_REUSEPORT group: a datagram goes to the socket
+    // (payload[byteOffset] & mask) % groupSize, in bind order. Call after Bind.
+    bool SteerReusePortByPayloadByte(unsigned int byteOffset, unsigned char mask, unsigned int groupSize)
+    {
+#if UDP_SOCKET_HAS_REUSEPORT_CBPF
+        // The program sees the datagram with the UDP header already pulled, offset 0 is the payload
+        sock_filter code[] = {
+            BPF_STMT(BPF_LD | BPF_B | BPF_ABS, byteOffset),
+            BPF_STMT(BPF_ALU | BPF_AND | BPF_K, mask),
+            BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, groupSize),
+            BPF_STMT(BPF_RET | BPF_A, 0),
+        };
+        sock_fprog program = { static_cast<unsigned short>(sizeof(code) / sizeof(code[0])), code };
+        return setsockopt(sock, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == 0;
+#else
+        return false;
+#endif
+    }
+    SOCKET GetHandle()
+    {
+        return sock;
+    }
+    // Request a kernel receive buffer size in bytes. Returns the size the kernel actually granted, -1 on error.
+    // Linux reports twice the usable size and caps the request at net.core.rmem_max.
+    int SetReceiveBufferSize(int bytes)
+    {
+        int ret = setsockopt(sock, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<char*>(&bytes), sizeof(bytes));
+        if (ret < 0)
+            printf("Setting receive buffer size failed\n");
+        return GetReceiveBufferSize();
+    }
+    int GetReceiveBufferSize()
+    {
+        int bytes = 0;
+        socklen_t optLen = sizeof(bytes);
+        int ret = getsockopt(sock, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<char*>(&bytes), &optLen);
+        if (ret < 0)
+            return -1;
+        return bytes;
+    }
+    // Ask the kernel to report datagrams dropped before they reached this socket's receive queue.
+    // Returns false where the platform has no such counter.
+    bool EnableDropCounter()
+    {
+#if UDP_SOCKET_HAS_RXQ_OVFL
+        int option = 1;
+        dropCounterEnabled = setsockopt(sock, SOL_SOCKET, SO_RXQ_OVFL, &option, sizeof(option)) == 0;
+#endif
+        return dropCounterEnabled;
+    }
+    // Datagrams the kernel dropped for this socket, as of the last RecvBatch
+    unsigned int GetDropCount()
+    {
+        return dropCount;
+    }
 
 private:
     SOCKET sock;
+    bool dropCounterEnabled = false;
+    unsigned int dropCount = 0;
+
+#if UDP_SOCKET_HAS_RXQ_OVFL
+    void ReadDropCounter(msghdr* msg)
+    {
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(msg, cmsg))
+        {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL)
+            {
+                memcpy(&dropCount, CMSG_DATA(cmsg), sizeof(dropCount));
+            }
+        }
+    }
+#endif
 };
\ No newline at end of file
@@ -28,6 +28,22 @@
 using namespace std;
 using namespace hurel::sre3021;
 
+// Host receive time of image packets, see SRE3021ImageData::ReceiveTime
+static long long SteadyClockNanoseconds()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Listener counters have one writer, a relaxed load and store is enough and avoids a locked add
+static void AddUDPCount(std::atomic<size_t>& counter, size_t count)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+}
+
+// Room for the events and samples of the largest multi-event pulse-height packet a pool slot can hold
+static const size_t PulseHeightArenaSize = 256 * sizeof(SRE3021PulseHeightEvent)
+	+ SRE3021_UDP_PULSE_HEIGHT_SLOT_SIZE / SRE3021_MULTI_PULSE_HEIGHT_SAMPLE_LENGTH * sizeof(SRE3021PulseHeightSample) + alignof(SRE3021PulseHeightSample);
+
 void hurel::sre3021::SRE3021API::ReadAllSysRegs()
 {
 	SRE3021SysRegisters = vector<SRE3021SysReg>();
@@ -44,7 +60,7 @@ void hurel::sre3021::SRE3021API::ReadAllSysRegs()
 	}*/	
 }
 
-void hurel::sre3021::SRE3021API::BaseLineEventCheck(SRE3021ImageData imageData)
+void hurel::sre3021::SRE3021API::BaseLineEventCheck(const SRE3021CompactImageData& imageData)
 {
 	mutexBaseLineImageEvents.lock();
 	BaseLineImageEvents.push_back(imageData);
@@ -365,7 +381,11 @@ SRE3021SysReg hurel::sre3021::SRE3021API::WriteSysReg(SRE3021SysRegisterADDR add
 void hurel::sre3021::SRE3021API::InitiateSRE3021API()
 {
 	// ping check to SRE3021
+#ifdef _WIN32
 	FILE* pipe = _popen("ping 10.10.0.50 -n 2", "rt");
+#else
+	FILE* pipe = popen("ping -c 2 10.10.0.50", "r");
+#endif
 	if (pipe != NULL)
 	{
 		int rd = 0;
@@ -377,7 +397,7 @@ void hurel::sre3021::SRE3021API::InitiateSRE3021API()
 			rd += static_cast<int>(ret);
 		}
 
-		if (strstr(buffer, "TTL=") != NULL)
+		if (strstr(buffer, "TTL=") != NULL || strstr(buffer, "ttl=") != NULL)
 		{
 			printf("\nSRE3021 is reachable!\n");
 		}
@@ -389,7 +409,11 @@ void hurel::sre3021::SRE3021API::InitiateSRE3021API()
 
 		//printf( "%d bytes read\n\n%s\n", rd, buffer );
 
+#ifdef _WIN32
 		_pclose(pipe);
+#else
+		pclose(pipe);
+#endif
 	}
 	else
 	{
@@ -398,7 +422,7 @@ void hurel::sre3021::SRE3021API::InitiateSRE3021API()
 	}
 
 	cout << "Start initiating" << endl;
-	OpenUDPServer();
+	OpenUDPServer(UDPReceiveBackend);
 
 	
 	ReadWriteASICReg(SRE3021ASICRegisterADDR::Anode_Channel_3_Disable, true);
@@ -416,6 +440,7 @@ void hurel::sre3021::SRE3021API::InitiateSRE3021API()
 
 	ReadWriteASICReg(SRE3021ASICRegisterADDR::Anode_Channel_1_Disable, true);
 	UDPImageBufferRaiserFunc = &hurel::sre3021::SRE3021API::BasicImageProcessingFunc;
+	UDPImageBufferChannelEventFunc = &hurel::sre3021::SRE3021API::BasicChannelEventProcessingFunc;
 	return ;
 }
 
@@ -776,311 +801,1300 @@ bool hurel::sre3021::SRE3021API::GetASICConfigtBitValue(SRE3021ASICRegisterADDR
 	return ASICConfigBits[650 - static_cast<int>(addr)];
 }
 
-bool hurel::sre3021::SRE3021API::OpenUDPServer()
+bool hurel::sre3021::SRE3021API::OpenUDPServer(SRE3021UDPReceiveBackend backend)
 {
+	UDPReceiveBackend = backend;
+	UDPImageDecoder.SetBaseline(AnodeValueBaseline, AnodeTimingBaseline, CathodeValueBaseline, CathodeTimingBaseline);
+	UDPWaveformProcessor.SetFilter(UDPWaveformFilter);
+	// Trigger time packets must reach the coincidence finder in arrival order, see SetUDPDecodeOrdering
+	const SRE3021UDPDecodeOrdering decodeOrdering = UDPAcquisitionMode == SRE3021AcquisitionMode::TRIGGER_TIME ? SRE3021UDPDecodeOrdering::ARRIVAL : UDPDecodeOrdering;
+	UDPShards.clear();
+	for (int i = 0; i < UDPShardCount; ++i)
+	{
+		std::unique_ptr<UDPReceiverShard> shard(new UDPReceiverShard());
+		shard->Index = i;
+		shard->ImageBuffer.Resize(UDPImageBufferCapacity);
+		shard->AcquisitionMode = UDPAcquisitionMode;
+		size_t slotSize = SRE3021_IMAGE_PACKET_LENGTH;
+		if (UDPAcquisitionMode == SRE3021AcquisitionMode::MULTI_PULSE_HEIGHT)
+		{
+			slotSize = SRE3021_UDP_PULSE_HEIGHT_SLOT_SIZE;
+		}
+		else if (UDPAcquisitionMode == SRE3021AcquisitionMode::WAVEFORM)
+		{
+			slotSize = SRE3021_PACKET_HEADER_LENGTH + SRE3021_PIPELINE_SAMPLING_DATA_LENGTH;
+		}
+		else if (UDPAcquisitionMode == SRE3021AcquisitionMode::TRIGGER_TIME)
+		{
+			slotSize = SRE3021_UDP_TRIGGER_TIME_SLOT_SIZE;
+		}
+		else if (UDPAcquisitionMode == SRE3021AcquisitionMode::COUNTING)
+		{
+			slotSize = SRE3021_PACKET_HEADER_LENGTH + SRE3021_COUNTING_FRAME_DATA_LENGTH;
+		}
+		else if (UDPAcquisitionMode == SRE3021AcquisitionMode::IMAGE_FRAME)
+		{
+			slotSize = SRE3021_UDP_IMAGE_FRAME_SLOT_SIZE;
+			shard->ImageFrame.Reassembler.Allocate(SRE3021_IMAGE_FRAME_POOL_SIZE, SRE3021_UDP_IMAGE_FRAME_SLOT_SIZE - SRE3021_IMAGE_DATA_OFFSET);
+			shard->ImageFrame.Reassembler.SetTimeout(UDPImageFrameTimeout * 1000000LL);
+		}
+		else if (UDPAcquisitionMode == SRE3021AcquisitionMode::SINGLE_CHANNEL)
+		{
+			slotSize = SRE3021_UDP_SINGLE_CHANNEL_SLOT_SIZE;
+		}
+		shard->PacketPool.Allocate(shard->ImageBuffer.Capacity() + SRE3021_UDP_PACKET_POOL_HEADROOM, slotSize);
+		if (UDPAcquisitionMode == SRE3021AcquisitionMode::MULTI_PULSE_HEIGHT)
+		{
+			shard->PulseHeight.Arena.Allocate(PulseHeightArenaSize);
+		}
+		shard->TriggerTime.CoincidenceFinder.SetSettings(UDPCoincidenceSettings);
+		shard->DeliveredImageEvents.Attach(&UDPImageEventBus);
+		shard->Counting.RateCounts = std::vector<unsigned long long>(SRE3021_ASIC_CHANNEL_COUNT, 0);
+		shard->Counting.RateTime = std::chrono::steady_clock::now();
+		shard->ImageBufferDoorbell.SetSpinBudget(UDPRaiserSpinBudget);
+		shard->BackpressurePolicy = UDPBackpressurePolicy;
+		shard->HighWatermark = static_cast<size_t>(UDPImageBufferHighWatermark * shard->ImageBuffer.Capacity());
+		shard->LowWatermark = static_cast<size_t>(UDPImageBufferLowWatermark * shard->ImageBuffer.Capacity());
+		for (std::atomic<size_t>& batchCount : shard->RecvBatchSizeHistogram)
+		{
+			batchCount.store(0, std::memory_order_relaxed);
+		}
+		shard->SequenceTracker.Reset();
+		shard->RateTime = std::chrono::steady_clock::now();
+		shard->DecodeOrdering = decodeOrdering;
+		for (int j = 0; j < UDPDecodeWorkerCount; ++j)
+		{
+			shard->DecodeWorkerDoorbells.push_back(std::unique_ptr<SRE3021Doorbell>(new SRE3021Doorbell(UDPRaiserSpinBudget)));
+		}
+		if (UDPDecodeWorkerCount > 0 && decodeOrdering == SRE3021UDPDecodeOrdering::ARRIVAL)
+		{
+			// Workers run at most one image buffer ahead of the oldest event not handed over yet
+			shard->DecodedEvents.Resize(shard->ImageBuffer.Capacity());
+			const size_t payloadCount = shard->DecodedEvents.Capacity();
+			if (UDPAcquisitionMode == SRE3021AcquisitionMode::IMAGE || UDPAcquisitionMode == SRE3021AcquisitionMode::IMAGE_FRAME)
+			{
+				shard->Image.DecodedImageData.resize(payloadCount);
+				shard->Image.DecodedCompactImageData.resize(payloadCount);
+			}
+			else if (UDPAcquisitionMode == SRE3021AcquisitionMode::WAVEFORM)
+			{
+				shard->Waveform.DecodedWaveforms.resize(payloadCount);
+				shard->Waveform.DecodedResults.resize(payloadCount);
+			}
+			else if (UDPAcquisitionMode == SRE3021AcquisitionMode::SINGLE_CHANNEL)
+			{
+				shard->SingleChannel.DecodedChannelEvents.resize(payloadCount);
+			}
+		}
+		UDPShards.push_back(std::move(shard));
+	}
+
 	isUdpServerOpen = true;
-	udpThread = thread([this] {RunUDPServer(); });
-	
-	
-	udpRaiserThread = thread([this] {UDPImageBufferRaiser(); });
+	for (auto& shard : UDPShards)
+	{
+		UDPReceiverShard* pShard = shard.get();
+		shard->udpThread = thread([this, pShard] {RunUDPServer(*pShard); });
+		if (UDPDecodeWorkerCount == 0)
+		{
+			shard->udpRaiserThread = thread([this, pShard] {UDPImageBufferRaiser(*pShard); });
+		}
+		for (int j = 0; j < UDPDecodeWorkerCount; ++j)
+		{
+			shard->udpDecodeWorkerThreads.push_back(thread([this, pShard, j] {UDPDecodeWorker(*pShard, j); }));
+		}
+	}
 	return true;
 }
 
-void hurel::sre3021::SRE3021API::RunUDPServer()
+void hurel::sre3021::SRE3021API::RunUDPServer(UDPReceiverShard& shard)
 {
-	char* Buffer = new char[16 * 4096];
-	
-	int PORT = 50011;
+	int PORT = SRE3021_UDP_IMAGE_PORT;
 	
 	
 	WSASession Session;
 	UDPSocket Socket;
 
+	if (UDPShardCount > 1 && !Socket.EnableReusePort())
+	{
+		printf("UDP shard %d: SO_REUSEPORT failed\n", shard.Index);
+	}
 	Socket.Bind(PORT);
-	while (true)
+	if (UDPShardCount > 1 && shard.Index == 0)
 	{
-		int dataSize = 0;
-		sockaddr_in add = Socket.RecvFrom(Buffer, 16 * 4096, 0, &dataSize);
-		if (dataSize == 514)
+		// Keep each detector's stream on one shard, the kernel flow hash is used if this fails
+		if (!Socket.SteerReusePortByPayloadByte(0, 0x1F, static_cast<unsigned int>(UDPShardCount)))
 		{
-			mutexUDPImageBuffer.lock();
-			//std::cout << "Data received: " << dataSize << std::endl
-			UdpPacketCount++;
-			if( UdpPacketCount % 100000 == 0)
-			{
-				printf("UDP Packet Count %d\n", UdpPacketCount);
-			}
-			
-			vector<unsigned __int8> v(Buffer, Buffer + 514);
-			UDPImageBuffer.push(v);
-			mutexUDPImageBuffer.unlock();
+			printf("UDP shard steering by SystemNumber is not available, using kernel flow hash\n");
 		}
-		if (!isUdpServerOpen)
+	}
+	shard.GrantedReceiveBufferSize = Socket.SetReceiveBufferSize(UDPReceiveBufferSize);
+	if (shard.GrantedReceiveBufferSize < UDPReceiveBufferSize)
+	{
+		printf("UDP receive buffer requested %d bytes, granted %d bytes\n", UDPReceiveBufferSize, shard.GrantedReceiveBufferSize);
+	}
+	shard.isKernelDropCountSupported = Socket.EnableDropCounter();
+
+	shard.ActiveReceiveBackend = SRE3021UDPReceiveBackend::SOCKET;
+	if (UDPReceiveBackend == SRE3021UDPReceiveBackend::IO_URING)
+	{
+		if (ReceiveUDPWithIoUring(shard, Socket))
 		{
-			break;
+			printf("udp listener end\n");
+			return;
 		}
+		printf("io_uring receive backend is not available, using socket receive\n");
 	}
-
-	delete[] Buffer;
-
+	else if (UDPReceiveBackend == SRE3021UDPReceiveBackend::PACKET_MMAP)
+	{
+		if (ReceiveUDPWithPacketMmap(shard, Socket))
+		{
+			printf("udp listener end\n");
+			return;
+		}
+		printf("packet mmap capture is not available, using socket receive\n");
+	}
+	ReceiveUDPWithSocket(shard, Socket);
 
 	printf("udp listener end\n");
 	return;
 }
 
-void hurel::sre3021::SRE3021API::UDPImageBufferRaiser()
+void hurel::sre3021::SRE3021API::ReceiveUDPWithSocket(UDPReceiverShard& shard, UDPSocket& Socket)
 {
+	// Only used to drain the socket while every pool slot is in use
+	char* Buffer = new char[16 * 4096];
+
+	// Slots owned by this thread. A slot that did not end up in the image buffer is kept for the next batch,
+	// only the image processing thread gives slots back to the pool.
+	unsigned __int32 slotIndices[SRE3021_UDP_RECV_BATCH_SIZE];
+	char* slotBuffers[SRE3021_UDP_RECV_BATCH_SIZE];
+	int dataSizes[SRE3021_UDP_RECV_BATCH_SIZE];
+	int heldSlotCount = 0;
+	const int slotLength = static_cast<int>(shard.PacketPool.GetSlotStride());
+
 	while (true)
 	{
-		if (!isUdpServerOpen)
-		{
-			break;
-		}
-		mutexUDPImageBufferRaiserFunc.lock();
-		if (UDPImageBufferRaiserFunc == nullptr)
+		while (heldSlotCount < SRE3021_UDP_RECV_BATCH_SIZE && shard.PacketPool.TryAcquire(slotIndices[heldSlotCount]))
 		{
-			mutexUDPImageBufferRaiserFunc.unlock();
-			continue;
+			slotBuffers[heldSlotCount] = reinterpret_cast<char*>(shard.PacketPool.Data(slotIndices[heldSlotCount]));
+			++heldSlotCount;
 		}
-		mutexUDPImageBufferRaiserFunc.unlock();
-		bool bIslock = false;
-		mutexUDPImageBuffer.lock();
-		bIslock = true;
-		if (UDPImageBuffer.size() != 0)
+
+		if (heldSlotCount == 0)
 		{
-			std::vector<unsigned __int8> bytes = UDPImageBuffer.front();
-			UDPImageBuffer.pop();
-			mutexUDPImageBuffer.unlock();
-			
-			bIslock = false;
-			unsigned __int8 headerbytes[10];
-			for (int i = 0; i < 10; ++i)
+			int dataSize = 0;
+			Socket.RecvFrom(Buffer, 16 * 4096, 0, &dataSize);
+			TrackUDPSequence(shard, Buffer, dataSize);
+			if (IsUDPEventPacket(shard, reinterpret_cast<const unsigned __int8*>(Buffer), dataSize))
 			{
-				headerbytes[i] = bytes[i];
+				AddUDPCount(shard.PacketCount, 1);
+				shard.PacketPoolEmptyDropCount.fetch_add(1, std::memory_order_relaxed);
 			}
-			auto pHeader = SRE3021PacketHeader(*headerbytes);
-			if (pHeader.PacketType != SRE3021PacketType::IMG_DATA)
+		}
+		else
+		{
+			int receivedCount = Socket.RecvBatch(slotBuffers, slotLength, heldSlotCount, dataSizes);
+			const long long receiveTime = SteadyClockNanoseconds();
+			if (receivedCount > 0)
 			{
-				return;
+				AddUDPCount(shard.RecvBatchSizeHistogram[receivedCount], 1);
+				shard.KernelDropCount.store(Socket.GetDropCount(), std::memory_order_relaxed);
 			}
-			SRE3021ImageData imageData;
-#if LITTLE_ENDIAN
-			unsigned __int8 catEByte[2]{ bytes[21], bytes[20] };
-			imageData.CathodeValue = static_cast<size_t>(*static_cast<unsigned __int16*>(static_cast<void*>(catEByte))) - CathodeValueBaseline;
-			unsigned __int8 catTByte[2]{ bytes[23], bytes[22] };
-			imageData.CathodeTiming = static_cast<size_t>(*static_cast<unsigned __int16*>(static_cast<void*>(catTByte))) - CathodeTimingBaseline;
-			int anodeE[11][11];
-			int anodeT[11][11];
-			int UnusableChannel1 = ASICChannelNumber[2][0];
-			int UnusableChannel2 = ASICChannelNumber[0][0];
-			int imgOrder = 0;
-			for (int Y = 0; Y < 11; ++Y)
+
+			bool isQueued = false;
+			int keptSlotCount = 0;
+			for (int i = 0; i < heldSlotCount; ++i)
 			{
-				for (int X = 0; X < 11; ++X)
+				if (i < receivedCount)
 				{
-					unsigned __int8 anodeEByte[2]{ bytes[31 + imgOrder], bytes[30 + imgOrder] };
-					unsigned __int8 anodeTByte[2]{ bytes[273 + imgOrder], bytes[272 + imgOrder] };
-					imageData.AnodeValue[X][Y] = *static_cast<unsigned __int16*>(static_cast<void*>(anodeEByte)) - AnodeValueBaseline[X][Y];
-					imageData.AnodeTiming[X][Y] = *static_cast<unsigned __int16*>(static_cast<void*>(anodeTByte)) - AnodeTimingBaseline[X][Y];
-					imgOrder += 2;
-
+					unsigned __int32 slotIndex = slotIndices[i];
+					if (HandleUDPDatagram(shard, slotIndex, dataSizes[i], receiveTime))
+					{
+						isQueued = true;
+					}
+					if (slotIndex == SRE3021_PACKET_SLOT_NONE)
+					{
+						continue;
+					}
+					slotIndices[i] = slotIndex;
+					slotBuffers[i] = reinterpret_cast<char*>(shard.PacketPool.Data(slotIndex));
 				}
+				slotIndices[keptSlotCount] = slotIndices[i];
+				slotBuffers[keptSlotCount] = slotBuffers[i];
+				++keptSlotCount;
 			}
-#endif
-#if BIG_ENDIAN
-			unsigned __int8 catEByte[2]{ bytes[20], bytes[21] };
-			imageData.CathodeValue = static_cast<int>(*static_cast<unsigned __int16*>(static_cast<void*>(catEByte))) - CathodeValueBaseline;
-			unsigned __int8 catTByte[2]{ bytes[22], bytes[23] };
-			imageData.CathodeTiming = static_cast<int>(*static_cast<unsigned __int16*>(static_cast<void*>(catTByte))) - CathodeTimingBaseline;
-			int anodeE[11][11];
-			int anodeT[11][11];
-			int UnusableChannel1 = ASICChannelNumber[2][0];
-			int UnusableChannel2 = ASICChannelNumber[0][0];
-			int imgOrder = 0;
-			for (int Y = 0; Y < 11; ++Y)
+			heldSlotCount = keptSlotCount;
+			if (isQueued)
 			{
-				for (int X = 0; X < 11; ++X)
-				{
-					unsigned __int8 anodeEByte[2]{ bytes[30 + imgOrder], bytes[31 + imgOrder] };
-					unsigned __int8 anodeTByte[2]{ bytes[272 + imgOrder], bytes[273 + imgOrder] };
-					imageData.AnodeValue[X][Y] = static_cast<int>(*static_cast<unsigned __int16*>(static_cast<void*>(anodeEByte))) - AnodeValueBaseline[X][Y];
-					imageData.AnodeTiming[X][Y] = static_cast<int>(*static_cast<unsigned __int16*>(static_cast<void*>(anodeTByte))) - AnodeTimingBaseline[X][Y];
-					imgOrder += 2;
-
-				}
+				RingUDPImageConsumers(shard);
 			}
-#endif
-			
-
-			(this->*UDPImageBufferRaiserFunc)(imageData);
 		}
 
-		if (bIslock)
+		if (!isUdpServerOpen)
 		{
-			mutexUDPImageBuffer.unlock();
+			break;
 		}
-		
 	}
+
+	delete[] Buffer;
 }
 
-void hurel::sre3021::SRE3021API::CloseUDPServer()
+bool hurel::sre3021::SRE3021API::ReceiveUDPWithIoUring(UDPReceiverShard& shard, UDPSocket& Socket)
 {
-	if (isUdpServerOpen)
+#if SRE3021_HAS_IO_URING
+	SRE3021IoUringReceiver receiver;
+	if (!receiver.Open(static_cast<int>(Socket.GetHandle()), shard.PacketPool))
 	{
-		isUdpServerOpen = false;
-		if (udpThread.joinable())
-		{
-			udpThread.join();
-		}				
-		if (udpRaiserThread.joinable())
-		{
-			udpRaiserThread.join();
-		}
+		return false;
 	}
-	
-	
-}
-
-void hurel::sre3021::SRE3021API::CheckBaseline()
-{
-	int numPulses = 5000;
-	WriteSysReg(SRE3021SysRegisterADDR::CFG_PHYSTRIG_EN, false);
-	printf("SRE3021API: Set HV as 0 for checking basline\n");
-	SetHighVoltage(0);
-
-	printf("SRE3021API: Configuring ASIC.\n");
-	ReadWriteASICReg(SRE3021ASICRegisterADDR::Test_on, false);
-	ReadWriteASICReg(SRE3021ASICRegisterADDR::Current_compensation_enable, true);
-
-	printf("SRE3021API: Configuring system.\n");
-	WriteSysReg(SRE3021SysRegisterADDR::CFG_FIXED_CH, 128); //This vale ensures that single channel readout is not envoked during baseline readout.
-	WriteSysReg(SRE3021SysRegisterADDR::CFG_HOLD_DLY, 1); //This is the minimum value for the peak-hold to pick up less noise.
-	WriteSysReg(SRE3021SysRegisterADDR::CFG_CALTRIG_EN, 1);
-
-	printf("SRE3021API: Configuring calibration pulse genenerator (CalGen).\n");
-	WriteSysReg(SRE3021SysRegisterADDR::CAL_PULSE_POLAR, 0);
-	WriteSysReg(SRE3021SysRegisterADDR::CAL_NUM_PULSE, numPulses);
-	WriteSysReg(SRE3021SysRegisterADDR::CAL_PULSE_LENGTH, 5);
-	WriteSysReg(SRE3021SysRegisterADDR::CAL_PULSE_INTERVAL, 40000);
-
-	printf("SRE3021API: Start pulse genenerator (CalGen).\n");
-
-	clock_t start, end;
-
-	SetImageProcessingFunc(&hurel::sre3021::SRE3021API::BaseLineEventCheck);
+	shard.ActiveReceiveBackend = SRE3021UDPReceiveBackend::IO_URING;
+	// SO_RXQ_OVFL reports drops in recvmsg control data, the multishot recv has none
+	shard.isKernelDropCountSupported = false;
 
-	WriteSysReg(SRE3021SysRegisterADDR::CAL_EXECUTE, 1);
-
-	start = clock();
-	mutexBaseLineImageEvents.lock();
-	int BaseLineEventsCount = BaseLineImageEvents.size(); 
-	mutexBaseLineImageEvents.unlock();
-	while (BaseLineEventsCount < numPulses)
+	SRE3021PacketSlot slots[SRE3021_UDP_RECV_BATCH_SIZE];
+	while (true)
 	{
-		end = clock();
+		int receivedCount = receiver.Receive(slots, SRE3021_UDP_RECV_BATCH_SIZE, SRE3021_UDP_RECEIVE_TIMEOUT_MS);
+		if (receivedCount > 0)
+		{
+			AddUDPCount(shard.RecvBatchSizeHistogram[receivedCount], 1);
+		}
 
-		if ((static_cast<float>(end - start)) / CLOCKS_PER_SEC > 5)
+		bool isQueued = false;
+		for (int i = 0; i < receivedCount; ++i)
 		{
-			mutexBaseLineImageEvents.lock();
-			BaseLineEventsCount = BaseLineImageEvents.size();
-			
-			printf("SRE3021API: BaseLineImageEvents Count is %d\n", static_cast<int>(BaseLineImageEvents.size()));
-			if (BaseLineEventsCount > numPulses * 0.999)
+			unsigned __int32 slotIndex = slots[i].Index;
+			if (HandleUDPDatagram(shard, slotIndex, static_cast<int>(slots[i].Length), slots[i].ReceiveTime))
 			{
-				mutexBaseLineImageEvents.unlock();
-				break;
+				isQueued = true;
 			}
-			else
+			if (slotIndex != SRE3021_PACKET_SLOT_NONE)
 			{
-				mutexBaseLineImageEvents.unlock();
-				printf("SRE3021API: Retart pulse genenerator (CalGen) [%d].\n", static_cast<int>(BaseLineImageEvents.size()));
-				WriteSysReg(SRE3021SysRegisterADDR::CAL_EXECUTE, 1);
-				start = clock();
-			}			
+				receiver.Recycle(slotIndex);
+			}
+		}
+		if (isQueued)
+		{
+			RingUDPImageConsumers(shard);
+		}
+
+		if (!isUdpServerOpen)
+		{
+			break;
 		}
-		
 	}
-	end = clock();
-	printf("SRE3021API: Baseline Cal Execute time is %.2f [s] %d #\n", static_cast<float>(end / CLOCKS_PER_SEC), static_cast<int>(BaseLineEventsCount));
-	SetImageProcessingFunc(nullptr);
+	return true;
+#else
+	return false;
+#endif
+}
 
-	size_t baselineSum[11][11];
-	size_t baselineTimingSum[11][11];
+bool hurel::sre3021::SRE3021API::ReceiveUDPWithPacketMmap(UDPReceiverShard& shard, UDPSocket& Socket)
+{
+#if SRE3021_HAS_PACKET_MMAP
+	// Shards share the capture through one fanout group named after the image port
+	const int fanoutGroupId = UDPShardCount > 1 ? SRE3021_UDP_IMAGE_PORT : -1;
+	if (!shard.PacketMmapReceiver.Open(UDPCaptureInterface, static_cast<unsigned short>(SRE3021_UDP_IMAGE_PORT), fanoutGroupId))
+	{
+		return false;
+	}
+	// The socket stays bound so the host does not answer every image datagram with ICMP port unreachable.
+	// Nothing reads it, keep its queue small.
+	Socket.SetReceiveBufferSize(0);
+	shard.isKernelDropCountSupported = true;
+	shard.ActiveReceiveBackend = SRE3021UDPReceiveBackend::PACKET_MMAP;
 
-	for (int i = 0; i < 11; ++i)
+	SRE3021PacketSlot slots[SRE3021_UDP_RECV_BATCH_SIZE];
+	size_t batchCount = 0;
+	while (true)
 	{
-		for (int j = 0; j < 11; ++j)
+		int receivedCount = shard.PacketMmapReceiver.Receive(slots, SRE3021_UDP_RECV_BATCH_SIZE, SRE3021_UDP_RECEIVE_TIMEOUT_MS);
+		if (receivedCount > 0)
 		{
-			baselineSum[i][j] = 0;
-			baselineTimingSum[i][j] = 0;
+			AddUDPCount(shard.RecvBatchSizeHistogram[receivedCount], 1);
 		}
-	}
-	size_t catbaslineSum = 0;
-	size_t catTimingbaselineSum = 0;
-	mutexBaseLineImageEvents.lock();
-	for(auto imageData : BaseLineImageEvents)
-	{
-		catbaslineSum += imageData.CathodeValue;
-		catTimingbaselineSum += imageData.CathodeTiming;
-		for (int i = 0; i < 11; ++i)
+		// PACKET_STATISTICS is a syscall, read it only now and then
+		if (receivedCount == 0 || ++batchCount % 256 == 0)
 		{
-			for (int j = 0; j < 11; ++j)
+			shard.KernelDropCount.store(shard.PacketMmapReceiver.GetDropCount(), std::memory_order_relaxed);
+		}
+
+		bool isQueued = false;
+		for (int i = 0; i < receivedCount; ++i)
+		{
+			unsigned __int32 slotIndex = slots[i].Index;
+			if (HandleUDPDatagram(shard, slotIndex, static_cast<int>(slots[i].Length), slots[i].ReceiveTime))
+			{
+				isQueued = true;
+			}
+			if (slotIndex != SRE3021_PACKET_SLOT_NONE)
 			{
-				baselineSum[i][j] += imageData.AnodeValue[i][j];
-				baselineTimingSum[i][j] += imageData.AnodeTiming[i][j];
+				shard.PacketMmapReceiver.Release(slotIndex);
 			}
 		}
-	}
-	CathodeValueBaseline = static_cast<size_t>(catbaslineSum / BaseLineImageEvents.size());
-	CathodeTimingBaseline = static_cast<size_t>(catTimingbaselineSum / BaseLineImageEvents.size());
-	for (int i = 0; i < 11; ++i)
-	{
-		for (int j = 0; j < 11; ++j)
+		if (isQueued)
 		{
-			AnodeValueBaseline[i][j] = static_cast<size_t>(baselineSum[i][j] / BaseLineImageEvents.size());
-			AnodeTimingBaseline[i][j] = static_cast<size_t>(baselineTimingSum[i][j] / BaseLineImageEvents.size());
+			RingUDPImageConsumers(shard);
 		}
-	}
-
-	BaseLineImageEvents.clear();
-	SetImageProcessingFunc(&hurel::sre3021::SRE3021API::BasicImageProcessingFunc);	
 
-	mutexBaseLineImageEvents.unlock();
-	return;
+		if (!isUdpServerOpen)
+		{
+			break;
+		}
+	}
+	// The ring is unmapped in CloseUDPServer, once the image processing thread is done with it
+	return true;
+#else
+	return false;
+#endif
 }
 
-int hurel::sre3021::SRE3021API::SetHighVoltage(int voltage, int step, int sleepTimeInMillisecond)
+const unsigned __int8* hurel::sre3021::SRE3021API::UDPSlotData(UDPReceiverShard& shard, unsigned __int32 slotIndex)
 {
-	int CurrentVoltage = static_cast<int>(ReadSysReg(SRE3021SysRegisterADDR::HV_DAC).Value);
-
-	if (CurrentVoltage > voltage)
+	if ((slotIndex & SRE3021_IMAGE_FRAME_SLOT_FLAG) != 0)
 	{
-		int setVoltage = CurrentVoltage;
-		while (voltage < static_cast<int>(ReadSysReg(SRE3021SysRegisterADDR::HV_DAC).Value))
-		{
-			if (voltage + step < CurrentVoltage)
-			{
-				setVoltage -= step;
-			}
-			else
-			{
-				setVoltage = voltage;
-			}
+		return shard.ImageFrame.Reassembler.Data(slotIndex & ~SRE3021_IMAGE_FRAME_SLOT_FLAG);
+	}
+	if (shard.ActiveReceiveBackend == SRE3021UDPReceiveBackend::PACKET_MMAP)
+	{
+		return shard.PacketMmapReceiver.Data(slotIndex);
+	}
+	return shard.PacketPool.Data(slotIndex);
+}
 
-			CurrentVoltage = static_cast<int>(WriteSysReg(SRE3021SysRegisterADDR::HV_DAC, setVoltage).Value);
-			if (CurrentVoltage % 200 == 0)
-			{
-				printf("SRE3021API: Voltage drop to %d V \n", CurrentVoltage);
-			}
-			this_thread::sleep_for(std::chrono::milliseconds(sleepTimeInMillisecond));
-		}
+void hurel::sre3021::SRE3021API::ReleaseUDPSlot(UDPReceiverShard& shard, unsigned __int32 slotIndex)
+{
+	if ((slotIndex & SRE3021_IMAGE_FRAME_SLOT_FLAG) != 0)
+	{
+		shard.ImageFrame.Reassembler.Release(slotIndex & ~SRE3021_IMAGE_FRAME_SLOT_FLAG);
+		return;
 	}
-	else
+	if (shard.ActiveReceiveBackend == SRE3021UDPReceiveBackend::PACKET_MMAP)
 	{
-		int setVoltage = CurrentVoltage;
-		while (voltage > static_cast<int>(ReadSysReg(SRE3021SysRegisterADDR::HV_DAC).Value))
-		{
-			if (voltage - step > CurrentVoltage)
+		shard.PacketMmapReceiver.Release(slotIndex);
+		return;
+	}
+	shard.PacketPool.Release(slotIndex);
+}
+
+void hurel::sre3021::SRE3021API::RingUDPImageConsumers(UDPReceiverShard& shard)
+{
+	if (shard.DecodeWorkerDoorbells.empty())
+	{
+		shard.ImageBufferDoorbell.Ring();
+		return;
+	}
+	for (auto& doorbell : shard.DecodeWorkerDoorbells)
+	{
+		doorbell->Ring();
+	}
+}
+
+bool hurel::sre3021::SRE3021API::IsUDPEventPacket(const UDPReceiverShard& shard, const unsigned __int8* data, int dataSize)
+{
+	if (shard.AcquisitionMode == SRE3021AcquisitionMode::MULTI_PULSE_HEIGHT)
+	{
+		return SRE3021HeaderCodec::IsValid(data, dataSize, SRE3021PacketType::MULTI_PULSE_HEIGHT_DATA)
+			&& dataSize >= SRE3021_PACKET_HEADER_LENGTH + SRE3021_MULTI_PULSE_HEIGHT_MIN_LENGTH;
+	}
+	if (shard.AcquisitionMode == SRE3021AcquisitionMode::WAVEFORM)
+	{
+		return SRE3021HeaderCodec::IsValid(data, dataSize, SRE3021PacketType::PIPELINE_SAMPLING_DATA)
+			&& dataSize == SRE3021_PACKET_HEADER_LENGTH + SRE3021_PIPELINE_SAMPLING_DATA_LENGTH;
+	}
+	if (shard.AcquisitionMode == SRE3021AcquisitionMode::TRIGGER_TIME)
+	{
+		return SRE3021HeaderCodec::IsValid(data, dataSize, SRE3021PacketType::TRIGGER_TIME_DATA)
+			&& dataSize > SRE3021_PACKET_HEADER_LENGTH && (dataSize - SRE3021_PACKET_HEADER_LENGTH) % SRE3021_TRIGGER_TIME_EVENT_LENGTH == 0;
+	}
+	if (shard.AcquisitionMode == SRE3021AcquisitionMode::COUNTING)
+	{
+		return SRE3021HeaderCodec::IsValid(data, dataSize, SRE3021PacketType::COUNTING_FRAME_DATA)
+			&& dataSize == SRE3021_PACKET_HEADER_LENGTH + SRE3021_COUNTING_FRAME_DATA_LENGTH;
+	}
+	if (shard.AcquisitionMode == SRE3021AcquisitionMode::IMAGE_FRAME)
+	{
+		return SRE3021HeaderCodec::IsValid(data, dataSize, SRE3021PacketType::IMG_DATA) && dataSize >= SRE3021_IMAGE_DATA_OFFSET;
+	}
+	if (shard.AcquisitionMode == SRE3021AcquisitionMode::SINGLE_CHANNEL)
+	{
+		return SRE3021HeaderCodec::IsValid(data, dataSize, SRE3021PacketType::PULSE_HEIGHT_DATA)
+			&& dataSize >= SRE3021_PACKET_HEADER_LENGTH + SRE3021_PULSE_HEIGHT_MIN_LENGTH;
+	}
+	return dataSize == SRE3021_IMAGE_PACKET_LENGTH;
+}
+
+// Returns true when an image packet was queued. slotIndex comes back as the slot the caller still owns and must give back,
+// which under DROP_OLDEST is the evicted one, or SRE3021_PACKET_SLOT_NONE.
+bool hurel::sre3021::SRE3021API::HandleUDPDatagram(UDPReceiverShard& shard, unsigned __int32& slotIndex, int dataSize, long long receiveTime)
+{
+	const unsigned __int8* data = UDPSlotData(shard, slotIndex);
+	TrackUDPSequence(shard, reinterpret_cast<const char*>(data), dataSize);
+	if (!IsUDPEventPacket(shard, data, dataSize))
+	{
+		return false;
+	}
+	// Unwrapped here, the only place that sees the packets of a shard in arrival order
+	SRE3021PacketSlot slot{ slotIndex, static_cast<unsigned __int32>(dataSize),
+		shard.TimestampUnwrapper.Unwrap(SRE3021HeaderCodec::DecodeSystemNumber(data), SRE3021HeaderCodec::DecodeTimestamp(data)), receiveTime };
+	if (shard.AcquisitionMode == SRE3021AcquisitionMode::WAVEFORM)
+	{
+		// The cathode channel carries the cell pointer of its readout, the anode channels sent after it use the same one
+		const unsigned __int8* channel = data + SRE3021_PACKET_HEADER_LENGTH + 4;
+		if ((channel[0] & 0x80) == 0)
+		{
+			shard.Waveform.ReadoutCellPointer = channel[1];
+		}
+		slot.CellPointer = shard.Waveform.ReadoutCellPointer;
+	}
+
+	AddUDPCount(shard.PacketCount, 1);
+	if (shard.AcquisitionMode == SRE3021AcquisitionMode::IMAGE_FRAME && SRE3021ImageFrameReassembler::DecodeDataPacketCount(data) > 1)
+	{
+		return QueueUDPImageFrame(shard, slot);
+	}
+	// The event count of a multi-event pulse-height packet is its first Packet Data byte
+	if (shard.AcquisitionMode == SRE3021AcquisitionMode::MULTI_PULSE_HEIGHT)
+	{
+		AddUDPCount(shard.EventCount, data[SRE3021_PACKET_HEADER_LENGTH]);
+	}
+	else if (shard.AcquisitionMode == SRE3021AcquisitionMode::TRIGGER_TIME)
+	{
+		AddUDPCount(shard.EventCount, (dataSize - SRE3021_PACKET_HEADER_LENGTH) / SRE3021_TRIGGER_TIME_EVENT_LENGTH);
+	}
+	else
+	{
+		AddUDPCount(shard.EventCount, 1);
+	}
+	if( shard.PacketCount.load(std::memory_order_relaxed) % 100000 == 0)
+	{
+		printf("UDP Packet Count %zu\n", GetUdpPacketCount());
+	}
+	if (shard.AcquisitionMode == SRE3021AcquisitionMode::COUNTING)
+	{
+		// A few hundred additions, cheaper here than a trip through the image buffer. The slot stays with the listener.
+		shard.Counting.Accumulator.Accumulate(data + SRE3021_PACKET_HEADER_LENGTH, dataSize - SRE3021_PACKET_HEADER_LENGTH);
+		return false;
+	}
+
+	return QueueUDPImagePacket(shard, slotIndex, slot);
+}
+
+// The packet of an image split over several packets is copied to a frame buffer and its slot stays with the listener.
+// Returns true when it completed the image and the frame was queued.
+bool hurel::sre3021::SRE3021API::QueueUDPImageFrame(UDPReceiverShard& shard, const SRE3021PacketSlot& packetSlot)
+{
+	unsigned __int32 frameIndex;
+	unsigned __int32 frameLength;
+	if (shard.ImageFrame.Reassembler.Add(UDPSlotData(shard, packetSlot.Index), static_cast<int>(packetSlot.Length), packetSlot.ReceiveTime,
+		frameIndex, frameLength) != SRE3021ImageFrameStatus::COMPLETE)
+	{
+		return false;
+	}
+	AddUDPCount(shard.EventCount, 1);
+	SRE3021PacketSlot slot{ SRE3021_IMAGE_FRAME_SLOT_FLAG | frameIndex, frameLength, packetSlot.Timestamp, packetSlot.ReceiveTime };
+	// Under DROP_OLDEST an evicted packet slot would have to go back to the pool from the listener, drop the frame instead
+	unsigned __int32 slotIndex = slot.Index;
+	if (shard.BackpressurePolicy == SRE3021UDPBackpressurePolicy::DROP_OLDEST ? shard.ImageBuffer.TryPush(slot) : QueueUDPImagePacket(shard, slotIndex, slot))
+	{
+		return true;
+	}
+	if (shard.BackpressurePolicy == SRE3021UDPBackpressurePolicy::DROP_OLDEST)
+	{
+		shard.ImageBufferDropCount.fetch_add(1, std::memory_order_relaxed);
+	}
+	shard.ImageFrame.Reassembler.Release(frameIndex);
+	return false;
+}
+
+bool hurel::sre3021::SRE3021API::QueueUDPImagePacket(UDPReceiverShard& shard, unsigned __int32& slotIndex, const SRE3021PacketSlot& slot)
+{
+	if (shard.ImageBuffer.TryPush(slot))
+	{
+		slotIndex = SRE3021_PACKET_SLOT_NONE;
+		return true;
+	}
+
+	// Image processing thread is behind
+	switch (shard.BackpressurePolicy)
+	{
+	case SRE3021UDPBackpressurePolicy::DROP_OLDEST:
+	{
+		SRE3021PacketSlot evicted;
+		bool isEvicted = false;
+		if (!shard.DecodeWorkerDoorbells.empty() && shard.DecodeOrdering == SRE3021UDPDecodeOrdering::ARRIVAL)
+		{
+			// The evicted event leaves a gap in the arrival order, mark it so the hand-over does not wait for it.
+			// Beyond the reorder window nothing is evicted and the new packet is dropped.
+			size_t evictedTicket;
+			isEvicted = shard.ImageBuffer.TryPop(evicted, evictedTicket, shard.DecodedEvents.WindowEnd());
+			if (isEvicted)
+			{
+				shard.DecodedEvents.Publish(evictedTicket, true);
+			}
+		}
+		else
+		{
+			isEvicted = shard.ImageBuffer.TryPop(evicted);
+		}
+		if (isEvicted)
+		{
+			shard.ImageBufferEvictCount.fetch_add(1, std::memory_order_relaxed);
+			if (shard.ImageBuffer.TryPush(slot))
+			{
+				slotIndex = evicted.Index;
+				return true;
+			}
+			// A consumer has not finished taking the cell the push needs, drop the new packet too
+			ReleaseUDPSlot(shard, evicted.Index);
+			break;
+		}
+		// Emptied by the image processing thread in the meantime
+		if (shard.ImageBuffer.TryPush(slot))
+		{
+			slotIndex = SRE3021_PACKET_SLOT_NONE;
+			return true;
+		}
+		break;
+	}
+	case SRE3021UDPBackpressurePolicy::BLOCK_RECEIVER:
+		shard.ReceiverBlockCount.fetch_add(1, std::memory_order_relaxed);
+		// Packets of this batch may not be announced yet
+		RingUDPImageConsumers(shard);
+		while (isUdpServerOpen)
+		{
+			shard.ImageBufferSpaceDoorbell.Wait([&shard] { return !shard.ImageBuffer.Full(); }, std::chrono::milliseconds(SRE3021_UDP_RAISER_PARK_TIMEOUT_MS));
+			if (shard.ImageBuffer.TryPush(slot))
+			{
+				slotIndex = SRE3021_PACKET_SLOT_NONE;
+				return true;
+			}
+		}
+		break;
+	default:
+		break;
+	}
+	shard.ImageBufferDropCount.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+void hurel::sre3021::SRE3021API::CheckUDPImageBufferWatermark(UDPReceiverShard& shard)
+{
+	const size_t occupancy = shard.ImageBuffer.Size();
+	if (shard.isAboveWatermark ? occupancy > shard.LowWatermark : occupancy < shard.HighWatermark)
+	{
+		return;
+	}
+	shard.isAboveWatermark = !shard.isAboveWatermark;
+
+	mutexUDPImageBufferWatermarkFunc.lock();
+	void (hurel::sre3021::SRE3021API::* watermarkFunc)(int, size_t, bool) = UDPImageBufferWatermarkFunc;
+	mutexUDPImageBufferWatermarkFunc.unlock();
+	if (watermarkFunc != nullptr)
+	{
+		(this->*watermarkFunc)(shard.Index, occupancy, shard.isAboveWatermark);
+	}
+}
+
+void hurel::sre3021::SRE3021API::TrackUDPSequence(UDPReceiverShard& shard, const char* data, int dataSize)
+{
+	if (dataSize < SRE3021_PACKET_HEADER_LENGTH)
+	{
+		return;
+	}
+	const unsigned __int8* header = reinterpret_cast<const unsigned __int8*>(data);
+	shard.SequenceTracker.Track(SRE3021PacketHeader::DecodeSystemNumber(header), SRE3021PacketHeader::DecodePacketCount(header));
+}
+
+void hurel::sre3021::SRE3021API::UDPImageBufferRaiser(UDPReceiverShard& shard)
+{
+	while (true)
+	{
+		if (!isUdpServerOpen)
+		{
+			break;
+		}
+		shard.ImageBufferDoorbell.Wait([&shard] { return !shard.ImageBuffer.Empty(); }, std::chrono::milliseconds(SRE3021_UDP_RAISER_PARK_TIMEOUT_MS));
+
+		UDPDecodePass pass(&UDPImageEventBus, false, shard.PulseHeight.Arena);
+		if (!BeginUDPDecodePass(pass))
+		{
+			// Keep packets queued until an image processing function is set
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+		SRE3021PacketSlot slot;
+		while (shard.ImageBuffer.TryPop(slot))
+		{
+			if (shard.BackpressurePolicy == SRE3021UDPBackpressurePolicy::BLOCK_RECEIVER)
+			{
+				shard.ImageBufferSpaceDoorbell.Ring();
+			}
+			CheckUDPImageBufferWatermark(shard);
+			HandleUDPPacket(shard, pass, slot, 0);
+		}
+		EndUDPDecodePass(shard, pass);
+	}
+}
+
+void hurel::sre3021::SRE3021API::UDPDecodeWorker(UDPReceiverShard& shard, int workerIndex)
+{
+	SRE3021Doorbell& doorbell = *shard.DecodeWorkerDoorbells[workerIndex];
+	const bool isReordered = shard.DecodeOrdering == SRE3021UDPDecodeOrdering::ARRIVAL;
+	// Pulse-height packets decoded by this worker when events are not handed over in arrival order
+	SRE3021DecodeArena pulseHeightArena;
+	if (shard.AcquisitionMode == SRE3021AcquisitionMode::MULTI_PULSE_HEIGHT && !isReordered)
+	{
+		pulseHeightArena.Allocate(PulseHeightArenaSize);
+	}
+	while (true)
+	{
+		if (!isUdpServerOpen)
+		{
+			break;
+		}
+		doorbell.Wait([&shard] { return !shard.ImageBuffer.Empty(); }, std::chrono::milliseconds(SRE3021_UDP_RAISER_PARK_TIMEOUT_MS));
+		if (isReordered)
+		{
+			// Events may only be waiting for an evicted packet
+			DrainUDPDecodedEvents(shard);
+		}
+
+		UDPDecodePass pass(&UDPImageEventBus, isReordered, pulseHeightArena);
+		if (!BeginUDPDecodePass(pass))
+		{
+			// Keep packets queued until an image processing function is set
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+		SRE3021PacketSlot slot;
+		size_t ticket;
+		while (shard.ImageBuffer.TryPop(slot, ticket, isReordered ? shard.DecodedEvents.WindowEnd() : static_cast<size_t>(-1)))
+		{
+			if (shard.BackpressurePolicy == SRE3021UDPBackpressurePolicy::BLOCK_RECEIVER)
+			{
+				shard.ImageBufferSpaceDoorbell.Ring();
+			}
+			if (workerIndex == 0)
+			{
+				CheckUDPImageBufferWatermark(shard);
+			}
+			HandleUDPPacket(shard, pass, slot, ticket);
+		}
+		EndUDPDecodePass(shard, pass);
+		if (isReordered && !shard.ImageBuffer.Empty())
+		{
+			// Reorder window is full, another worker still decodes the oldest event
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool hurel::sre3021::SRE3021API::BeginUDPDecodePass(UDPDecodePass& pass)
+{
+	mutexUDPImageBufferRaiserFunc.lock();
+	pass.RaiserFunc = UDPImageBufferRaiserFunc;
+	pass.ViewFunc = UDPImageBufferViewFunc;
+	pass.CompactFunc = UDPImageBufferCompactFunc;
+	pass.WaveformFunc = UDPImageBufferWaveformFunc;
+	pass.CoincidenceFunc = UDPImageBufferCoincidenceFunc;
+	pass.FrameFunc = UDPImageBufferFrameFunc;
+	pass.ChannelEventFunc = UDPImageBufferChannelEventFunc;
+	mutexUDPImageBufferRaiserFunc.unlock();
+	pass.HasImageSubscribers = UDPImageEventBus.HasSubscribers();
+	return pass.RaiserFunc != nullptr || pass.ViewFunc != nullptr || pass.CompactFunc != nullptr || pass.WaveformFunc != nullptr
+		|| pass.CoincidenceFunc != nullptr || pass.FrameFunc != nullptr || pass.ChannelEventFunc != nullptr || pass.HasImageSubscribers;
+}
+
+void hurel::sre3021::SRE3021API::EndUDPDecodePass(UDPReceiverShard& shard, UDPDecodePass& pass)
+{
+	FlushUDPWaveforms(shard, pass);
+	pass.ImageEvents.Flush();
+}
+
+void hurel::sre3021::SRE3021API::FlushUDPWaveforms(UDPReceiverShard& shard, UDPDecodePass& pass)
+{
+	if (pass.WaveformSlotCount == 0)
+	{
+		return;
+	}
+	RaiseUDPWaveforms(shard, pass.WaveformSlots, pass.WaveformSlotCount, pass.WaveformFunc, pass.IsReordered ? pass.WaveformTickets : nullptr);
+	pass.WaveformSlotCount = 0;
+	if (pass.IsReordered)
+	{
+		DrainUDPDecodedEvents(shard);
+	}
+}
+
+void hurel::sre3021::SRE3021API::DrainUDPDecodedEvents(UDPReceiverShard& shard)
+{
+	shard.DecodedEvents.Drain([this, &shard](const UDPDecodedEvent& decodedEvent) { DeliverUDPDecodedEvent(shard, decodedEvent); },
+		[&shard] { shard.DeliveredImageEvents.Flush(); });
+}
+
+void hurel::sre3021::SRE3021API::HandleUDPPacket(UDPReceiverShard& shard, UDPDecodePass& pass, const SRE3021PacketSlot& slot, size_t ticket)
+{
+	const unsigned __int8* bytes = UDPSlotData(shard, slot.Index);
+	switch (SRE3021HeaderCodec::DecodePacketType(bytes))
+	{
+	case SRE3021PacketType::PIPELINE_SAMPLING_DATA:
+		pass.WaveformSlots[pass.WaveformSlotCount] = slot;
+		pass.WaveformTickets[pass.WaveformSlotCount++] = ticket;
+		if (pass.WaveformSlotCount == SRE3021_WAVEFORM_LANE_COUNT)
+		{
+			FlushUDPWaveforms(shard, pass);
+		}
+		return;
+	case SRE3021PacketType::TRIGGER_TIME_DATA:
+		if (pass.IsReordered)
+		{
+			// The coincidence finder drops records older than the ones it merged, the worker handing the packet over adds it
+			UDPDecodedEvent& decodedEvent = shard.DecodedEvents.Slot(ticket);
+			decodedEvent.Kind = UDPDecodedEventKind::TRIGGER_TIME;
+			decodedEvent.CoincidenceFunc = pass.CoincidenceFunc;
+			decodedEvent.PacketSlot = slot;
+			shard.DecodedEvents.Publish(ticket);
+			DrainUDPDecodedEvents(shard);
+			return;
+		}
+		RaiseUDPCoincidences(shard, slot, pass.CoincidenceFunc);
+		ReleaseUDPSlot(shard, slot.Index);
+		return;
+	case SRE3021PacketType::MULTI_PULSE_HEIGHT_DATA:
+		if (pass.IsReordered)
+		{
+			// Events of the packet are decoded by the worker that hands them over, the slot is released there
+			UDPDecodedEvent& decodedEvent = shard.DecodedEvents.Slot(ticket);
+			decodedEvent.Kind = UDPDecodedEventKind::PULSE_HEIGHT;
+			decodedEvent.RaiserFunc = pass.RaiserFunc;
+			decodedEvent.CompactFunc = pass.CompactFunc;
+			decodedEvent.IsImageEventPublished = pass.HasImageSubscribers;
+			decodedEvent.PacketSlot = slot;
+			shard.DecodedEvents.Publish(ticket);
+			DrainUDPDecodedEvents(shard);
+			return;
+		}
+		RaiseUDPPulseHeightEvents(bytes, slot, pass.PulseHeightArena, pass.RaiserFunc, pass.CompactFunc, pass.HasImageSubscribers ? &pass.ImageEvents : nullptr);
+		ReleaseUDPSlot(shard, slot.Index);
+		return;
+	case SRE3021PacketType::PULSE_HEIGHT_DATA:
+	{
+		if (pass.IsReordered)
+		{
+			UDPDecodedEvent& decodedEvent = shard.DecodedEvents.Slot(ticket);
+			decodedEvent.Kind = UDPDecodedEventKind::CHANNEL_EVENT;
+			decodedEvent.PayloadIndex = shard.DecodedEvents.SlotIndex(ticket);
+			decodedEvent.ChannelEventFunc = pass.ChannelEventFunc;
+			const bool isDecoded = pass.ChannelEventFunc != nullptr && HasUDPDecodedPayload(shard, UDPDecodedEventKind::CHANNEL_EVENT)
+				&& DecodeUDPChannelEvent(shard, slot, shard.SingleChannel.DecodedChannelEvents[decodedEvent.PayloadIndex]);
+			ReleaseUDPSlot(shard, slot.Index);
+			shard.DecodedEvents.Publish(ticket, !isDecoded);
+			DrainUDPDecodedEvents(shard);
+			return;
+		}
+		SRE3021ChannelEvent channelEvent;
+		const bool isDecoded = pass.ChannelEventFunc != nullptr && DecodeUDPChannelEvent(shard, slot, channelEvent);
+		ReleaseUDPSlot(shard, slot.Index);
+		if (isDecoded)
+		{
+			(this->*pass.ChannelEventFunc)(channelEvent);
+		}
+		return;
+	}
+	case SRE3021PacketType::IMG_DATA:
+		if (slot.Length == SRE3021_IMAGE_PACKET_LENGTH)
+		{
+			HandleUDPImagePacket(shard, pass, slot, ticket);
+			return;
+		}
+		// Image frames are not held back for the arrival order
+		RaiseUDPImageFrame(shard, slot, pass.FrameFunc);
+		ReleaseUDPSlot(shard, slot.Index);
+		break;
+	default:
+		ReleaseUDPSlot(shard, slot.Index);
+		break;
+	}
+	// Nothing of the packet is handed over in arrival order, its ticket is a gap
+	if (pass.IsReordered)
+	{
+		shard.DecodedEvents.Publish(ticket, true);
+		DrainUDPDecodedEvents(shard);
+	}
+}
+
+void hurel::sre3021::SRE3021API::HandleUDPImagePacket(UDPReceiverShard& shard, UDPDecodePass& pass, const SRE3021PacketSlot& slot, size_t ticket)
+{
+	const unsigned __int8* bytes = UDPSlotData(shard, slot.Index);
+	if (pass.ViewFunc != nullptr)
+	{
+		SRE3021ImageView imageView(bytes, AnodeValueBaseline, AnodeTimingBaseline, CathodeValueBaseline, CathodeTimingBaseline, slot.Timestamp, slot.ReceiveTime);
+		(this->*pass.ViewFunc)(imageView);
+	}
+
+	if (pass.IsReordered)
+	{
+		UDPDecodedEvent& decodedEvent = shard.DecodedEvents.Slot(ticket);
+		decodedEvent.Kind = UDPDecodedEventKind::IMAGE;
+		decodedEvent.PayloadIndex = shard.DecodedEvents.SlotIndex(ticket);
+		decodedEvent.RaiserFunc = pass.RaiserFunc;
+		decodedEvent.CompactFunc = pass.CompactFunc;
+		decodedEvent.IsImageEventPublished = pass.HasImageSubscribers;
+		const bool isDecoded = (pass.RaiserFunc != nullptr || pass.CompactFunc != nullptr || pass.HasImageSubscribers)
+			&& HasUDPDecodedPayload(shard, UDPDecodedEventKind::IMAGE);
+		if (isDecoded && pass.CompactFunc != nullptr)
+		{
+			SRE3021CompactImageData& compactImageData = shard.Image.DecodedCompactImageData[decodedEvent.PayloadIndex];
+			UDPImageDecoder.DecodeCompact(bytes, compactImageData);
+			compactImageData.Timestamp = slot.Timestamp;
+			compactImageData.ReceiveTime = slot.ReceiveTime;
+		}
+		if (isDecoded && (pass.RaiserFunc != nullptr || pass.HasImageSubscribers))
+		{
+			SRE3021ImageData& imageData = shard.Image.DecodedImageData[decodedEvent.PayloadIndex];
+			UDPImageDecoder.Decode(bytes, imageData);
+			imageData.Timestamp = slot.Timestamp;
+			imageData.ReceiveTime = slot.ReceiveTime;
+		}
+		ReleaseUDPSlot(shard, slot.Index);
+		shard.DecodedEvents.Publish(ticket, !isDecoded);
+		DrainUDPDecodedEvents(shard);
+		return;
+	}
+
+	if (pass.CompactFunc != nullptr)
+	{
+		SRE3021CompactImageData compactImageData;
+		UDPImageDecoder.DecodeCompact(bytes, compactImageData);
+		compactImageData.Timestamp = slot.Timestamp;
+		compactImageData.ReceiveTime = slot.ReceiveTime;
+		(this->*pass.CompactFunc)(compactImageData);
+	}
+	if (pass.RaiserFunc == nullptr && !pass.HasImageSubscribers)
+	{
+		ReleaseUDPSlot(shard, slot.Index);
+		return;
+	}
+	SRE3021ImageData imageData;
+	UDPImageDecoder.Decode(bytes, imageData);
+	imageData.Timestamp = slot.Timestamp;
+	imageData.ReceiveTime = slot.ReceiveTime;
+	ReleaseUDPSlot(shard, slot.Index);
+
+	if (pass.HasImageSubscribers)
+	{
+		pass.ImageEvents.Add(imageData);
+	}
+	if (pass.RaiserFunc != nullptr)
+	{
+		(this->*pass.RaiserFunc)(imageData);
+	}
+}
+
+void hurel::sre3021::SRE3021API::DeliverUDPDecodedEvent(UDPReceiverShard& shard, const UDPDecodedEvent& decodedEvent)
+{
+	switch (decodedEvent.Kind)
+	{
+	case UDPDecodedEventKind::PULSE_HEIGHT:
+		// Only one worker at a time hands events over, so the shard arena is free
+		RaiseUDPPulseHeightEvents(UDPSlotData(shard, decodedEvent.PacketSlot.Index), decodedEvent.PacketSlot, shard.PulseHeight.Arena,
+			decodedEvent.RaiserFunc, decodedEvent.CompactFunc, decodedEvent.IsImageEventPublished ? &shard.DeliveredImageEvents : nullptr);
+		ReleaseUDPSlot(shard, decodedEvent.PacketSlot.Index);
+		break;
+	case UDPDecodedEventKind::TRIGGER_TIME:
+		RaiseUDPCoincidences(shard, decodedEvent.PacketSlot, decodedEvent.CoincidenceFunc);
+		ReleaseUDPSlot(shard, decodedEvent.PacketSlot.Index);
+		break;
+	case UDPDecodedEventKind::WAVEFORM:
+		(this->*decodedEvent.WaveformFunc)(shard.Waveform.DecodedWaveforms[decodedEvent.PayloadIndex], shard.Waveform.DecodedResults[decodedEvent.PayloadIndex]);
+		break;
+	case UDPDecodedEventKind::CHANNEL_EVENT:
+		(this->*decodedEvent.ChannelEventFunc)(shard.SingleChannel.DecodedChannelEvents[decodedEvent.PayloadIndex]);
+		break;
+	case UDPDecodedEventKind::IMAGE:
+		if (decodedEvent.CompactFunc != nullptr)
+		{
+			(this->*decodedEvent.CompactFunc)(shard.Image.DecodedCompactImageData[decodedEvent.PayloadIndex]);
+		}
+		if (decodedEvent.IsImageEventPublished)
+		{
+			shard.DeliveredImageEvents.Add(shard.Image.DecodedImageData[decodedEvent.PayloadIndex]);
+		}
+		if (decodedEvent.RaiserFunc != nullptr)
+		{
+			(this->*decodedEvent.RaiserFunc)(shard.Image.DecodedImageData[decodedEvent.PayloadIndex]);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+bool hurel::sre3021::SRE3021API::HasUDPDecodedPayload(const UDPReceiverShard& shard, UDPDecodedEventKind kind)
+{
+	switch (kind)
+	{
+	case UDPDecodedEventKind::IMAGE:
+		return !shard.Image.DecodedImageData.empty();
+	case UDPDecodedEventKind::WAVEFORM:
+		return !shard.Waveform.DecodedWaveforms.empty();
+	case UDPDecodedEventKind::CHANNEL_EVENT:
+		return !shard.SingleChannel.DecodedChannelEvents.empty();
+	default:
+		// A pulse-height packet keeps its slot
+		return true;
+	}
+}
+
+void hurel::sre3021::SRE3021API::RaiseUDPPulseHeightEvents(const unsigned __int8* bytes, const SRE3021PacketSlot& slot, SRE3021DecodeArena& arena,
+	void (hurel::sre3021::SRE3021API::* raiserFunc)(SRE3021ImageData), void (hurel::sre3021::SRE3021API::* compactFunc)(const SRE3021CompactImageData&),
+	SRE3021EventBus<SRE3021ImageData>::Publisher* imageEvents)
+{
+	if (raiserFunc == nullptr && compactFunc == nullptr && imageEvents == nullptr)
+	{
+		return;
+	}
+	arena.Reset();
+	SRE3021MultiPulseHeightData pulseHeightData;
+	if (SRE3021PulseHeightDecoder::DecodeMultiPulseHeight(bytes + SRE3021_PACKET_HEADER_LENGTH, static_cast<int>(slot.Length) - SRE3021_PACKET_HEADER_LENGTH,
+		pulseHeightData, arena) != SRE3021PacketDecodeStatus::SUCCESS)
+	{
+		return;
+	}
+	for (int i = 0; i < pulseHeightData.EventCount; ++i)
+	{
+		const SRE3021PulseHeightEvent& event = pulseHeightData.Events[i];
+		// Event time stamps lie close to the packet time stamp, extend them from its unwrapped value
+		const unsigned long long timestamp = slot.Timestamp + static_cast<long long>(static_cast<__int32>(event.Timestamp - static_cast<unsigned __int32>(slot.Timestamp)));
+		if (compactFunc != nullptr)
+		{
+			SRE3021CompactImageData compactImageData;
+			UDPImageDecoder.DecodePulseHeightEventCompact(event, pulseHeightData.SampleCount, compactImageData);
+			compactImageData.Timestamp = timestamp;
+			compactImageData.ReceiveTime = slot.ReceiveTime;
+			(this->*compactFunc)(compactImageData);
+		}
+		if (raiserFunc != nullptr || imageEvents != nullptr)
+		{
+			SRE3021ImageData imageData;
+			UDPImageDecoder.DecodePulseHeightEvent(event, pulseHeightData.SampleCount, imageData);
+			imageData.Timestamp = timestamp;
+			imageData.ReceiveTime = slot.ReceiveTime;
+			if (imageEvents != nullptr)
+			{
+				imageEvents->Add(imageData);
+			}
+			if (raiserFunc != nullptr)
+			{
+				(this->*raiserFunc)(imageData);
+			}
+		}
+	}
+}
+
+bool hurel::sre3021::SRE3021API::DecodeUDPWaveform(UDPReceiverShard& shard, const SRE3021PacketSlot& slot, SRE3021WaveformData& outWaveform)
+{
+	if (SRE3021WaveformProcessor::Decode(UDPSlotData(shard, slot.Index) + SRE3021_PACKET_HEADER_LENGTH, static_cast<int>(slot.Length) - SRE3021_PACKET_HEADER_LENGTH,
+		outWaveform, slot.CellPointer) != SRE3021PacketDecodeStatus::SUCCESS)
+	{
+		return false;
+	}
+	outWaveform.Timestamp = slot.Timestamp;
+	outWaveform.ReceiveTime = slot.ReceiveTime;
+	return true;
+}
+
+// Filters at most SRE3021_WAVEFORM_LANE_COUNT pipeline sampling packets together and gives their slots back.
+// With tickets the waveforms are handed over in arrival order: each goes to the reorder buffer under the ticket of its packet
+// and is published once the whole batch is filtered.
+void hurel::sre3021::SRE3021API::RaiseUDPWaveforms(UDPReceiverShard& shard, const SRE3021PacketSlot* slots, size_t slotCount,
+	void (hurel::sre3021::SRE3021API::* waveformFunc)(const SRE3021WaveformData&, const SRE3021WaveformResult&), const size_t* tickets)
+{
+	SRE3021WaveformData waveforms[SRE3021_WAVEFORM_LANE_COUNT];
+	SRE3021WaveformResult results[SRE3021_WAVEFORM_LANE_COUNT];
+	size_t waveformTickets[SRE3021_WAVEFORM_LANE_COUNT];
+	size_t waveformCount = 0;
+	for (size_t i = 0; i < slotCount; ++i)
+	{
+		if (waveformFunc != nullptr && (tickets == nullptr || HasUDPDecodedPayload(shard, UDPDecodedEventKind::WAVEFORM))
+			&& DecodeUDPWaveform(shard, slots[i], waveforms[waveformCount]))
+		{
+			waveformTickets[waveformCount++] = tickets != nullptr ? tickets[i] : 0;
+		}
+		else if (tickets != nullptr)
+		{
+			shard.DecodedEvents.Publish(tickets[i], true);
+		}
+		ReleaseUDPSlot(shard, slots[i].Index);
+	}
+	if (waveformCount == 0)
+	{
+		return;
+	}
+	UDPWaveformProcessor.Process(waveforms, waveformCount, results);
+	for (size_t i = 0; i < waveformCount; ++i)
+	{
+		if (tickets == nullptr)
+		{
+			(this->*waveformFunc)(waveforms[i], results[i]);
+			continue;
+		}
+		UDPDecodedEvent& decodedEvent = shard.DecodedEvents.Slot(waveformTickets[i]);
+		decodedEvent.Kind = UDPDecodedEventKind::WAVEFORM;
+		decodedEvent.PayloadIndex = shard.DecodedEvents.SlotIndex(waveformTickets[i]);
+		decodedEvent.WaveformFunc = waveformFunc;
+		shard.Waveform.DecodedWaveforms[decodedEvent.PayloadIndex] = waveforms[i];
+		shard.Waveform.DecodedResults[decodedEvent.PayloadIndex] = results[i];
+	}
+	if (tickets == nullptr)
+	{
+		return;
+	}
+	for (size_t i = 0; i < waveformCount; ++i)
+	{
+		shard.DecodedEvents.Publish(waveformTickets[i]);
+	}
+}
+
+void hurel::sre3021::SRE3021API::RaiseUDPCoincidences(UDPReceiverShard& shard, const SRE3021PacketSlot& slot,
+	void (hurel::sre3021::SRE3021API::* coincidenceFunc)(const SRE3021Coincidence&))
+{
+	SRE3021TriggerTimeEvent events[(SRE3021_UDP_TRIGGER_TIME_SLOT_SIZE - SRE3021_PACKET_HEADER_LENGTH) / SRE3021_TRIGGER_TIME_EVENT_LENGTH];
+	SRE3021TriggerTimeData triggerTimeData;
+	if (SRE3021PulseHeightDecoder::DecodeTriggerTime(UDPSlotData(shard, slot.Index) + SRE3021_PACKET_HEADER_LENGTH, static_cast<int>(slot.Length) - SRE3021_PACKET_HEADER_LENGTH,
+		triggerTimeData, events, sizeof(events) / sizeof(events[0])) != SRE3021PacketDecodeStatus::SUCCESS)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(shard.TriggerTime.mutexCoincidenceFinder);
+	for (int i = 0; i < triggerTimeData.EventCount; ++i)
+	{
+		const SRE3021TriggerTimeEvent& event = triggerTimeData.Events[i];
+		// Trigger time stamps lie close to the packet time stamp, extend them from its unwrapped value
+		const unsigned long long timestamp = slot.Timestamp + static_cast<long long>(static_cast<__int32>(event.Timestamp - static_cast<unsigned __int32>(slot.Timestamp)));
+		shard.TriggerTime.CoincidenceFinder.Add(SRE3021TriggerRecord{ timestamp, event.SourceId, event.ChannelId });
+	}
+	shard.TriggerTime.Coincidences.clear();
+	shard.TriggerTime.CoincidenceFinder.FindCoincidences(shard.TriggerTime.Coincidences);
+	if (coincidenceFunc == nullptr)
+	{
+		return;
+	}
+	for (const SRE3021Coincidence& coincidence : shard.TriggerTime.Coincidences)
+	{
+		(this->*coincidenceFunc)(coincidence);
+	}
+}
+
+void hurel::sre3021::SRE3021API::RaiseUDPImageFrame(UDPReceiverShard& shard, const SRE3021PacketSlot& slot,
+	void (hurel::sre3021::SRE3021API::* frameFunc)(const SRE3021ImageFrame&))
+{
+	SRE3021ImageFrame frame;
+	if (frameFunc == nullptr
+		|| SRE3021ImageFrameReassembler::DecodeImageFrame(UDPSlotData(shard, slot.Index), static_cast<int>(slot.Length), frame) != SRE3021PacketDecodeStatus::SUCCESS)
+	{
+		return;
+	}
+	frame.Timestamp = slot.Timestamp;
+	frame.ReceiveTime = slot.ReceiveTime;
+	(this->*frameFunc)(frame);
+}
+
+bool hurel::sre3021::SRE3021API::DecodeUDPChannelEvent(UDPReceiverShard& shard, const SRE3021PacketSlot& slot, SRE3021ChannelEvent& outEvent)
+{
+	unsigned __int16 samples[(SRE3021_UDP_SINGLE_CHANNEL_SLOT_SIZE - SRE3021_PACKET_HEADER_LENGTH - SRE3021_PULSE_HEIGHT_FIELDS_LENGTH) / 2];
+	SRE3021PulseHeightData pulseHeightData;
+	if (SRE3021PulseHeightDecoder::DecodePulseHeight(UDPSlotData(shard, slot.Index) + SRE3021_PACKET_HEADER_LENGTH,
+		static_cast<int>(slot.Length) - SRE3021_PACKET_HEADER_LENGTH, pulseHeightData, samples, sizeof(samples) / sizeof(samples[0])) != SRE3021PacketDecodeStatus::SUCCESS
+		|| pulseHeightData.TriggerType != SRE3021TriggerType::SINGLE_CHANNEL_READOUT_MODE)
+	{
+		return false;
+	}
+	UDPImageDecoder.DecodeChannelEvent(pulseHeightData, outEvent);
+	outEvent.Timestamp = slot.Timestamp;
+	outEvent.ReceiveTime = slot.ReceiveTime;
+	return true;
+}
+
+void hurel::sre3021::SRE3021API::CloseUDPServer()
+{
+	if (isUdpServerOpen)
+	{
+		isUdpServerOpen = false;
+		for (auto& shard : UDPShards)
+		{
+			shard->ImageBufferDoorbell.Ring();
+			shard->ImageBufferSpaceDoorbell.Ring();
+			for (auto& doorbell : shard->DecodeWorkerDoorbells)
+			{
+				doorbell->Ring();
+			}
+		}
+		for (auto& shard : UDPShards)
+		{
+			if (shard->udpThread.joinable())
+			{
+				shard->udpThread.join();
+			}
+			if (shard->udpRaiserThread.joinable())
+			{
+				shard->udpRaiserThread.join();
+			}
+			for (auto& workerThread : shard->udpDecodeWorkerThreads)
+			{
+				workerThread.join();
+			}
+			shard->PacketMmapReceiver.Close();
+		}
+	}
+	
+	
+}
+
+void hurel::sre3021::SRE3021API::CheckBaseline()
+{
+	int numPulses = 5000;
+	WriteSysReg(SRE3021SysRegisterADDR::CFG_PHYSTRIG_EN, false);
+	printf("SRE3021API: Set HV as 0 for checking basline\n");
+	SetHighVoltage(0);
+
+	printf("SRE3021API: Configuring ASIC.\n");
+	ReadWriteASICReg(SRE3021ASICRegisterADDR::Test_on, false);
+	ReadWriteASICReg(SRE3021ASICRegisterADDR::Current_compensation_enable, true);
+
+	printf("SRE3021API: Configuring system.\n");
+	WriteSysReg(SRE3021SysRegisterADDR::CFG_FIXED_CH, 128); //This vale ensures that single channel readout is not envoked during baseline readout.
+	WriteSysReg(SRE3021SysRegisterADDR::CFG_HOLD_DLY, 1); //This is the minimum value for the peak-hold to pick up less noise.
+	WriteSysReg(SRE3021SysRegisterADDR::CFG_CALTRIG_EN, 1);
+
+	printf("SRE3021API: Configuring calibration pulse genenerator (CalGen).\n");
+	WriteSysReg(SRE3021SysRegisterADDR::CAL_PULSE_POLAR, 0);
+	WriteSysReg(SRE3021SysRegisterADDR::CAL_NUM_PULSE, numPulses);
+	WriteSysReg(SRE3021SysRegisterADDR::CAL_PULSE_LENGTH, 5);
+	WriteSysReg(SRE3021SysRegisterADDR::CAL_PULSE_INTERVAL, 40000);
+
+	printf("SRE3021API: Start pulse genenerator (CalGen).\n");
+
+	clock_t start, end;
+
+	SetImageProcessingFunc(nullptr);
+	SetCompactImageProcessingFunc(&hurel::sre3021::SRE3021API::BaseLineEventCheck);
+
+	WriteSysReg(SRE3021SysRegisterADDR::CAL_EXECUTE, 1);
+
+	start = clock();
+	mutexBaseLineImageEvents.lock();
+	int BaseLineEventsCount = BaseLineImageEvents.size(); 
+	mutexBaseLineImageEvents.unlock();
+	while (BaseLineEventsCount < numPulses)
+	{
+		end = clock();
+
+		if ((static_cast<float>(end - start)) / CLOCKS_PER_SEC > 5)
+		{
+			mutexBaseLineImageEvents.lock();
+			BaseLineEventsCount = BaseLineImageEvents.size();
+			
+			printf("SRE3021API: BaseLineImageEvents Count is %d\n", static_cast<int>(BaseLineImageEvents.size()));
+			if (BaseLineEventsCount > numPulses * 0.999)
+			{
+				mutexBaseLineImageEvents.unlock();
+				break;
+			}
+			else
+			{
+				mutexBaseLineImageEvents.unlock();
+				printf("SRE3021API: Retart pulse genenerator (CalGen) [%d].\n", static_cast<int>(BaseLineImageEvents.size()));
+				WriteSysReg(SRE3021SysRegisterADDR::CAL_EXECUTE, 1);
+				start = clock();
+			}			
+		}
+		
+	}
+	end = clock();
+	printf("SRE3021API: Baseline Cal Execute time is %.2f [s] %d #\n", static_cast<float>(end / CLOCKS_PER_SEC), static_cast<int>(BaseLineEventsCount));
+	SetCompactImageProcessingFunc(nullptr);
+
+	size_t baselineSum[11][11];
+	size_t baselineTimingSum[11][11];
+
+	for (int i = 0; i < 11; ++i)
+	{
+		for (int j = 0; j < 11; ++j)
+		{
+			baselineSum[i][j] = 0;
+			baselineTimingSum[i][j] = 0;
+		}
+	}
+	size_t catbaslineSum = 0;
+	size_t catTimingbaselineSum = 0;
+	mutexBaseLineImageEvents.lock();
+	for(const auto& imageData : BaseLineImageEvents)
+	{
+		catbaslineSum += imageData.CathodeValue;
+		catTimingbaselineSum += imageData.CathodeTiming;
+		for (int i = 0; i < 11; ++i)
+		{
+			for (int j = 0; j < 11; ++j)
+			{
+				baselineSum[i][j] += imageData.GetAnodeValue(i, j);
+				baselineTimingSum[i][j] += imageData.GetAnodeTiming(i, j);
+			}
+		}
+	}
+	CathodeValueBaseline = static_cast<size_t>(catbaslineSum / BaseLineImageEvents.size());
+	CathodeTimingBaseline = static_cast<size_t>(catTimingbaselineSum / BaseLineImageEvents.size());
+	for (int i = 0; i < 11; ++i)
+	{
+		for (int j = 0; j < 11; ++j)
+		{
+			AnodeValueBaseline[i][j] = static_cast<size_t>(baselineSum[i][j] / BaseLineImageEvents.size());
+			AnodeTimingBaseline[i][j] = static_cast<size_t>(baselineTimingSum[i][j] / BaseLineImageEvents.size());
+		}
+	}
+	// Decode threads may still be running, they switch to the new table with their next packet
+	UDPImageDecoder.SetBaseline(AnodeValueBaseline, AnodeTimingBaseline, CathodeValueBaseline, CathodeTimingBaseline);
+
+	BaseLineImageEvents.clear();
+	SetImageProcessingFunc(&hurel::sre3021::SRE3021API::BasicImageProcessingFunc);	
+
+	mutexBaseLineImageEvents.unlock();
+	return;
+}
+
+int hurel::sre3021::SRE3021API::SetHighVoltage(int voltage, int step, int sleepTimeInMillisecond)
+{
+	int CurrentVoltage = static_cast<int>(ReadSysReg(SRE3021SysRegisterADDR::HV_DAC).Value);
+
+	if (CurrentVoltage > voltage)
+	{
+		int setVoltage = CurrentVoltage;
+		while (voltage < static_cast<int>(ReadSysReg(SRE3021SysRegisterADDR::HV_DAC).Value))
+		{
+			if (voltage + step < CurrentVoltage)
+			{
+				setVoltage -= step;
+			}
+			else
+			{
+				setVoltage = voltage;
+			}
+
+			CurrentVoltage = static_cast<int>(WriteSysReg(SRE3021SysRegisterADDR::HV_DAC, setVoltage).Value);
+			if (CurrentVoltage % 200 == 0)
+			{
+				printf("SRE3021API: Voltage drop to %d V \n", CurrentVoltage);
+			}
+			this_thread::sleep_for(std::chrono::milliseconds(sleepTimeInMillisecond));
+		}
+	}
+	else
+	{
+		int setVoltage = CurrentVoltage;
+		while (voltage > static_cast<int>(ReadSysReg(SRE3021SysRegisterADDR::HV_DAC).Value))
+		{
+			if (voltage - step > CurrentVoltage)
 			{
 				setVoltage += step;
 			}
@@ -1089,63 +2103,655 @@ int hurel::sre3021::SRE3021API::SetHighVoltage(int voltage, int step, int sleepT
 				setVoltage = voltage;
 			}
 
-			CurrentVoltage = static_cast<int>(WriteSysReg(SRE3021SysRegisterADDR::HV_DAC, setVoltage).Value);
-			if (CurrentVoltage % 100 == 0)
+			CurrentVoltage = static_cast<int>(WriteSysReg(SRE3021SysRegisterADDR::HV_DAC, setVoltage).Value);
+			if (CurrentVoltage % 100 == 0)
+			{
+				printf("SRE3021API: Voltage rise to %d V \n", CurrentVoltage);
+			}
+			this_thread::sleep_for(std::chrono::milliseconds(sleepTimeInMillisecond));
+
+		}
+	}
+	return CurrentVoltage;
+}
+
+void hurel::sre3021::SRE3021API::StartAcqusition(int HV, int VTHR, int VTHR0, int Hold_DLY, int VFP0)
+{
+	ReadWriteASICReg(SRE3021ASICRegisterADDR::Test_on, false);
+	ReadWriteASICReg(SRE3021ASICRegisterADDR::Test_on, false);
+	ReadWriteASICReg(SRE3021ASICRegisterADDR::Current_compensation_enable, true);
+	WriteSysReg(SRE3021SysRegisterADDR::VTHR, VTHR);
+	WriteSysReg(SRE3021SysRegisterADDR::VTHR0, VTHR0);
+	WriteSysReg(SRE3021SysRegisterADDR::VFP0, VFP0);
+	WriteSysReg(SRE3021SysRegisterADDR::CFG_PHYSTRIG_EN, 0);
+	WriteSysReg(SRE3021SysRegisterADDR::CMD_SET_CH, 0);
+	WriteSysReg(SRE3021SysRegisterADDR::CFG_CALTRIG_EN, 0);
+	WriteSysReg(SRE3021SysRegisterADDR::CFG_HOLD_DLY, Hold_DLY); //default 300
+	SetHighVoltage(HV, 10, 50);
+
+
+	WriteSysReg(SRE3021SysRegisterADDR::CFG_PHYSTRIG_EN, 1);
+}
+
+void hurel::sre3021::SRE3021API::StopAcqusition()
+{
+	WriteSysReg(SRE3021SysRegisterADDR::CFG_PHYSTRIG_EN, 0);
+	SetHighVoltage(0, 10, 50);
+}
+
+void hurel::sre3021::SRE3021API::SetImageProcessingFunc(void (hurel::sre3021::SRE3021API::*func)(SRE3021ImageData))
+{
+	mutexUDPImageBufferRaiserFunc.lock();
+	UDPImageBufferRaiserFunc = func;
+	mutexUDPImageBufferRaiserFunc.unlock();
+}
+
+void hurel::sre3021::SRE3021API::SetCompactImageProcessingFunc(void (hurel::sre3021::SRE3021API::*func)(const SRE3021CompactImageData&))
+{
+	mutexUDPImageBufferRaiserFunc.lock();
+	UDPImageBufferCompactFunc = func;
+	mutexUDPImageBufferRaiserFunc.unlock();
+}
+
+void hurel::sre3021::SRE3021API::SetImageViewProcessingFunc(void (hurel::sre3021::SRE3021API::*func)(const SRE3021ImageView&))
+{
+	mutexUDPImageBufferRaiserFunc.lock();
+	UDPImageBufferViewFunc = func;
+	mutexUDPImageBufferRaiserFunc.unlock();
+}
+
+void hurel::sre3021::SRE3021API::SetWaveformProcessingFunc(void (hurel::sre3021::SRE3021API::* func)(const SRE3021WaveformData&, const SRE3021WaveformResult&))
+{
+	mutexUDPImageBufferRaiserFunc.lock();
+	UDPImageBufferWaveformFunc = func;
+	mutexUDPImageBufferRaiserFunc.unlock();
+}
+
+void hurel::sre3021::SRE3021API::SetCoincidenceProcessingFunc(void (hurel::sre3021::SRE3021API::* func)(const SRE3021Coincidence&))
+{
+	mutexUDPImageBufferRaiserFunc.lock();
+	UDPImageBufferCoincidenceFunc = func;
+	mutexUDPImageBufferRaiserFunc.unlock();
+}
+
+void hurel::sre3021::SRE3021API::SetImageFrameProcessingFunc(void (hurel::sre3021::SRE3021API::* func)(const SRE3021ImageFrame&))
+{
+	mutexUDPImageBufferRaiserFunc.lock();
+	UDPImageBufferFrameFunc = func;
+	mutexUDPImageBufferRaiserFunc.unlock();
+}
+
+int hurel::sre3021::SRE3021API::SubscribeImageEvents(std::function<void(const std::vector<SRE3021ImageData>&)> consumer, size_t queueCapacity)
+{
+	return UDPImageEventBus.Subscribe(std::move(consumer), queueCapacity);
+}
+
+bool hurel::sre3021::SRE3021API::UnsubscribeImageEvents(int subscriptionId)
+{
+	return UDPImageEventBus.Unsubscribe(subscriptionId);
+}
+
+SRE3021EventBusStats hurel::sre3021::SRE3021API::GetImageEventSubscriptionStats(int subscriptionId)
+{
+	return UDPImageEventBus.GetStats(subscriptionId);
+}
+
+void hurel::sre3021::SRE3021API::SetChannelEventProcessingFunc(void (hurel::sre3021::SRE3021API::* func)(const SRE3021ChannelEvent&))
+{
+	mutexUDPImageBufferRaiserFunc.lock();
+	UDPImageBufferChannelEventFunc = func;
+	mutexUDPImageBufferRaiserFunc.unlock();
+}
+
+void hurel::sre3021::SRE3021API::DecodeImagePacketBatch(const unsigned __int8* packets, size_t packetCount, SRE3021ImageColumns& outColumns, size_t packetStride)
+{
+	UDPImageDecoder.DecodeBatch(packets, packetCount, outColumns, packetStride);
+}
+
+SpectrumEnergy hurel::sre3021::SRE3021API::GetSpectrum()
+{
+	std::lock_guard<std::mutex> lock(mutexDataSpectrumEnergy);
+	return dataSpectrumEnergy;
+}
+
+void hurel::sre3021::SRE3021API::ResetSpectrum()
+{
+	std::lock_guard<std::mutex> lock(mutexDataSpectrumEnergy);
+	dataSpectrumEnergy.Reset();
+	return;
+}
+
+size_t hurel::sre3021::SRE3021API::GetUdpPacketCount()
+{
+	size_t count = 0;
+	for (auto& shard : UDPShards)
+	{
+		count += shard->PacketCount.load(std::memory_order_relaxed);
+	}
+	return count;
+}
+
+size_t hurel::sre3021::SRE3021API::GetUDPImageBufferOccupancy()
+{
+	size_t occupancy = 0;
+	for (auto& shard : UDPShards)
+	{
+		occupancy += shard->ImageBuffer.Size();
+	}
+	return occupancy;
+}
+
+size_t hurel::sre3021::SRE3021API::GetUDPImageBufferHighWaterMark()
+{
+	// Highest of any shard, each shard has its own image buffer
+	size_t highWaterMark = 0;
+	for (auto& shard : UDPShards)
+	{
+		highWaterMark = std::max(highWaterMark, shard->ImageBuffer.HighWaterMark());
+	}
+	return highWaterMark;
+}
+
+size_t hurel::sre3021::SRE3021API::GetUDPImageBufferCapacity()
+{
+	if (UDPShards.empty())
+	{
+		return 0;
+	}
+	return UDPShards[0]->ImageBuffer.Capacity();
+}
+
+size_t hurel::sre3021::SRE3021API::GetUDPImageBufferDropCount()
+{
+	size_t count = 0;
+	for (auto& shard : UDPShards)
+	{
+		count += shard->ImageBufferDropCount.load(std::memory_order_relaxed) + shard->ImageBufferEvictCount.load(std::memory_order_relaxed)
+			+ shard->PacketPoolEmptyDropCount.load(std::memory_order_relaxed);
+	}
+	return count;
+}
+
+void hurel::sre3021::SRE3021API::ResetUDPImageBufferHighWaterMark()
+{
+	for (auto& shard : UDPShards)
+	{
+		shard->ImageBuffer.ResetHighWaterMark();
+	}
+}
+
+size_t hurel::sre3021::SRE3021API::GetUDPPacketPoolFreeSlotCount()
+{
+	size_t count = 0;
+	for (auto& shard : UDPShards)
+	{
+		count += shard->PacketPool.GetFreeSlotCount();
+	}
+	return count;
+}
+
+std::vector<size_t> hurel::sre3021::SRE3021API::GetUDPRecvBatchSizeHistogram()
+{
+	std::vector<size_t> histogram(UDPShards.empty() ? 0 : SRE3021_UDP_RECV_BATCH_SIZE + 1, 0);
+	for (auto& shard : UDPShards)
+	{
+		for (size_t i = 0; i < histogram.size(); ++i)
+		{
+			histogram[i] += shard->RecvBatchSizeHistogram[i].load(std::memory_order_relaxed);
+		}
+	}
+	return histogram;
+}
+
+void hurel::sre3021::SRE3021API::SetUDPImageBufferRaiserSpinBudget(size_t spinCount)
+{
+	UDPRaiserSpinBudget = spinCount;
+	for (auto& shard : UDPShards)
+	{
+		shard->ImageBufferDoorbell.SetSpinBudget(spinCount);
+		for (auto& doorbell : shard->DecodeWorkerDoorbells)
+		{
+			doorbell->SetSpinBudget(spinCount);
+		}
+	}
+}
+
+void hurel::sre3021::SRE3021API::SetUDPImageBufferCapacity(size_t packetCount)
+{
+	UDPImageBufferCapacity = packetCount < 1 ? 1 : packetCount;
+}
+
+void hurel::sre3021::SRE3021API::SetUDPBackpressurePolicy(SRE3021UDPBackpressurePolicy policy)
+{
+	UDPBackpressurePolicy = policy;
+}
+
+SRE3021UDPBackpressurePolicy hurel::sre3021::SRE3021API::GetUDPBackpressurePolicy()
+{
+	return UDPBackpressurePolicy;
+}
+
+SRE3021UDPDropStats hurel::sre3021::SRE3021API::GetUDPDropStats()
+{
+	SRE3021UDPDropStats stats{ 0, 0, 0, 0, 0 };
+	for (auto& shard : UDPShards)
+	{
+		stats.ImageBufferFull += shard->ImageBufferDropCount.load(std::memory_order_relaxed);
+		stats.ImageBufferEvicted += shard->ImageBufferEvictCount.load(std::memory_order_relaxed);
+		stats.PacketPoolEmpty += shard->PacketPoolEmptyDropCount.load(std::memory_order_relaxed);
+		stats.Kernel += shard->KernelDropCount.load(std::memory_order_relaxed);
+		stats.ReceiverBlocked += shard->ReceiverBlockCount.load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+void hurel::sre3021::SRE3021API::SetUDPImageBufferWatermarks(double highFraction, double lowFraction)
+{
+	if (lowFraction > highFraction)
+	{
+		std::swap(lowFraction, highFraction);
+	}
+	UDPImageBufferHighWatermark = highFraction;
+	UDPImageBufferLowWatermark = lowFraction;
+	for (auto& shard : UDPShards)
+	{
+		shard->HighWatermark = static_cast<size_t>(highFraction * shard->ImageBuffer.Capacity());
+		shard->LowWatermark = static_cast<size_t>(lowFraction * shard->ImageBuffer.Capacity());
+	}
+}
+
+void hurel::sre3021::SRE3021API::SetUDPImageBufferWatermarkFunc(void (hurel::sre3021::SRE3021API::* func)(int, size_t, bool))
+{
+	mutexUDPImageBufferWatermarkFunc.lock();
+	UDPImageBufferWatermarkFunc = func;
+	mutexUDPImageBufferWatermarkFunc.unlock();
+}
+
+void hurel::sre3021::SRE3021API::BasicUDPImageBufferWatermarkFunc(int shardIndex, size_t occupancy, bool isAboveWatermark)
+{
+	printf("UDP shard %d image buffer %s watermark, occupancy %zu\n", shardIndex, isAboveWatermark ? "above high" : "below low", occupancy);
+}
+
+SRE3021DoorbellStats hurel::sre3021::SRE3021API::GetUDPImageBufferRaiserWaitStats()
+{
+	SRE3021DoorbellStats total{ UDPRaiserSpinBudget, 0, 0, 0, 0, 0, 0 };
+	double wakeLatencySum = 0;
+	std::vector<SRE3021Doorbell*> doorbells;
+	for (auto& shard : UDPShards)
+	{
+		doorbells.push_back(&shard->ImageBufferDoorbell);
+		for (auto& doorbell : shard->DecodeWorkerDoorbells)
+		{
+			doorbells.push_back(doorbell.get());
+		}
+	}
+	for (SRE3021Doorbell* doorbell : doorbells)
+	{
+		SRE3021DoorbellStats stats = doorbell->GetStats();
+		total.ParkCount += stats.ParkCount;
+		total.RingWakeCount += stats.RingWakeCount;
+		total.SpinSeconds += stats.SpinSeconds;
+		total.ParkedSeconds += stats.ParkedSeconds;
+		total.MaxWakeLatencyMicroseconds = std::max(total.MaxWakeLatencyMicroseconds, stats.MaxWakeLatencyMicroseconds);
+		wakeLatencySum += stats.MeanWakeLatencyMicroseconds * stats.RingWakeCount;
+	}
+	if (total.RingWakeCount > 0)
+	{
+		total.MeanWakeLatencyMicroseconds = wakeLatencySum / total.RingWakeCount;
+	}
+	return total;
+}
+
+void hurel::sre3021::SRE3021API::ResetUDPImageBufferRaiserWaitStats()
+{
+	for (auto& shard : UDPShards)
+	{
+		shard->ImageBufferDoorbell.ResetStats();
+		for (auto& doorbell : shard->DecodeWorkerDoorbells)
+		{
+			doorbell->ResetStats();
+		}
+	}
+}
+
+SRE3021SequenceStats hurel::sre3021::SRE3021API::GetUDPSequenceStats(int systemNumber)
+{
+	SRE3021SequenceStats total{ 0, 0, 0, 0, 0 };
+	for (auto& shard : UDPShards)
+	{
+		SRE3021SequenceStats stats = shard->SequenceTracker.GetStats(systemNumber);
+		total.Received += stats.Received;
+		total.Lost += stats.Lost;
+		total.Duplicate += stats.Duplicate;
+		total.Reordered += stats.Reordered;
+		total.OutOfWindow += stats.OutOfWindow;
+	}
+	return total;
+}
+
+SRE3021SequenceStats hurel::sre3021::SRE3021API::GetUDPSequenceTotalStats()
+{
+	SRE3021SequenceStats total{ 0, 0, 0, 0, 0 };
+	for (auto& shard : UDPShards)
+	{
+		SRE3021SequenceStats stats = shard->SequenceTracker.GetTotalStats();
+		total.Received += stats.Received;
+		total.Lost += stats.Lost;
+		total.Duplicate += stats.Duplicate;
+		total.Reordered += stats.Reordered;
+		total.OutOfWindow += stats.OutOfWindow;
+	}
+	return total;
+}
+
+unsigned long long hurel::sre3021::SRE3021API::GetUDPHardwareTimestamp(int systemNumber)
+{
+	unsigned long long timestamp = 0;
+	for (auto& shard : UDPShards)
+	{
+		timestamp = std::max(timestamp, shard->TimestampUnwrapper.GetLatest(systemNumber));
+	}
+	return timestamp;
+}
+
+std::vector<SRE3021SequenceLossEvent> hurel::sre3021::SRE3021API::GetUDPSequenceLossEvents()
+{
+	std::vector<SRE3021SequenceLossEvent> events;
+	for (auto& shard : UDPShards)
+	{
+		std::vector<SRE3021SequenceLossEvent> shardEvents = shard->SequenceTracker.GetLossEvents();
+		events.insert(events.end(), shardEvents.begin(), shardEvents.end());
+	}
+	std::stable_sort(events.begin(), events.end(), [](const SRE3021SequenceLossEvent& a, const SRE3021SequenceLossEvent& b) { return a.Seconds < b.Seconds; });
+	return events;
+}
+
+void hurel::sre3021::SRE3021API::SetUDPReceiveBufferSize(int bytes)
+{
+	UDPReceiveBufferSize = bytes;
+}
+
+int hurel::sre3021::SRE3021API::GetUDPReceiveBufferSize()
+{
+	if (UDPShards.empty())
+	{
+		return 0;
+	}
+	return UDPShards[0]->GrantedReceiveBufferSize;
+}
+
+size_t hurel::sre3021::SRE3021API::GetUDPKernelDropCount()
+{
+	size_t count = 0;
+	for (auto& shard : UDPShards)
+	{
+		count += shard->KernelDropCount.load(std::memory_order_relaxed);
+	}
+	return count;
+}
+
+bool hurel::sre3021::SRE3021API::IsUDPKernelDropCountSupported()
+{
+	if (UDPShards.empty())
+	{
+		return false;
+	}
+	return UDPShards[0]->isKernelDropCountSupported;
+}
+
+void hurel::sre3021::SRE3021API::SetUDPReceiveBackend(SRE3021UDPReceiveBackend backend)
+{
+	UDPReceiveBackend = backend;
+}
+
+SRE3021UDPReceiveBackend hurel::sre3021::SRE3021API::GetUDPReceiveBackend()
+{
+	if (UDPShards.empty())
+	{
+		return SRE3021UDPReceiveBackend::SOCKET;
+	}
+	return UDPShards[0]->ActiveReceiveBackend;
+}
+
+void hurel::sre3021::SRE3021API::SetUDPCaptureInterface(const std::string& interfaceName)
+{
+	UDPCaptureInterface = interfaceName;
+}
+
+void hurel::sre3021::SRE3021API::SetUDPReceiverShardCount(int shardCount)
+{
+	if (shardCount < 1)
+	{
+		shardCount = 1;
+	}
+#if !UDP_SOCKET_HAS_REUSEPORT
+	if (shardCount > 1)
+	{
+		printf("SO_REUSEPORT is not available, using one UDP receiver shard\n");
+		shardCount = 1;
+	}
+#endif
+	// Steering by SystemNumber can not address more shards than there are system numbers
+	UDPShardCount = std::min(shardCount, SRE3021_SYSTEM_NUMBER_COUNT);
+}
+
+int hurel::sre3021::SRE3021API::GetUDPReceiverShardCount()
+{
+	return UDPShardCount;
+}
+
+std::vector<size_t> hurel::sre3021::SRE3021API::GetUDPShardPacketCounts()
+{
+	std::vector<size_t> counts;
+	for (auto& shard : UDPShards)
+	{
+		counts.push_back(shard->PacketCount.load(std::memory_order_relaxed));
+	}
+	return counts;
+}
+
+void hurel::sre3021::SRE3021API::SetUDPDecodeWorkerCount(int workerCount)
+{
+	UDPDecodeWorkerCount = std::min(std::max(workerCount, 0), SRE3021_UDP_DECODE_WORKER_MAX);
+}
+
+int hurel::sre3021::SRE3021API::GetUDPDecodeWorkerCount()
+{
+	return UDPDecodeWorkerCount;
+}
+
+void hurel::sre3021::SRE3021API::SetUDPDecodeOrdering(SRE3021UDPDecodeOrdering ordering)
+{
+	UDPDecodeOrdering = ordering;
+}
+
+SRE3021UDPDecodeOrdering hurel::sre3021::SRE3021API::GetUDPDecodeOrdering()
+{
+	return UDPDecodeOrdering;
+}
+
+void hurel::sre3021::SRE3021API::SetAcquisitionMode(SRE3021AcquisitionMode mode)
+{
+	UDPAcquisitionMode = mode;
+}
+
+SRE3021AcquisitionMode hurel::sre3021::SRE3021API::GetAcquisitionMode()
+{
+	return UDPAcquisitionMode;
+}
+
+size_t hurel::sre3021::SRE3021API::GetUDPEventCount()
+{
+	size_t eventCount = 0;
+	for (auto& shard : UDPShards)
+	{
+		eventCount += shard->EventCount.load(std::memory_order_relaxed);
+	}
+	return eventCount;
+}
+
+void hurel::sre3021::SRE3021API::SetWaveformFilter(const SRE3021WaveformFilter& filter)
+{
+	UDPWaveformFilter = filter;
+}
+
+SRE3021WaveformFilter hurel::sre3021::SRE3021API::GetWaveformFilter()
+{
+	return UDPWaveformFilter;
+}
+
+void hurel::sre3021::SRE3021API::SetCoincidenceSettings(const SRE3021CoincidenceSettings& settings)
+{
+	UDPCoincidenceSettings = settings;
+}
+
+SRE3021CoincidenceSettings hurel::sre3021::SRE3021API::GetCoincidenceSettings()
+{
+	return UDPCoincidenceSettings;
+}
+
+std::vector<size_t> hurel::sre3021::SRE3021API::GetCoincidenceMultiplicityHistogram()
+{
+	std::vector<size_t> histogram(SRE3021_COINCIDENCE_MAX_MULTIPLICITY + 1, 0);
+	for (auto& shard : UDPShards)
+	{
+		std::lock_guard<std::mutex> lock(shard->TriggerTime.mutexCoincidenceFinder);
+		const std::vector<size_t> shardHistogram = shard->TriggerTime.CoincidenceFinder.GetMultiplicityHistogram();
+		for (size_t i = 0; i < histogram.size(); ++i)
+		{
+			histogram[i] += shardHistogram[i];
+		}
+	}
+	return histogram;
+}
+
+size_t hurel::sre3021::SRE3021API::GetCoincidenceLateTriggerCount()
+{
+	size_t lateCount = 0;
+	for (auto& shard : UDPShards)
+	{
+		std::lock_guard<std::mutex> lock(shard->TriggerTime.mutexCoincidenceFinder);
+		lateCount += shard->TriggerTime.CoincidenceFinder.GetLateRecordCount();
+	}
+	return lateCount;
+}
+
+std::vector<unsigned long long> hurel::sre3021::SRE3021API::GetCountingChannelCounts()
+{
+	std::vector<unsigned long long> counts(SRE3021_ASIC_CHANNEL_COUNT, 0);
+	for (auto& shard : UDPShards)
+	{
+		for (int i = 0; i < SRE3021_ASIC_CHANNEL_COUNT; ++i)
+		{
+			counts[i] += shard->Counting.Accumulator.GetCount(i);
+		}
+	}
+	return counts;
+}
+
+std::vector<double> hurel::sre3021::SRE3021API::GetCountingChannelRates()
+{
+	std::vector<double> rates(SRE3021_ASIC_CHANNEL_COUNT, 0.0);
+	for (auto& shard : UDPShards)
+	{
+		// Read the clock under the lock, a caller that waited must not move the snapshot back in time
+		std::lock_guard<std::mutex> lock(shard->Counting.mutexRate);
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		const double seconds = std::chrono::duration<double>(now - shard->Counting.RateTime).count();
+		for (int i = 0; i < SRE3021_ASIC_CHANNEL_COUNT; ++i)
+		{
+			const unsigned long long count = shard->Counting.Accumulator.GetCount(i);
+			if (seconds > 0)
 			{
-				printf("SRE3021API: Voltage rise to %d V \n", CurrentVoltage);
+				rates[i] += static_cast<double>(count - shard->Counting.RateCounts[i]) / seconds;
 			}
-			this_thread::sleep_for(std::chrono::milliseconds(sleepTimeInMillisecond));
-
+			shard->Counting.RateCounts[i] = count;
 		}
+		shard->Counting.RateTime = now;
 	}
-	return CurrentVoltage;
+	return rates;
 }
 
-void hurel::sre3021::SRE3021API::StartAcqusition(int HV, int VTHR, int VTHR0, int Hold_DLY, int VFP0)
+std::vector<double> hurel::sre3021::SRE3021API::GetCountingPixelRates()
 {
-	ReadWriteASICReg(SRE3021ASICRegisterADDR::Test_on, false);
-	ReadWriteASICReg(SRE3021ASICRegisterADDR::Test_on, false);
-	ReadWriteASICReg(SRE3021ASICRegisterADDR::Current_compensation_enable, true);
-	WriteSysReg(SRE3021SysRegisterADDR::VTHR, VTHR);
-	WriteSysReg(SRE3021SysRegisterADDR::VTHR0, VTHR0);
-	WriteSysReg(SRE3021SysRegisterADDR::VFP0, VFP0);
-	WriteSysReg(SRE3021SysRegisterADDR::CFG_PHYSTRIG_EN, 0);
-	WriteSysReg(SRE3021SysRegisterADDR::CMD_SET_CH, 0);
-	WriteSysReg(SRE3021SysRegisterADDR::CFG_CALTRIG_EN, 0);
-	WriteSysReg(SRE3021SysRegisterADDR::CFG_HOLD_DLY, Hold_DLY); //default 300
-	SetHighVoltage(HV, 10, 50);
+	const std::vector<double> channelRates = GetCountingChannelRates();
+	std::vector<double> pixelRates(11 * 11, 0.0);
+	for (int X = 0; X < 11; ++X)
+	{
+		for (int Y = 0; Y < 11; ++Y)
+		{
+			pixelRates[Y * 11 + X] = channelRates[ASICChannelNumber[X][Y]];
+		}
+	}
+	return pixelRates;
+}
 
+size_t hurel::sre3021::SRE3021API::GetCountingFrameCount()
+{
+	size_t frameCount = 0;
+	for (auto& shard : UDPShards)
+	{
+		frameCount += shard->Counting.Accumulator.GetFrameCount();
+	}
+	return frameCount;
+}
 
-	WriteSysReg(SRE3021SysRegisterADDR::CFG_PHYSTRIG_EN, 1);
+void hurel::sre3021::SRE3021API::SetImageFrameTimeout(int milliseconds)
+{
+	UDPImageFrameTimeout = milliseconds;
 }
 
-void hurel::sre3021::SRE3021API::StopAcqusition()
+int hurel::sre3021::SRE3021API::GetImageFrameTimeout()
 {
-	WriteSysReg(SRE3021SysRegisterADDR::CFG_PHYSTRIG_EN, 0);
-	SetHighVoltage(0, 10, 50);
+	return UDPImageFrameTimeout;
 }
 
-void hurel::sre3021::SRE3021API::SetImageProcessingFunc(void (hurel::sre3021::SRE3021API::*func)(SRE3021ImageData))
+SRE3021ImageFrameStats hurel::sre3021::SRE3021API::GetImageFrameStats()
 {
-	mutexUDPImageBufferRaiserFunc.lock();
-	UDPImageBufferRaiserFunc = func;
-	mutexUDPImageBufferRaiserFunc.unlock();
+	SRE3021ImageFrameStats stats{ 0, 0, 0, 0, 0 };
+	for (auto& shard : UDPShards)
+	{
+		const SRE3021ImageFrameStats shardStats = shard->ImageFrame.Reassembler.GetStats();
+		stats.Completed += shardStats.Completed;
+		stats.TimedOut += shardStats.TimedOut;
+		stats.Duplicate += shardStats.Duplicate;
+		stats.NoFreeFrame += shardStats.NoFreeFrame;
+		stats.Invalid += shardStats.Invalid;
+	}
+	return stats;
 }
 
-SpectrumEnergy hurel::sre3021::SRE3021API::GetSpectrum()
+void hurel::sre3021::SRE3021API::SetSingleChannelReadout(int channel)
 {
-	return dataSpectrumEnergy;
+	// 128 is the value the baseline check writes to keep single channel readout off
+	WriteSysReg(SRE3021SysRegisterADDR::CFG_FIXED_CH, channel >= 0 && channel < SRE3021_ASIC_CHANNEL_COUNT ? channel : 128);
 }
 
-void hurel::sre3021::SRE3021API::ResetSpectrum()
+double hurel::sre3021::SRE3021API::GetUDPEventsPerDatagram()
 {
-	dataSpectrumEnergy.Reset();
-	return;
+	size_t packetCount = 0;
+	for (auto& shard : UDPShards)
+	{
+		packetCount += shard->PacketCount.load(std::memory_order_relaxed) - shard->PacketPoolEmptyDropCount.load(std::memory_order_relaxed);
+	}
+	return packetCount == 0 ? 0.0 : static_cast<double>(GetUDPEventCount()) / packetCount;
 }
 
-size_t hurel::sre3021::SRE3021API::GetUdpPacketCount()
+std::vector<double> hurel::sre3021::SRE3021API::GetUDPShardPacketRates()
 {
-	return UdpPacketCount;
+	std::vector<double> rates;
+	for (auto& shard : UDPShards)
+	{
+		// Read the count and the time under the lock so a waiting caller never stores an older snapshot
+		std::lock_guard<std::mutex> lock(shard->mutexRate);
+		const size_t count = shard->PacketCount.load(std::memory_order_relaxed);
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		const double seconds = std::chrono::duration<double>(now - shard->RateTime).count();
+		rates.push_back(seconds > 0 ? static_cast<double>(count - shard->RatePacketCount) / seconds : 0.0);
+		shard->RatePacketCount = count;
+		shard->RateTime = now;
+	}
+	return rates;
 }
 
 bool hurel::sre3021::SRE3021API::CalibrateEnergySpectrumWith22Na(int minutes)
@@ -1154,7 +2760,17 @@ bool hurel::sre3021::SRE3021API::CalibrateEnergySpectrumWith22Na(int minutes)
 	StartAcqusition();
 	cout << "Started loop.." << endl;
 	for (int i = 0; i < 60 * minutes; ++i) {
-		cout << i << " seconds: packetcounts = " << GetUdpPacketCount() << endl;
+		cout << i << " seconds: packetcounts = " << GetUdpPacketCount() << ", kernel drops = " << GetUDPKernelDropCount() << endl;
+		if (UDPShardCount > 1)
+		{
+			std::vector<double> shardRates = GetUDPShardPacketRates();
+			cout << "    shard packet rates:";
+			for (double rate : shardRates)
+			{
+				cout << " " << rate;
+			}
+			cout << endl;
+		}
 
 		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
 		std::vector<double> peaks2 = GetSpectrum().FindPeaks();
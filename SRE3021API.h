@@ -26,8 +26,10 @@
 #pragma once
 
 //Networking 
+#ifdef _WIN32
 #include <WS2tcpip.h>
 #pragma comment(lib, "ws2_32.lib")
+#endif
 #include "Network.h"
 
 #include <vector>
@@ -36,11 +38,31 @@
 #include <iomanip>
 #include <thread>
 #include <mutex>
-#include <queue>
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <functional>
 
 #include "SRE3021PacketHeader.h"
 #include "SRE3021SysReg.h"
+#include "SRE3021MPMCRingBuffer.h"
+#include "SRE3021PacketPool.h"
+#include "SRE3021Doorbell.h"
+#include "SRE3021SequenceTracker.h"
+#include "SRE3021TimestampUnwrapper.h"
+#include "SRE3021IoUringReceiver.h"
+#include "SRE3021PacketMmapReceiver.h"
+#include "SRE3021ImageView.h"
+#include "SRE3021CompactImageData.h"
+#include "SRE3021ImageDecoder.h"
+#include "SRE3021PulseHeightDecoder.h"
+#include "SRE3021DecodeArena.h"
+#include "SRE3021WaveformProcessor.h"
+#include "SRE3021CoincidenceFinder.h"
+#include "SRE3021CountingAccumulator.h"
+#include "SRE3021ImageFrameReassembler.h"
+#include "SRE3021ReorderBuffer.h"
+#include "SRE3021EventBus.h"
 #include "SpectrumEnergy.h"
 
 
@@ -65,37 +87,295 @@ namespace hurel
 			unsigned __int8 ConvertBoolArrayToByte(std::vector<bool> source);
 			bool GetASICConfigtBitValue(SRE3021ASICRegisterADDR addr);
 
-			std::thread udpThread;
-			std::thread udpRaiserThread;
+			/// <summary>
+			/// What a UDPDecodedEvent carries
+			/// </summary>
+			enum class UDPDecodedEventKind
+			{
+				// Image packet, decoded into UDPImageState
+				IMAGE,
+				// Multi-event pulse-height packet, kept in PacketSlot and decoded when handed over
+				PULSE_HEIGHT,
+				// Trigger time packet, kept in PacketSlot and added to the coincidence finder when handed over
+				TRIGGER_TIME,
+				// Pipeline sampling packet, filtered into UDPWaveformState
+				WAVEFORM,
+				// Single channel readout packet, decoded into UDPSingleChannelState
+				CHANNEL_EVENT
+			};
+
+			/// <summary>
+			/// Packet decoded by a decode worker, waiting for its turn when events are handed over in arrival order.
+			/// Only the kind and the functions set when the packet was decoded are kept here. The payload is in the state of
+			/// the shard's acquisition mode at PayloadIndex, so a slot of the reorder buffer does not hold the payload of every mode.
+			/// IsImageEventPublished is set when image events also go to the image event bus.
+			/// </summary>
+			struct UDPDecodedEvent
+			{
+				UDPDecodedEventKind Kind = UDPDecodedEventKind::IMAGE;
+				size_t PayloadIndex = 0;
+				void (hurel::sre3021::SRE3021API::* RaiserFunc)(SRE3021ImageData) = nullptr;
+				void (hurel::sre3021::SRE3021API::* CompactFunc)(const SRE3021CompactImageData&) = nullptr;
+				void (hurel::sre3021::SRE3021API::* WaveformFunc)(const SRE3021WaveformData&, const SRE3021WaveformResult&) = nullptr;
+				void (hurel::sre3021::SRE3021API::* ChannelEventFunc)(const SRE3021ChannelEvent&) = nullptr;
+				void (hurel::sre3021::SRE3021API::* CoincidenceFunc)(const SRE3021Coincidence&) = nullptr;
+				SRE3021PacketSlot PacketSlot{ SRE3021_PACKET_SLOT_NONE, 0, 0, 0 };
+				bool IsImageEventPublished = false;
+			};
+
+			/// <summary>
+			/// IMAGE and IMAGE_FRAME acquisition. Decoded events waiting to be handed over in arrival order, by PayloadIndex.
+			/// </summary>
+			struct UDPImageState
+			{
+				std::vector<SRE3021ImageData> DecodedImageData;
+				std::vector<SRE3021CompactImageData> DecodedCompactImageData;
+			};
+
+			/// <summary>
+			/// MULTI_PULSE_HEIGHT acquisition
+			/// </summary>
+			struct UDPPulseHeightState
+			{
+				// Pulse-height packets decoded by the image processing thread, or by the worker handing events over in arrival order
+				SRE3021DecodeArena Arena;
+			};
+
+			/// <summary>
+			/// WAVEFORM acquisition
+			/// </summary>
+			struct UDPWaveformState
+			{
+				// Cell pointer of the last cathode pipeline sampling packet, anode packets of the same readout do not carry it
+				int ReadoutCellPointer = -1;
+				// Filtered waveforms waiting to be handed over in arrival order, by PayloadIndex
+				std::vector<SRE3021WaveformData> DecodedWaveforms;
+				std::vector<SRE3021WaveformResult> DecodedResults;
+			};
+
+			/// <summary>
+			/// TRIGGER_TIME acquisition
+			/// </summary>
+			struct UDPTriggerTimeState
+			{
+				// Trigger time packets are added in arrival order by the image processing thread or the worker handing events over,
+				// the getters read the finder under the lock
+				std::mutex mutexCoincidenceFinder;
+				SRE3021CoincidenceFinder CoincidenceFinder;
+				std::vector<SRE3021Coincidence> Coincidences;
+			};
+
+			/// <summary>
+			/// COUNTING acquisition
+			/// </summary>
+			struct UDPCountingState
+			{
+				SRE3021CountingAccumulator Accumulator;
+				// Last snapshot of GetCountingChannelRates, which any thread may call
+				std::mutex mutexRate;
+				std::vector<unsigned long long> RateCounts;
+				std::chrono::steady_clock::time_point RateTime;
+			};
+
+			/// <summary>
+			/// IMAGE_FRAME acquisition
+			/// </summary>
+			struct UDPImageFrameState
+			{
+				SRE3021ImageFrameReassembler Reassembler;
+			};
+
+			/// <summary>
+			/// SINGLE_CHANNEL acquisition
+			/// </summary>
+			struct UDPSingleChannelState
+			{
+				// Channel events waiting to be handed over in arrival order, by PayloadIndex
+				std::vector<SRE3021ChannelEvent> DecodedChannelEvents;
+			};
+
+			/// <summary>
+			/// One pass of the image processing thread or a decode worker over the image buffer: the processing functions read
+			/// at its start and the packets processed together. Waveforms are filtered SRE3021_WAVEFORM_LANE_COUNT at a time,
+			/// image events are published to the event bus in batches.
+			/// </summary>
+			struct UDPDecodePass
+			{
+				UDPDecodePass(SRE3021EventBus<SRE3021ImageData>* imageEventBus, bool isReordered, SRE3021DecodeArena& pulseHeightArena)
+					: IsReordered(isReordered), PulseHeightArena(pulseHeightArena), ImageEvents(imageEventBus)
+				{
+				};
+
+				void (hurel::sre3021::SRE3021API::* RaiserFunc)(SRE3021ImageData) = nullptr;
+				void (hurel::sre3021::SRE3021API::* ViewFunc)(const SRE3021ImageView&) = nullptr;
+				void (hurel::sre3021::SRE3021API::* CompactFunc)(const SRE3021CompactImageData&) = nullptr;
+				void (hurel::sre3021::SRE3021API::* WaveformFunc)(const SRE3021WaveformData&, const SRE3021WaveformResult&) = nullptr;
+				void (hurel::sre3021::SRE3021API::* CoincidenceFunc)(const SRE3021Coincidence&) = nullptr;
+				void (hurel::sre3021::SRE3021API::* FrameFunc)(const SRE3021ImageFrame&) = nullptr;
+				void (hurel::sre3021::SRE3021API::* ChannelEventFunc)(const SRE3021ChannelEvent&) = nullptr;
+				bool HasImageSubscribers = false;
+				// Events are handed over in arrival order through the reorder buffer, under the ticket of their packet
+				bool IsReordered;
+				SRE3021DecodeArena& PulseHeightArena;
+				SRE3021PacketSlot WaveformSlots[SRE3021_WAVEFORM_LANE_COUNT];
+				size_t WaveformTickets[SRE3021_WAVEFORM_LANE_COUNT];
+				size_t WaveformSlotCount = 0;
+				SRE3021EventBus<SRE3021ImageData>::Publisher ImageEvents;
+			};
+
+			/// <summary>
+			/// One UDP listener and image processing thread pair on the image port, with its own packet pool and image buffer.
+			/// With more than one shard every listener binds the port with SO_REUSEPORT.
+			/// </summary>
+			struct UDPReceiverShard
+			{
+				int Index = 0;
+				std::thread udpThread;
+				std::thread udpRaiserThread;
+				// Counters written by the listener alone and read by any thread, relaxed load and store like SRE3021CountingAccumulator
+				std::atomic<size_t> PacketCount{ 0 };
+				std::atomic<size_t> EventCount{ 0 };
+				// Index is the number of datagrams returned by one receive call
+				std::atomic<size_t> RecvBatchSizeHistogram[SRE3021_UDP_RECV_BATCH_SIZE + 1];
+				SRE3021PacketPool PacketPool;
+				SRE3021MPMCRingBuffer<SRE3021PacketSlot> ImageBuffer;
+				SRE3021Doorbell ImageBufferDoorbell{ SRE3021_UDP_RAISER_SPIN_BUDGET };
+				SRE3021UDPBackpressurePolicy BackpressurePolicy = SRE3021UDPBackpressurePolicy::DROP_NEWEST;
+				SRE3021Doorbell ImageBufferSpaceDoorbell{ SRE3021_UDP_RAISER_SPIN_BUDGET };
+				// Drop counters are written by the listener and read by any thread, relaxed is enough for statistics
+				std::atomic<size_t> ImageBufferDropCount{ 0 };
+				std::atomic<size_t> ImageBufferEvictCount{ 0 };
+				std::atomic<size_t> PacketPoolEmptyDropCount{ 0 };
+				std::atomic<size_t> ReceiverBlockCount{ 0 };
+				size_t HighWatermark = 0;
+				size_t LowWatermark = 0;
+				bool isAboveWatermark = false;
+				SRE3021SequenceTracker SequenceTracker;
+				SRE3021TimestampUnwrapper TimestampUnwrapper;
+				int GrantedReceiveBufferSize = 0;
+				bool isKernelDropCountSupported = false;
+				std::atomic<size_t> KernelDropCount{ 0 };
+				SRE3021UDPReceiveBackend ActiveReceiveBackend = SRE3021UDPReceiveBackend::SOCKET;
+				SRE3021PacketMmapReceiver PacketMmapReceiver;
+				// Last snapshot of GetUDPShardPacketRates, which any thread may call
+				std::mutex mutexRate;
+				size_t RatePacketCount = 0;
+				std::chrono::steady_clock::time_point RateTime;
+				// Decode workers replace the image processing thread when there are any
+				std::vector<std::thread> udpDecodeWorkerThreads;
+				std::vector<std::unique_ptr<SRE3021Doorbell>> DecodeWorkerDoorbells;
+				SRE3021UDPDecodeOrdering DecodeOrdering = SRE3021UDPDecodeOrdering::NONE;
+				SRE3021ReorderBuffer<UDPDecodedEvent> DecodedEvents;
+				// Image events handed over in arrival order, published by whichever worker holds the delivery role
+				SRE3021EventBus<SRE3021ImageData>::Publisher DeliveredImageEvents;
+				SRE3021AcquisitionMode AcquisitionMode = SRE3021AcquisitionMode::IMAGE;
+				// State of each acquisition mode, only the one of AcquisitionMode holds any memory
+				UDPImageState Image;
+				UDPPulseHeightState PulseHeight;
+				UDPWaveformState Waveform;
+				UDPTriggerTimeState TriggerTime;
+				UDPCountingState Counting;
+				UDPImageFrameState ImageFrame;
+				UDPSingleChannelState SingleChannel;
+			};
+			// Declared before the shards, their publishers flush into it when destroyed
+			SRE3021EventBus<SRE3021ImageData> UDPImageEventBus;
+			std::vector<std::unique_ptr<UDPReceiverShard>> UDPShards;
+			int UDPShardCount = 1;
+			size_t UDPRaiserSpinBudget = SRE3021_UDP_RAISER_SPIN_BUDGET;
+			size_t UDPImageBufferCapacity = SRE3021_UDP_IMAGE_BUFFER_CAPACITY;
+			SRE3021UDPBackpressurePolicy UDPBackpressurePolicy = SRE3021UDPBackpressurePolicy::DROP_NEWEST;
+			double UDPImageBufferHighWatermark = SRE3021_UDP_IMAGE_BUFFER_HIGH_WATERMARK;
+			double UDPImageBufferLowWatermark = SRE3021_UDP_IMAGE_BUFFER_LOW_WATERMARK;
+			int UDPDecodeWorkerCount = 0;
+			SRE3021UDPDecodeOrdering UDPDecodeOrdering = SRE3021UDPDecodeOrdering::ARRIVAL;
+			SRE3021AcquisitionMode UDPAcquisitionMode = SRE3021AcquisitionMode::IMAGE;
 			bool isUdpServerOpen = false;
 
-			void RunUDPServer();
-			void UDPImageBufferRaiser();
+			void RunUDPServer(UDPReceiverShard& shard);
+			void ReceiveUDPWithSocket(UDPReceiverShard& shard, UDPSocket& Socket);
+			bool ReceiveUDPWithIoUring(UDPReceiverShard& shard, UDPSocket& Socket);
+			bool ReceiveUDPWithPacketMmap(UDPReceiverShard& shard, UDPSocket& Socket);
+			bool IsUDPEventPacket(const UDPReceiverShard& shard, const unsigned __int8* data, int dataSize);
+			bool HandleUDPDatagram(UDPReceiverShard& shard, unsigned __int32& slotIndex, int dataSize, long long receiveTime);
+			bool QueueUDPImagePacket(UDPReceiverShard& shard, unsigned __int32& slotIndex, const SRE3021PacketSlot& slot);
+			bool QueueUDPImageFrame(UDPReceiverShard& shard, const SRE3021PacketSlot& packetSlot);
+			void CheckUDPImageBufferWatermark(UDPReceiverShard& shard);
+			const unsigned __int8* UDPSlotData(UDPReceiverShard& shard, unsigned __int32 slotIndex);
+			void ReleaseUDPSlot(UDPReceiverShard& shard, unsigned __int32 slotIndex);
+			void UDPImageBufferRaiser(UDPReceiverShard& shard);
+			void UDPDecodeWorker(UDPReceiverShard& shard, int workerIndex);
+			void RingUDPImageConsumers(UDPReceiverShard& shard);
+			/// <summary>
+			/// Read the processing functions for a pass. Returns false when none is set.
+			/// </summary>
+			bool BeginUDPDecodePass(UDPDecodePass& pass);
+			void EndUDPDecodePass(UDPReceiverShard& shard, UDPDecodePass& pass);
+			/// <summary>
+			/// Process one queued packet by its type and give its slot back, for the image processing thread and the decode workers alike.
+			/// In arrival order the events of the packet go to the reorder buffer under ticket.
+			/// </summary>
+			void HandleUDPPacket(UDPReceiverShard& shard, UDPDecodePass& pass, const SRE3021PacketSlot& slot, size_t ticket);
+			void HandleUDPImagePacket(UDPReceiverShard& shard, UDPDecodePass& pass, const SRE3021PacketSlot& slot, size_t ticket);
+			void FlushUDPWaveforms(UDPReceiverShard& shard, UDPDecodePass& pass);
+			void DrainUDPDecodedEvents(UDPReceiverShard& shard);
+			/// <summary>
+			/// Whether the shard keeps payloads of this kind for the arrival order, i.e. its acquisition mode produces them.
+			/// Packets of another kind are passed over as gaps.
+			/// </summary>
+			bool HasUDPDecodedPayload(const UDPReceiverShard& shard, UDPDecodedEventKind kind);
+			void DeliverUDPDecodedEvent(UDPReceiverShard& shard, const UDPDecodedEvent& decodedEvent);
+			void RaiseUDPPulseHeightEvents(const unsigned __int8* bytes, const SRE3021PacketSlot& slot, SRE3021DecodeArena& arena,
+				void (hurel::sre3021::SRE3021API::* raiserFunc)(SRE3021ImageData), void (hurel::sre3021::SRE3021API::* compactFunc)(const SRE3021CompactImageData&),
+				SRE3021EventBus<SRE3021ImageData>::Publisher* imageEvents);
+			bool DecodeUDPWaveform(UDPReceiverShard& shard, const SRE3021PacketSlot& slot, SRE3021WaveformData& outWaveform);
+			void RaiseUDPWaveforms(UDPReceiverShard& shard, const SRE3021PacketSlot* slots, size_t slotCount,
+				void (hurel::sre3021::SRE3021API::* waveformFunc)(const SRE3021WaveformData&, const SRE3021WaveformResult&), const size_t* tickets = nullptr);
+			void RaiseUDPCoincidences(UDPReceiverShard& shard, const SRE3021PacketSlot& slot,
+				void (hurel::sre3021::SRE3021API::* coincidenceFunc)(const SRE3021Coincidence&));
+			void RaiseUDPImageFrame(UDPReceiverShard& shard, const SRE3021PacketSlot& slot,
+				void (hurel::sre3021::SRE3021API::* frameFunc)(const SRE3021ImageFrame&));
+			bool DecodeUDPChannelEvent(UDPReceiverShard& shard, const SRE3021PacketSlot& slot, SRE3021ChannelEvent& outEvent);
 
-			bool OpenUDPServer();
+			bool OpenUDPServer(SRE3021UDPReceiveBackend backend = SRE3021UDPReceiveBackend::SOCKET);
 			void CloseUDPServer();
 
 			//BaseLineCheck
 			void CheckBaseline();
-			size_t AnodeValueBaseline[11][11];
-			size_t AnodeTimingBaseline[11][11];
+			size_t AnodeValueBaseline[11][11] = {};
+			size_t AnodeTimingBaseline[11][11] = {};
 			size_t CathodeValueBaseline = 0;
 			size_t CathodeTimingBaseline = 0;
+			SRE3021ImageDecoder UDPImageDecoder;
+			SRE3021WaveformProcessor UDPWaveformProcessor;
+			SRE3021WaveformFilter UDPWaveformFilter{ SRE3021_WAVEFORM_BASELINE_CELLS, SRE3021_WAVEFORM_RISE_CELLS, SRE3021_WAVEFORM_FLAT_TOP_CELLS, 0.0, true };
+			SRE3021CoincidenceSettings UDPCoincidenceSettings{ SRE3021_COINCIDENCE_WINDOW_TICKS, SRE3021_COINCIDENCE_HOLD_TICKS, 2 };
+			int UDPImageFrameTimeout = SRE3021_IMAGE_FRAME_TIMEOUT_MS;
 			double ProcessImgDataEnergyP1 = 0.321779;
 			double ProcessImgDataEnergyP2 = -4.05354;
 
 			SpectrumEnergy dataSpectrumEnergy;
-			
-			size_t UdpPacketCount = 0;
+			std::mutex mutexDataSpectrumEnergy;
 
-			std::mutex mutexUDPImageBuffer;
 			std::mutex mutexUDPImageBufferRaiserFunc;
-			std::queue<std::vector<unsigned __int8>> UDPImageBuffer;
+			int UDPReceiveBufferSize = SRE3021_UDP_RECEIVE_BUFFER_SIZE;
+			SRE3021UDPReceiveBackend UDPReceiveBackend = SRE3021UDPReceiveBackend::SOCKET;
+			std::string UDPCaptureInterface;
+			void TrackUDPSequence(UDPReceiverShard& shard, const char* data, int dataSize);
+
 			void (hurel::sre3021::SRE3021API::* UDPImageBufferRaiserFunc)(SRE3021ImageData) = nullptr;
+			void (hurel::sre3021::SRE3021API::* UDPImageBufferViewFunc)(const SRE3021ImageView&) = nullptr;
+			void (hurel::sre3021::SRE3021API::* UDPImageBufferCompactFunc)(const SRE3021CompactImageData&) = nullptr;
+			void (hurel::sre3021::SRE3021API::* UDPImageBufferWaveformFunc)(const SRE3021WaveformData&, const SRE3021WaveformResult&) = nullptr;
+			void (hurel::sre3021::SRE3021API::* UDPImageBufferCoincidenceFunc)(const SRE3021Coincidence&) = nullptr;
+			void (hurel::sre3021::SRE3021API::* UDPImageBufferFrameFunc)(const SRE3021ImageFrame&) = nullptr;
+			void (hurel::sre3021::SRE3021API::* UDPImageBufferChannelEventFunc)(const SRE3021ChannelEvent&) = nullptr;
+			std::mutex mutexUDPImageBufferWatermarkFunc;
+			void (hurel::sre3021::SRE3021API::* UDPImageBufferWatermarkFunc)(int, size_t, bool) = &SRE3021API::BasicUDPImageBufferWatermarkFunc;
 			
 			std::mutex mutexBaseLineImageEvents;
-			std::vector<SRE3021ImageData> BaseLineImageEvents;
-			void BaseLineEventCheck(SRE3021ImageData imageData);
+			std::vector<SRE3021CompactImageData> BaseLineImageEvents;
+			void BaseLineEventCheck(const SRE3021CompactImageData& imageData);
 		public:
 			//System Register Configuration
 			SRE3021SysReg ReadSysReg(SRE3021SysRegisterADDR address);
@@ -109,7 +389,39 @@ namespace hurel
 			void StartAcqusition(int HV = 1500, int VTHR = 2435, int VTHR0 = 2457, int Hold_DLY = 300, int VFP0 = 1750);
 			void StopAcqusition();
 
+			/// <summary>
+			/// Function called for every image event. With more than one UDP receiver shard it is called concurrently
+			/// from every shard's image processing thread, so it must be safe to run in parallel.
+			/// </summary>
 			void SetImageProcessingFunc(void (hurel::sre3021::SRE3021API::*func)(SRE3021ImageData));			
+			/// <summary>
+			/// Function called for every image event with a view of the packet, before the image processing function.
+			/// Pixels are decoded only when read. The view is valid only during the call.
+			/// With only a view function set, image events are never fully decoded.
+			/// </summary>
+			void SetImageViewProcessingFunc(void (hurel::sre3021::SRE3021API::*func)(const SRE3021ImageView&));
+			/// <summary>
+			/// Function called for every image event with 16 bit pixels, after the view function and before the image processing function.
+			/// SRE3021CompactImageData::ToImageData converts for code written against SRE3021ImageData.
+			/// </summary>
+			void SetCompactImageProcessingFunc(void (hurel::sre3021::SRE3021API::*func)(const SRE3021CompactImageData&));
+			/// <summary>
+			/// Deliver image events to consumer in batches, on a thread of its own next to the image processing function.
+			/// Every subscription has its own queue of queueCapacity batches. When the consumer falls behind, its batches are dropped
+			/// without slowing down the image processing function or other subscriptions. Returns the subscription id.
+			/// </summary>
+			int SubscribeImageEvents(std::function<void(const std::vector<SRE3021ImageData>&)> consumer, size_t queueCapacity = SRE3021_EVENT_BUS_QUEUE_CAPACITY);
+			/// <summary>
+			/// Stop a subscription after its queued batches are delivered. Must not be called from the consumer.
+			/// </summary>
+			bool UnsubscribeImageEvents(int subscriptionId);
+			SRE3021EventBusStats GetImageEventSubscriptionStats(int subscriptionId);
+			/// <summary>
+			/// Decode recorded image packets into columns with the current baseline, e.g. for offline reprocessing.
+			/// Every packet must be an image packet, the next one starting packetStride bytes after it.
+			/// </summary>
+			void DecodeImagePacketBatch(const unsigned __int8* packets, size_t packetCount, SRE3021ImageColumns& outColumns,
+				size_t packetStride = SRE3021_IMAGE_PACKET_LENGTH);
 			
 			/// <summary>
 			/// Basic ImageProcessing function. Get Image data and make spectrum (energy)
@@ -128,7 +440,9 @@ namespace hurel
 				{
 					for (int Y = 0; Y < 11; ++Y)
 					{
-						if (imgData.AnodeTiming[X][Y] > 250)
+						// Pulse-height events have no timing to cut on, the channels the ASIC triggered are the interactions
+						const bool isInteraction = imgData.AnodeTimingMode == SRE3021AnodeTimingMode::TRIGGER_FLAG ? imgData.AnodeTiming[X][Y] != 0 : imgData.AnodeTiming[X][Y] > 250;
+						if (isInteraction)
 						{
 							++interactionPotins;
 							if (interactionPotins == 3)
@@ -153,16 +467,231 @@ namespace hurel
 				{
 					backgroundNoise = backgroundNoise / 120;
 
+					std::lock_guard<std::mutex> lock(mutexDataSpectrumEnergy);
 					dataSpectrumEnergy.AddEnergy((static_cast<double>(imgData.AnodeValue[interactionX[0]][interactionY[0]]) - backgroundNoise) * ProcessImgDataEnergyP1 + ProcessImgDataEnergyP2);
 				}
 			};
 
+			/// <summary>
+			/// Basic channel event function of the SINGLE_CHANNEL acquisition mode. Adds the energy of the channel to the spectrum.
+			/// </summary>
+			void BasicChannelEventProcessingFunc(const SRE3021ChannelEvent& channelEvent)
+			{
+				if (channelEvent.Pixel < 0)
+				{
+					return;
+				}
+				std::lock_guard<std::mutex> lock(mutexDataSpectrumEnergy);
+				dataSpectrumEnergy.AddEnergy(static_cast<double>(channelEvent.Value) * ProcessImgDataEnergyP1 + ProcessImgDataEnergyP2);
+			};
+
 			SpectrumEnergy GetSpectrum();
 			void ResetSpectrum();
 
 			bool CalibrateEnergySpectrumWith22Na(int minutes = 10);
 			size_t GetUdpPacketCount();
 
+			//Image buffer between UDP listener and image processing thread
+			size_t GetUDPImageBufferOccupancy();
+			size_t GetUDPImageBufferHighWaterMark();
+			size_t GetUDPImageBufferCapacity();
+			size_t GetUDPImageBufferDropCount();
+			void ResetUDPImageBufferHighWaterMark();
+			size_t GetUDPPacketPoolFreeSlotCount();
+
+			/// <summary>
+			/// Number of receive calls per batch size. Index is the number of datagrams returned by one call.
+			/// </summary>
+			std::vector<size_t> GetUDPRecvBatchSizeHistogram();
+
+			/// <summary>
+			/// Number of empty checks the image processing thread spins through before it parks and waits for the UDP listener.
+			/// </summary>
+			void SetUDPImageBufferRaiserSpinBudget(size_t spinCount);
+
+			/// <summary>
+			/// Image packets each shard's image buffer can hold, rounded up to a power of two. Applied when the UDP server opens
+			/// in InitiateSRE3021API. Together with the packet pool this bounds the memory held for queued packets.
+			/// </summary>
+			void SetUDPImageBufferCapacity(size_t packetCount);
+			/// <summary>
+			/// What the UDP listener does when the image buffer is full. Applied when the UDP server opens in InitiateSRE3021API.
+			/// </summary>
+			void SetUDPBackpressurePolicy(SRE3021UDPBackpressurePolicy policy);
+			SRE3021UDPBackpressurePolicy GetUDPBackpressurePolicy();
+			SRE3021UDPDropStats GetUDPDropStats();
+			/// <summary>
+			/// Occupancy fractions of the image buffer that fire the watermark function: once when rising to highFraction,
+			/// again when falling back to lowFraction.
+			/// </summary>
+			void SetUDPImageBufferWatermarks(double highFraction, double lowFraction);
+			/// <summary>
+			/// Function called from the image processing thread when its image buffer crosses a watermark.
+			/// Arguments are the shard index, the occupancy and whether the high watermark was reached. nullptr disables it.
+			/// </summary>
+			void SetUDPImageBufferWatermarkFunc(void (hurel::sre3021::SRE3021API::* func)(int, size_t, bool));
+			/// <summary>
+			/// Default watermark function, prints the crossing.
+			/// </summary>
+			void BasicUDPImageBufferWatermarkFunc(int shardIndex, size_t occupancy, bool isAboveWatermark);
+			SRE3021DoorbellStats GetUDPImageBufferRaiserWaitStats();
+			void ResetUDPImageBufferRaiserWaitStats();
+
+			//Packet counter tracking of every datagram on the image port
+			SRE3021SequenceStats GetUDPSequenceStats(int systemNumber);
+			SRE3021SequenceStats GetUDPSequenceTotalStats();
+			std::vector<SRE3021SequenceLossEvent> GetUDPSequenceLossEvents();
+			/// <summary>
+			/// Latest header time stamp of a SystemNumber, extended to 64 bits, in hardware ticks. 0 before its first packet.
+			/// Events divided by the difference of two readings give the rate in hardware time.
+			/// </summary>
+			unsigned long long GetUDPHardwareTimestamp(int systemNumber);
+
+			/// <summary>
+			/// Kernel receive buffer requested for the image port. Applied when the UDP server opens in InitiateSRE3021API.
+			/// </summary>
+			/// <param name="bytes">requested size, the kernel may grant a different size</param>
+			void SetUDPReceiveBufferSize(int bytes);
+			/// <summary>
+			/// Receive buffer size the kernel actually granted, as reported by SO_RCVBUF
+			/// </summary>
+			int GetUDPReceiveBufferSize();
+			/// <summary>
+			/// Image port datagrams dropped by the kernel before they reached the socket. Always 0 if not supported,
+			/// which includes the IO_URING receive backend.
+			/// </summary>
+			size_t GetUDPKernelDropCount();
+			bool IsUDPKernelDropCountSupported();
+
+			/// <summary>
+			/// Receive engine for the image port, used when the UDP server opens in InitiateSRE3021API.
+			/// Falls back to SOCKET when the backend is not available on this system.
+			/// </summary>
+			void SetUDPReceiveBackend(SRE3021UDPReceiveBackend backend);
+			/// <summary>
+			/// Receive engine the running UDP listener actually uses
+			/// </summary>
+			SRE3021UDPReceiveBackend GetUDPReceiveBackend();
+			/// <summary>
+			/// Network interface the SRE3021 is connected to, used by the PACKET_MMAP backend
+			/// </summary>
+			void SetUDPCaptureInterface(const std::string& interfaceName);
+
+			/// <summary>
+			/// Number of UDP listener and image processing thread pairs sharing the image port through SO_REUSEPORT,
+			/// used when the UDP server opens in InitiateSRE3021API. Datagrams are steered by the header SystemNumber so
+			/// each detector stays on one shard. Clamped to 1 where SO_REUSEPORT is not available.
+			/// </summary>
+			void SetUDPReceiverShardCount(int shardCount);
+			int GetUDPReceiverShardCount();
+			/// <summary>
+			/// Datagrams received on the image port by each shard
+			/// </summary>
+			std::vector<size_t> GetUDPShardPacketCounts();
+			/// <summary>
+			/// Packets per second received by each shard since the previous call
+			/// </summary>
+			std::vector<double> GetUDPShardPacketRates();
+
+			/// <summary>
+			/// Threads per shard that decode image packets in parallel in place of the single image processing thread,
+			/// used when the UDP server opens in InitiateSRE3021API. 0 keeps the single image processing thread.
+			/// The view function always runs on the decode workers concurrently.
+			/// </summary>
+			void SetUDPDecodeWorkerCount(int workerCount);
+			int GetUDPDecodeWorkerCount();
+			/// <summary>
+			/// How decode workers hand events to the compact and image processing functions, used when the UDP server opens.
+			/// With ARRIVAL the functions are called by one worker at a time per shard, in arrival order.
+			/// TRIGGER_TIME acquisition always uses ARRIVAL, the coincidence finder takes a packet older than the ones it merged as late.
+			/// </summary>
+			void SetUDPDecodeOrdering(SRE3021UDPDecodeOrdering ordering);
+			SRE3021UDPDecodeOrdering GetUDPDecodeOrdering();
+
+			/// <summary>
+			/// Event packets accepted on the image port, used when the UDP server opens in InitiateSRE3021API.
+			/// The SRE3021 firmware must be set up to send that packet type. The view function is called for image packets only.
+			/// </summary>
+			void SetAcquisitionMode(SRE3021AcquisitionMode mode);
+			SRE3021AcquisitionMode GetAcquisitionMode();
+			/// <summary>
+			/// Events received on the image port, counted by the UDP listener from the packets it accepted
+			/// </summary>
+			size_t GetUDPEventCount();
+			/// <summary>
+			/// Events per accepted datagram since the UDP server opened, 1 for image packets
+			/// </summary>
+			double GetUDPEventsPerDatagram();
+
+			/// <summary>
+			/// Waveform function for the WAVEFORM acquisition mode, called with each pipeline sampling packet and its filter result.
+			/// Without decode workers, or when they do not hand events over in arrival order, waveforms are filtered
+			/// SRE3021_WAVEFORM_LANE_COUNT at a time.
+			/// </summary>
+			void SetWaveformProcessingFunc(void (hurel::sre3021::SRE3021API::* func)(const SRE3021WaveformData&, const SRE3021WaveformResult&));
+			/// <summary>
+			/// Shaping filter of the WAVEFORM acquisition mode, used when the UDP server opens
+			/// </summary>
+			void SetWaveformFilter(const SRE3021WaveformFilter& filter);
+			SRE3021WaveformFilter GetWaveformFilter();
+
+			/// <summary>
+			/// Coincidence function for the TRIGGER_TIME acquisition mode, called by one thread at a time per shard.
+			/// Coincidences are found per shard, so with several shards only triggers of the same sender are grouped.
+			/// </summary>
+			void SetCoincidenceProcessingFunc(void (hurel::sre3021::SRE3021API::* func)(const SRE3021Coincidence&));
+			/// <summary>
+			/// Coincidence window and hold time of the TRIGGER_TIME acquisition mode, used when the UDP server opens
+			/// </summary>
+			void SetCoincidenceSettings(const SRE3021CoincidenceSettings& settings);
+			SRE3021CoincidenceSettings GetCoincidenceSettings();
+			/// <summary>
+			/// Trigger groups by multiplicity since the UDP server opened, singles included, summed over shards
+			/// </summary>
+			std::vector<size_t> GetCoincidenceMultiplicityHistogram();
+			/// <summary>
+			/// Triggers that arrived after the merged stream had passed them, not part of any coincidence
+			/// </summary>
+			size_t GetCoincidenceLateTriggerCount();
+
+			/// <summary>
+			/// Counts of each ASIC channel in the COUNTING acquisition mode since the UDP server opened, summed over shards
+			/// </summary>
+			std::vector<unsigned long long> GetCountingChannelCounts();
+			/// <summary>
+			/// Counts per second of each ASIC channel since the last call to GetCountingChannelRates or GetCountingPixelRates
+			/// </summary>
+			std::vector<double> GetCountingChannelRates();
+			/// <summary>
+			/// GetCountingChannelRates of the anode pixels, indexed Y * 11 + X through ASICChannelNumber
+			/// </summary>
+			std::vector<double> GetCountingPixelRates();
+			size_t GetCountingFrameCount();
+
+			/// <summary>
+			/// Image frame function for the IMAGE_FRAME acquisition mode, called with images not in the 514 byte SRE3021 layout
+			/// </summary>
+			void SetImageFrameProcessingFunc(void (hurel::sre3021::SRE3021API::* func)(const SRE3021ImageFrame&));
+			/// <summary>
+			/// Time an image split over several packets may take to arrive completely, used when the UDP server opens
+			/// </summary>
+			void SetImageFrameTimeout(int milliseconds);
+			int GetImageFrameTimeout();
+			/// <summary>
+			/// Reassembly counters of the IMAGE_FRAME acquisition mode, summed over shards
+			/// </summary>
+			SRE3021ImageFrameStats GetImageFrameStats();
+
+			/// <summary>
+			/// Read out only one ASIC channel (CFG_FIXED_CH), 0 to 127. Any other channel turns single channel readout off.
+			/// Packets of a single channel readout are received in the SINGLE_CHANNEL acquisition mode.
+			/// </summary>
+			void SetSingleChannelReadout(int channel);
+			/// <summary>
+			/// Channel event function for the SINGLE_CHANNEL acquisition mode, BasicChannelEventProcessingFunc by default
+			/// </summary>
+			void SetChannelEventProcessingFunc(void (hurel::sre3021::SRE3021API::* func)(const SRE3021ChannelEvent&));
+
 		};
 	};
 };
@@ -0,0 +1,191 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021CoincidenceFinder.h"
+
+#include <limits>
+
+using namespace hurel::sre3021;
+
+// Consumed records are moved out of a queue once there are this many
+static const size_t CompactThreshold = 1024;
+
+hurel::sre3021::SRE3021CoincidenceFinder::SRE3021CoincidenceFinder()
+	: settings{ SRE3021_COINCIDENCE_WINDOW_TICKS, SRE3021_COINCIDENCE_HOLD_TICKS, 2 }
+{
+	Reset();
+}
+
+void hurel::sre3021::SRE3021CoincidenceFinder::SetSettings(const SRE3021CoincidenceSettings& newSettings)
+{
+	settings = newSettings;
+	if (settings.MinMultiplicity < 1)
+	{
+		settings.MinMultiplicity = 1;
+	}
+}
+
+void hurel::sre3021::SRE3021CoincidenceFinder::Reset()
+{
+	sources = std::vector<SourceQueue>(SRE3021_COINCIDENCE_SOURCE_COUNT, SourceQueue{ std::vector<SRE3021TriggerRecord>(), 0, 0, false });
+	activeSources.clear();
+	firstTimestamp = 0;
+	latestTimestamp = 0;
+	merged.clear();
+	groupStart = 0;
+	mergedTimestamp = 0;
+	isMerged = false;
+	isStarted = false;
+	multiplicityHistogram = std::vector<size_t>(SRE3021_COINCIDENCE_MAX_MULTIPLICITY + 1, 0);
+	lateRecordCount = 0;
+}
+
+void hurel::sre3021::SRE3021CoincidenceFinder::Add(const SRE3021TriggerRecord& record)
+{
+	if (activeSources.empty() || record.Timestamp < firstTimestamp)
+	{
+		firstTimestamp = record.Timestamp;
+	}
+	if (isMerged && record.Timestamp < mergedTimestamp)
+	{
+		++lateRecordCount;
+		return;
+	}
+	SourceQueue& source = sources[record.SourceId & (SRE3021_COINCIDENCE_SOURCE_COUNT - 1)];
+	if (!source.IsActive)
+	{
+		source.IsActive = true;
+		activeSources.push_back(record.SourceId & (SRE3021_COINCIDENCE_SOURCE_COUNT - 1));
+	}
+	if (source.Head >= CompactThreshold && source.Head * 2 >= source.Records.size())
+	{
+		source.Records.erase(source.Records.begin(), source.Records.begin() + source.Head);
+		source.Head = 0;
+	}
+
+	// Records of a source are nearly in time order, sort a late one in from the back
+	source.Records.push_back(record);
+	size_t i = source.Records.size() - 1;
+	while (i > source.Head && source.Records[i - 1].Timestamp > record.Timestamp)
+	{
+		source.Records[i] = source.Records[i - 1];
+		--i;
+	}
+	source.Records[i] = record;
+
+	if (record.Timestamp > source.LastTimestamp)
+	{
+		source.LastTimestamp = record.Timestamp;
+	}
+	if (record.Timestamp > latestTimestamp)
+	{
+		latestTimestamp = record.Timestamp;
+	}
+	if (latestTimestamp - firstTimestamp >= settings.HoldTicks)
+	{
+		isStarted = true;
+	}
+}
+
+// Every record up to the frontier has arrived: a source has sent everything up to its newest record,
+// and a quiet source is given up on HoldTicks behind the newest record of any source
+unsigned long long hurel::sre3021::SRE3021CoincidenceFinder::MergeFrontier() const
+{
+	const unsigned long long holdFrontier = latestTimestamp > settings.HoldTicks ? latestTimestamp - settings.HoldTicks : 0;
+	unsigned long long frontier = std::numeric_limits<unsigned long long>::max();
+	for (int sourceId : activeSources)
+	{
+		const unsigned long long sourceFrontier = sources[sourceId].LastTimestamp > holdFrontier ? sources[sourceId].LastTimestamp : holdFrontier;
+		if (sourceFrontier < frontier)
+		{
+			frontier = sourceFrontier;
+		}
+	}
+	return activeSources.empty() ? 0 : frontier;
+}
+
+size_t hurel::sre3021::SRE3021CoincidenceFinder::FindCoincidences(std::vector<SRE3021Coincidence>& outCoincidences, bool isFlush)
+{
+	// Records handed out by the last call are no longer referenced
+	merged.erase(merged.begin(), merged.begin() + groupStart);
+	groupStart = 0;
+	if (!isStarted && !isFlush)
+	{
+		return 0;
+	}
+
+	const unsigned long long frontier = isFlush ? std::numeric_limits<unsigned long long>::max() : MergeFrontier();
+
+	// k-way merge of the source queues, a linear scan as there are only a few sources
+	while (true)
+	{
+		SourceQueue* next = nullptr;
+		for (int sourceId : activeSources)
+		{
+			SourceQueue& source = sources[sourceId];
+			if (source.Head < source.Records.size()
+				&& (next == nullptr || source.Records[source.Head].Timestamp < next->Records[next->Head].Timestamp))
+			{
+				next = &source;
+			}
+		}
+		if (next == nullptr || next->Records[next->Head].Timestamp > frontier)
+		{
+			break;
+		}
+		merged.push_back(next->Records[next->Head]);
+		mergedTimestamp = merged.back().Timestamp;
+		isMerged = true;
+		if (++next->Head == next->Records.size())
+		{
+			next->Records.clear();
+			next->Head = 0;
+		}
+	}
+
+	// A group is complete once its window lies behind the frontier
+	const size_t coincidenceCount = outCoincidences.size();
+	while (groupStart < merged.size())
+	{
+		const unsigned long long start = merged[groupStart].Timestamp;
+		if (!isFlush && (frontier < settings.WindowTicks || start > frontier - settings.WindowTicks))
+		{
+			break;
+		}
+		size_t end = groupStart + 1;
+		while (end < merged.size() && merged[end].Timestamp - start <= settings.WindowTicks)
+		{
+			++end;
+		}
+		const int multiplicity = static_cast<int>(end - groupStart);
+		++multiplicityHistogram[multiplicity < SRE3021_COINCIDENCE_MAX_MULTIPLICITY ? multiplicity : SRE3021_COINCIDENCE_MAX_MULTIPLICITY];
+		if (multiplicity >= settings.MinMultiplicity)
+		{
+			outCoincidences.push_back(SRE3021Coincidence{ start, merged[end - 1].Timestamp - start, multiplicity, &merged[groupStart] });
+		}
+		groupStart = end;
+	}
+	return outCoincidences.size() - coincidenceCount;
+}
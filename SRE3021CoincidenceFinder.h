@@ -0,0 +1,133 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "SRE3021Types.h"
+
+#define SRE3021_COINCIDENCE_SOURCE_COUNT (256)
+// Multiplicities at or above this share the last histogram bin
+#define SRE3021_COINCIDENCE_MAX_MULTIPLICITY (64)
+#define SRE3021_COINCIDENCE_WINDOW_TICKS (10)
+#define SRE3021_COINCIDENCE_HOLD_TICKS (100000)
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// One trigger of a trigger time packet. Timestamp is in hardware ticks, extended to 64 bits.
+        /// </summary>
+        struct SRE3021TriggerRecord {
+            unsigned long long Timestamp; int SourceId; int ChannelId;
+        };
+
+        /// <summary>
+        /// Triggers within WindowTicks of the first one, in time order. Duration is from the first to the last trigger.
+        /// Records points into the finder and stays valid until the next FindCoincidences or Reset.
+        /// </summary>
+        struct SRE3021Coincidence {
+            unsigned long long Timestamp; unsigned long long Duration; int Multiplicity; const SRE3021TriggerRecord* Records;
+        };
+
+        /// <summary>
+        /// WindowTicks is the coincidence window from the first trigger of a group. A source without triggers holds back
+        /// the merge for at most HoldTicks behind the newest trigger of any source. Groups below MinMultiplicity are only counted.
+        /// </summary>
+        struct SRE3021CoincidenceSettings {
+            unsigned long long WindowTicks; unsigned long long HoldTicks; int MinMultiplicity;
+        };
+
+        /// <summary>
+        /// Groups trigger records into coincidences without sorting the whole stream.
+        /// Records are queued per source, where they arrive almost in time order, and the sources are merged up to the time
+        /// every source has been heard up to. Merging starts HoldTicks after the first record, when the sources are known,
+        /// a source first heard later may lose its first records. A record older than the merged stream is late and dropped,
+        /// so packets have to be added in the order they arrived, not in the order several threads finish decoding them.
+        /// Not thread safe, one thread at a time calls Add and FindCoincidences.
+        /// </summary>
+        class SRE3021CoincidenceFinder
+        {
+        public:
+            SRE3021CoincidenceFinder();
+
+            void SetSettings(const SRE3021CoincidenceSettings& settings);
+
+            SRE3021CoincidenceSettings GetSettings() const
+            {
+                return settings;
+            };
+
+            /// <summary>
+            /// Drop queued records and clear the histogram and counters
+            /// </summary>
+            void Reset();
+
+            void Add(const SRE3021TriggerRecord& record);
+
+            /// <summary>
+            /// Merge the queued records that no later record can precede and append the complete coincidences.
+            /// With isFlush every queued record is merged and grouped.
+            /// </summary>
+            /// <returns>number of coincidences appended</returns>
+            size_t FindCoincidences(std::vector<SRE3021Coincidence>& outCoincidences, bool isFlush = false);
+
+            /// <summary>
+            /// Groups by multiplicity, singles included, index 0 unused
+            /// </summary>
+            std::vector<size_t> GetMultiplicityHistogram() const
+            {
+                return multiplicityHistogram;
+            };
+
+            size_t GetLateRecordCount() const
+            {
+                return lateRecordCount;
+            };
+
+        private:
+            struct SourceQueue {
+                std::vector<SRE3021TriggerRecord> Records; size_t Head; unsigned long long LastTimestamp; bool IsActive;
+            };
+
+            unsigned long long MergeFrontier() const;
+
+            SRE3021CoincidenceSettings settings;
+            std::vector<SourceQueue> sources;
+            std::vector<int> activeSources;
+            unsigned long long firstTimestamp = 0;
+            unsigned long long latestTimestamp = 0;
+            bool isStarted = false;
+            // Merged records in time order, grouped from groupStart on
+            std::vector<SRE3021TriggerRecord> merged;
+            size_t groupStart = 0;
+            unsigned long long mergedTimestamp = 0;
+            bool isMerged = false;
+            std::vector<size_t> multiplicityHistogram;
+            size_t lateRecordCount = 0;
+        };
+    };
+};
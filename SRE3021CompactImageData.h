@@ -0,0 +1,103 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include "SRE3021Types.h"
+
+#define SRE3021_COMPACT_ROW_STRIDE (16)
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Image event with 16 bit pixels, about a third of the size of SRE3021ImageData.
+        /// Energy and timing are separate planes indexed [Y][X] like the packet. Each row is padded with zeros
+        /// to 16 values, 32 bytes, so one row fits one AVX2 register. Baseline subtracted values saturate at the __int16 range.
+        /// Timestamp, ReceiveTime and AnodeTimingMode are as in SRE3021ImageData.
+        /// </summary>
+        struct SRE3021CompactImageData {
+            __int16 AnodeValue[11][SRE3021_COMPACT_ROW_STRIDE];
+            __int16 AnodeTiming[11][SRE3021_COMPACT_ROW_STRIDE];
+            __int32 CathodeValue;
+            __int32 CathodeTiming;
+            unsigned long long Timestamp;
+            long long ReceiveTime;
+            SRE3021AnodeTimingMode AnodeTimingMode = SRE3021AnodeTimingMode::PULSE_TIMING;
+
+            __int16 GetAnodeValue(int X, int Y) const
+            {
+                return AnodeValue[Y][X];
+            };
+
+            __int16 GetAnodeTiming(int X, int Y) const
+            {
+                return AnodeTiming[Y][X];
+            };
+
+            SRE3021ImageData ToImageData() const
+            {
+                SRE3021ImageData imageData;
+                imageData.CathodeValue = CathodeValue;
+                imageData.CathodeTiming = CathodeTiming;
+                imageData.Timestamp = Timestamp;
+                imageData.ReceiveTime = ReceiveTime;
+                imageData.AnodeTimingMode = AnodeTimingMode;
+                for (int X = 0; X < 11; ++X)
+                {
+                    for (int Y = 0; Y < 11; ++Y)
+                    {
+                        imageData.AnodeValue[X][Y] = AnodeValue[Y][X];
+                        imageData.AnodeTiming[X][Y] = AnodeTiming[Y][X];
+                    }
+                }
+                return imageData;
+            };
+
+            static SRE3021CompactImageData FromImageData(const SRE3021ImageData& imageData)
+            {
+                SRE3021CompactImageData compact = {};
+                compact.CathodeValue = static_cast<__int32>(imageData.CathodeValue);
+                compact.CathodeTiming = static_cast<__int32>(imageData.CathodeTiming);
+                compact.Timestamp = imageData.Timestamp;
+                compact.ReceiveTime = imageData.ReceiveTime;
+                compact.AnodeTimingMode = imageData.AnodeTimingMode;
+                for (int X = 0; X < 11; ++X)
+                {
+                    for (int Y = 0; Y < 11; ++Y)
+                    {
+                        compact.AnodeValue[Y][X] = Saturate(imageData.AnodeValue[X][Y]);
+                        compact.AnodeTiming[Y][X] = Saturate(imageData.AnodeTiming[X][Y]);
+                    }
+                }
+                return compact;
+            };
+
+            static __int16 Saturate(long long value)
+            {
+                return static_cast<__int16>(value < -32768 ? -32768 : (value > 32767 ? 32767 : value));
+            };
+        };
+    };
+};
@@ -0,0 +1,97 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021CountingAccumulator.h"
+
+#include "SRE3021HeaderCodec.h"
+
+using namespace hurel::sre3021;
+
+hurel::sre3021::SRE3021CountingAccumulator::SRE3021CountingAccumulator()
+{
+	Reset();
+}
+
+void hurel::sre3021::SRE3021CountingAccumulator::Reset()
+{
+	for (int i = 0; i < SRE3021_COUNTING_FRAME_COUNTER_COUNT; ++i)
+	{
+		counts[i].store(0, std::memory_order_relaxed);
+		overflowCounts[i].store(0, std::memory_order_relaxed);
+	}
+	frameCount.store(0, std::memory_order_relaxed);
+}
+
+SRE3021PacketDecodeStatus hurel::sre3021::SRE3021CountingAccumulator::Accumulate(const unsigned __int8* data, int dataLength)
+{
+	if (dataLength < SRE3021_COUNTING_FRAME_DATA_LENGTH)
+	{
+		return SRE3021PacketDecodeStatus::ERROR_DATA_LENGTH;
+	}
+	if (data[0] != 0)
+	{
+		return SRE3021PacketDecodeStatus::SUCCESS;
+	}
+
+	const unsigned __int8* group = data + 1;
+	for (int asic = 0; asic < SRE3021_COUNTING_FRAME_ASIC_COUNT; ++asic)
+	{
+		const unsigned __int8* flags = group + SRE3021_COUNTING_FRAME_COUNTERS_PER_ASIC * 2;
+		std::atomic<unsigned long long>* groupCounts = counts + asic * SRE3021_COUNTING_FRAME_COUNTERS_PER_ASIC;
+		// Relaxed load and store of a single writer, plain moves on x86
+		for (int i = 0; i < SRE3021_COUNTING_FRAME_COUNTERS_PER_ASIC; ++i)
+		{
+			groupCounts[i].store(groupCounts[i].load(std::memory_order_relaxed) + SRE3021HeaderCodec::ReadBigEndian16(group + i * 2), std::memory_order_relaxed);
+		}
+		for (int j = 0; j < SRE3021_COUNTING_FRAME_FLAG_BYTES_PER_ASIC; ++j)
+		{
+			// Overflows are rare, skip the flag bytes without any
+			unsigned int flagByte = flags[j];
+			for (int bit = 0; flagByte != 0; ++bit, flagByte >>= 1)
+			{
+				if ((flagByte & 1) == 0)
+				{
+					continue;
+				}
+				const int counter = asic * SRE3021_COUNTING_FRAME_COUNTERS_PER_ASIC + j * 8 + bit;
+				counts[counter].store(counts[counter].load(std::memory_order_relaxed) + SRE3021_COUNTING_FRAME_OVERFLOW_COUNTS, std::memory_order_relaxed);
+				overflowCounts[counter].store(overflowCounts[counter].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			}
+		}
+		group = flags + SRE3021_COUNTING_FRAME_FLAG_BYTES_PER_ASIC;
+	}
+	frameCount.store(frameCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	return SRE3021PacketDecodeStatus::SUCCESS;
+}
+
+std::vector<unsigned long long> hurel::sre3021::SRE3021CountingAccumulator::GetCounts() const
+{
+	std::vector<unsigned long long> result(SRE3021_COUNTING_FRAME_COUNTER_COUNT);
+	for (int i = 0; i < SRE3021_COUNTING_FRAME_COUNTER_COUNT; ++i)
+	{
+		result[i] = counts[i].load(std::memory_order_relaxed);
+	}
+	return result;
+}
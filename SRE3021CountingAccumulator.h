@@ -0,0 +1,95 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "SRE3021Types.h"
+
+// Counting frame data: a DataGroup byte, then per ASIC 64 counters of 2 bytes and 8 bytes of overflow flags.
+// The overflow flag of counter i is bit i % 8 of flag byte i / 8.
+#define SRE3021_COUNTING_FRAME_ASIC_COUNT (7)
+#define SRE3021_COUNTING_FRAME_COUNTERS_PER_ASIC (64)
+#define SRE3021_COUNTING_FRAME_FLAG_BYTES_PER_ASIC (SRE3021_COUNTING_FRAME_COUNTERS_PER_ASIC / 8)
+#define SRE3021_COUNTING_FRAME_COUNTER_COUNT (SRE3021_COUNTING_FRAME_ASIC_COUNT * SRE3021_COUNTING_FRAME_COUNTERS_PER_ASIC)
+#define SRE3021_COUNTING_FRAME_DATA_LENGTH (1 + SRE3021_COUNTING_FRAME_ASIC_COUNT * (SRE3021_COUNTING_FRAME_COUNTERS_PER_ASIC * 2 + SRE3021_COUNTING_FRAME_FLAG_BYTES_PER_ASIC))
+// A set overflow flag means the 16 bit counter wrapped during the frame
+#define SRE3021_COUNTING_FRAME_OVERFLOW_COUNTS (0x10000)
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Adds counting frames to 64 bit accumulators, one per counter of the frame.
+        /// Counter i of a frame is counter i % 64 of counter group i / 64. The SRE3021 sends its ASIC channels in data group 0,
+        /// so counter i is ASIC channel i. Frames of other data groups are not accumulated.
+        /// A counter with its overflow flag set is taken to have wrapped once, its count is a lower bound, see GetOverflowCount.
+        /// Accumulate is called by one thread, the getters may be called from any thread.
+        /// </summary>
+        class SRE3021CountingAccumulator
+        {
+        public:
+            SRE3021CountingAccumulator();
+
+            /// <summary>
+            /// Clear the counts. Not thread safe against Accumulate.
+            /// </summary>
+            void Reset();
+
+            /// <summary>
+            /// Add the Packet Data field of a counting frame packet
+            /// </summary>
+            SRE3021PacketDecodeStatus Accumulate(const unsigned __int8* data, int dataLength);
+
+            unsigned long long GetCount(int counter) const
+            {
+                return counts[counter].load(std::memory_order_relaxed);
+            };
+
+            /// <summary>
+            /// Frames in which the counter overflowed
+            /// </summary>
+            unsigned long long GetOverflowCount(int counter) const
+            {
+                return overflowCounts[counter].load(std::memory_order_relaxed);
+            };
+
+            std::vector<unsigned long long> GetCounts() const;
+
+            size_t GetFrameCount() const
+            {
+                return frameCount.load(std::memory_order_relaxed);
+            };
+
+        private:
+            // Only Accumulate writes, readers see each accumulator whole
+            std::atomic<unsigned long long> counts[SRE3021_COUNTING_FRAME_COUNTER_COUNT];
+            std::atomic<unsigned long long> overflowCounts[SRE3021_COUNTING_FRAME_COUNTER_COUNT];
+            std::atomic<size_t> frameCount;
+        };
+    };
+};
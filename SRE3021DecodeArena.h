@@ -0,0 +1,107 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Fixed block of memory handed out front to back and given back all at once with Reset.
+        /// Decoded packet data is placed here instead of being allocated per packet. Pointers stay valid until Reset.
+        /// Used by one thread.
+        /// </summary>
+        class SRE3021DecodeArena
+        {
+        public:
+            SRE3021DecodeArena() {};
+
+            explicit SRE3021DecodeArena(size_t capacityBytes)
+            {
+                Allocate(capacityBytes);
+            };
+
+            /// <summary>
+            /// Allocate the block up front. Everything taken before is invalidated.
+            /// </summary>
+            void Allocate(size_t capacityBytes)
+            {
+                // Stored as max_align_t so every type taken from the arena can be aligned inside the block
+                Storage.assign((capacityBytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t), std::max_align_t());
+                used = 0;
+            };
+
+            /// <summary>
+            /// Take room for count objects of T, which must be trivially destructible. Returns nullptr when the arena is full.
+            /// </summary>
+            template <typename T>
+            T* Take(size_t count)
+            {
+                size_t offset = (used + alignof(T) - 1) / alignof(T) * alignof(T);
+                if (offset > GetCapacity() || count > (GetCapacity() - offset) / sizeof(T))
+                {
+                    return nullptr;
+                }
+                used = offset + count * sizeof(T);
+                return reinterpret_cast<T*>(reinterpret_cast<unsigned __int8*>(Storage.data()) + offset);
+            };
+
+            /// <summary>
+            /// Give back everything taken since the last Reset
+            /// </summary>
+            void Reset()
+            {
+                used = 0;
+            };
+
+            /// <summary>
+            /// Give back everything taken after GetUsed returned used
+            /// </summary>
+            void Rewind(size_t used)
+            {
+                if (used < this->used)
+                {
+                    this->used = used;
+                }
+            };
+
+            size_t GetUsed() const
+            {
+                return used;
+            };
+
+            size_t GetCapacity() const
+            {
+                return Storage.size() * sizeof(std::max_align_t);
+            };
+
+        private:
+            std::vector<std::max_align_t> Storage;
+            size_t used = 0;
+        };
+    };
+};
@@ -0,0 +1,175 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Wait statistics of a SRE3021Doorbell consumer.
+        /// </summary>
+        struct SRE3021DoorbellStats {
+            size_t SpinBudget; size_t ParkCount; size_t RingWakeCount; double SpinSeconds; double ParkedSeconds; double MeanWakeLatencyMicroseconds; double MaxWakeLatencyMicroseconds;
+        };
+
+        /// <summary>
+        /// Wakes one consumer thread that waits for work produced by other threads.
+        /// The consumer spins for a bounded number of checks and then parks on a condition variable.
+        /// Ring is cheap while the consumer is not parked, it only takes the lock to wake a parked consumer.
+        /// </summary>
+        class SRE3021Doorbell
+        {
+        public:
+            SRE3021Doorbell() {};
+            SRE3021Doorbell(size_t spinCount)
+            {
+                SetSpinBudget(spinCount);
+            };
+
+            void SetSpinBudget(size_t spinCount)
+            {
+                spinBudget.store(spinCount, std::memory_order_relaxed);
+            };
+
+            /// <summary>
+            /// Consumer side. Returns when ready() is true or the timeout expired while parked.
+            /// ready() must observe the producer's writes with acquire semantics (e.g. SRE3021MPMCRingBuffer::Empty).
+            /// </summary>
+            template <typename Ready>
+            void Wait(Ready ready, std::chrono::milliseconds timeout)
+            {
+                const auto spinStart = std::chrono::steady_clock::now();
+                const size_t budget = spinBudget.load(std::memory_order_relaxed);
+                for (size_t i = 0; i < budget; ++i)
+                {
+                    if (ready())
+                    {
+                        AddDuration(spinNanoseconds, spinStart, std::chrono::steady_clock::now());
+                        return;
+                    }
+                    std::this_thread::yield();
+                }
+                const auto parkStart = std::chrono::steady_clock::now();
+                AddDuration(spinNanoseconds, spinStart, parkStart);
+
+                std::unique_lock<std::mutex> lock(mutex);
+                parked.store(true, std::memory_order_relaxed);
+                // Pairs with the fence in Ring, either the producer sees parked or we see its item
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!ready())
+                {
+                    parkCount.store(parkCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    rung = false;
+                    condition.wait_for(lock, timeout, [this] { return rung; });
+                    if (rung)
+                    {
+                        const auto wakeTime = std::chrono::steady_clock::now();
+                        const size_t latency = static_cast<size_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(wakeTime - ringTime).count());
+                        ringWakeCount.store(ringWakeCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                        wakeLatencyNanoseconds.store(wakeLatencyNanoseconds.load(std::memory_order_relaxed) + latency, std::memory_order_relaxed);
+                        if (latency > maxWakeLatencyNanoseconds.load(std::memory_order_relaxed))
+                        {
+                            maxWakeLatencyNanoseconds.store(latency, std::memory_order_relaxed);
+                        }
+                    }
+                }
+                parked.store(false, std::memory_order_relaxed);
+                lock.unlock();
+                AddDuration(parkedNanoseconds, parkStart, std::chrono::steady_clock::now());
+            };
+
+            /// <summary>
+            /// Producer side. Call after publishing work. Safe to call from any thread.
+            /// </summary>
+            void Ring()
+            {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!parked.load(std::memory_order_relaxed))
+                {
+                    return;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    rung = true;
+                    ringTime = std::chrono::steady_clock::now();
+                }
+                condition.notify_one();
+            };
+
+            SRE3021DoorbellStats GetStats() const
+            {
+                SRE3021DoorbellStats stats;
+                stats.SpinBudget = spinBudget.load(std::memory_order_relaxed);
+                stats.ParkCount = parkCount.load(std::memory_order_relaxed);
+                stats.RingWakeCount = ringWakeCount.load(std::memory_order_relaxed);
+                stats.SpinSeconds = spinNanoseconds.load(std::memory_order_relaxed) * 1e-9;
+                stats.ParkedSeconds = parkedNanoseconds.load(std::memory_order_relaxed) * 1e-9;
+                stats.MeanWakeLatencyMicroseconds = stats.RingWakeCount == 0 ? 0 : wakeLatencyNanoseconds.load(std::memory_order_relaxed) * 1e-3 / stats.RingWakeCount;
+                stats.MaxWakeLatencyMicroseconds = maxWakeLatencyNanoseconds.load(std::memory_order_relaxed) * 1e-3;
+                return stats;
+            };
+
+            /// <summary>
+            /// Clear the statistics. The spin budget is kept.
+            /// </summary>
+            void ResetStats()
+            {
+                parkCount.store(0, std::memory_order_relaxed);
+                ringWakeCount.store(0, std::memory_order_relaxed);
+                spinNanoseconds.store(0, std::memory_order_relaxed);
+                parkedNanoseconds.store(0, std::memory_order_relaxed);
+                wakeLatencyNanoseconds.store(0, std::memory_order_relaxed);
+                maxWakeLatencyNanoseconds.store(0, std::memory_order_relaxed);
+            };
+
+        private:
+            static void AddDuration(std::atomic<size_t>& total, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+            {
+                const size_t elapsed = static_cast<size_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+                total.store(total.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+            };
+
+            std::mutex mutex;
+            std::condition_variable condition;
+            bool rung = false;
+            std::chrono::steady_clock::time_point ringTime;
+            std::atomic<bool> parked{ false };
+
+            std::atomic<size_t> spinBudget{ 0 };
+            std::atomic<size_t> parkCount{ 0 };
+            std::atomic<size_t> ringWakeCount{ 0 };
+            std::atomic<size_t> spinNanoseconds{ 0 };
+            std::atomic<size_t> parkedNanoseconds{ 0 };
+            std::atomic<size_t> wakeLatencyNanoseconds{ 0 };
+            std::atomic<size_t> maxWakeLatencyNanoseconds{ 0 };
+        };
+    };
+};
@@ -0,0 +1,333 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SRE3021Doorbell.h"
+
+// Batches a subscriber may have waiting before new ones are dropped
+#define SRE3021_EVENT_BUS_QUEUE_CAPACITY (256)
+// Events a publishing thread collects before it publishes them as one batch
+#define SRE3021_EVENT_BUS_BATCH_SIZE (64)
+#define SRE3021_EVENT_BUS_SPIN_BUDGET (100)
+#define SRE3021_EVENT_BUS_PARK_TIMEOUT_MS (100)
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Delivery counters of one SRE3021EventBus subscriber. Dropped batches did not fit in its queue.
+        /// </summary>
+        struct SRE3021EventBusStats {
+            size_t DeliveredBatchCount; size_t DeliveredEventCount; size_t DroppedBatchCount; size_t DroppedEventCount; size_t QueueHighWaterMark;
+        };
+
+        /// <summary>
+        /// Hands batches of events to any number of subscribers. Every subscriber has its own bounded queue and delivery thread,
+        /// so a slow subscriber only drops its own batches and never holds up the publishers or the other subscribers.
+        /// A published batch is shared by all subscribers, they receive it by const reference and must not keep it past the call.
+        /// Publish may be called from several threads, Subscribe and Unsubscribe from any thread but a delivery thread.
+        /// </summary>
+        template <typename T>
+        class SRE3021EventBus
+        {
+        public:
+            typedef std::vector<T> Batch;
+            typedef std::function<void(const Batch&)> Consumer;
+
+            /// <summary>
+            /// Collects the events of one publishing thread into batches. Not thread safe, every publishing thread has its own.
+            /// </summary>
+            class Publisher
+            {
+            public:
+                Publisher(SRE3021EventBus* eventBus = nullptr, size_t eventBatchSize = SRE3021_EVENT_BUS_BATCH_SIZE)
+                    : bus(eventBus), batchSize(eventBatchSize > 0 ? eventBatchSize : 1)
+                {
+                };
+                ~Publisher()
+                {
+                    Flush();
+                };
+                Publisher(const Publisher&) = delete;
+                Publisher& operator=(const Publisher&) = delete;
+
+                /// <summary>
+                /// Publish to eventBus from now on, events collected so far go to the previous bus
+                /// </summary>
+                void Attach(SRE3021EventBus* eventBus)
+                {
+                    Flush();
+                    bus = eventBus;
+                };
+
+                void Add(const T& event)
+                {
+                    if (!batch)
+                    {
+                        batch = std::make_shared<Batch>();
+                        batch->reserve(batchSize);
+                    }
+                    batch->push_back(event);
+                    if (batch->size() >= batchSize)
+                    {
+                        Flush();
+                    }
+                };
+
+                /// <summary>
+                /// Publish the events collected so far
+                /// </summary>
+                void Flush()
+                {
+                    if (bus != nullptr && batch && !batch->empty())
+                    {
+                        bus->Publish(std::move(batch));
+                    }
+                    batch.reset();
+                };
+
+            private:
+                SRE3021EventBus* bus;
+                size_t batchSize;
+                std::shared_ptr<Batch> batch;
+            };
+
+            SRE3021EventBus()
+                : subscribers(std::make_shared<const SubscriberList>())
+            {
+            };
+            ~SRE3021EventBus()
+            {
+                UnsubscribeAll();
+            };
+            SRE3021EventBus(const SRE3021EventBus&) = delete;
+            SRE3021EventBus& operator=(const SRE3021EventBus&) = delete;
+
+            /// <summary>
+            /// Start delivering published batches to consumer on a thread of its own. Returns the subscription id.
+            /// </summary>
+            /// <param name="queueCapacity">batches that may wait for the consumer, further batches are dropped</param>
+            int Subscribe(Consumer consumer, size_t queueCapacity = SRE3021_EVENT_BUS_QUEUE_CAPACITY)
+            {
+                std::shared_ptr<Subscriber> subscriber = std::make_shared<Subscriber>();
+                subscriber->Consume = std::move(consumer);
+                subscriber->Capacity = queueCapacity > 0 ? queueCapacity : 1;
+
+                std::lock_guard<std::mutex> lock(mutexSubscribers);
+                subscriber->Id = nextSubscriberId++;
+                subscriber->isRunning.store(true, std::memory_order_relaxed);
+                Subscriber* delivering = subscriber.get();
+                subscriber->DeliveryThread = std::thread([delivering] { Deliver(*delivering); });
+
+                std::shared_ptr<SubscriberList> updated = std::make_shared<SubscriberList>(*std::atomic_load(&subscribers));
+                updated->push_back(subscriber);
+                std::atomic_store(&subscribers, std::shared_ptr<const SubscriberList>(std::move(updated)));
+                return subscriber->Id;
+            };
+
+            /// <summary>
+            /// Stop a subscription. Batches already queued are delivered before it returns, so it must not be called from the consumer.
+            /// Returns false for an unknown id.
+            /// </summary>
+            bool Unsubscribe(int id)
+            {
+                std::shared_ptr<Subscriber> subscriber;
+                {
+                    std::lock_guard<std::mutex> lock(mutexSubscribers);
+                    std::shared_ptr<SubscriberList> updated = std::make_shared<SubscriberList>();
+                    for (const auto& current : *std::atomic_load(&subscribers))
+                    {
+                        if (current->Id == id)
+                        {
+                            subscriber = current;
+                        }
+                        else
+                        {
+                            updated->push_back(current);
+                        }
+                    }
+                    if (!subscriber)
+                    {
+                        return false;
+                    }
+                    std::atomic_store(&subscribers, std::shared_ptr<const SubscriberList>(std::move(updated)));
+                }
+                Stop(*subscriber);
+                return true;
+            };
+
+            void UnsubscribeAll()
+            {
+                std::shared_ptr<const SubscriberList> stopped;
+                {
+                    std::lock_guard<std::mutex> lock(mutexSubscribers);
+                    stopped = std::atomic_load(&subscribers);
+                    std::atomic_store(&subscribers, std::make_shared<const SubscriberList>());
+                }
+                for (const auto& subscriber : *stopped)
+                {
+                    Stop(*subscriber);
+                }
+            };
+
+            /// <summary>
+            /// Cheap check for publishers, events need not be collected without subscribers
+            /// </summary>
+            bool HasSubscribers() const
+            {
+                return !std::atomic_load(&subscribers)->empty();
+            };
+
+            /// <summary>
+            /// Queue the batch for every subscriber. A subscriber with a full queue drops it.
+            /// </summary>
+            void Publish(std::shared_ptr<const Batch> batch)
+            {
+                if (!batch || batch->empty())
+                {
+                    return;
+                }
+                const std::shared_ptr<const SubscriberList> current = std::atomic_load(&subscribers);
+                for (const auto& subscriber : *current)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(subscriber->mutexQueue);
+                        if (subscriber->Queue.size() >= subscriber->Capacity)
+                        {
+                            ++subscriber->DroppedBatchCount;
+                            subscriber->DroppedEventCount += batch->size();
+                            continue;
+                        }
+                        subscriber->Queue.push_back(batch);
+                        if (subscriber->Queue.size() > subscriber->QueueHighWaterMark)
+                        {
+                            subscriber->QueueHighWaterMark = subscriber->Queue.size();
+                        }
+                        subscriber->QueuedCount.store(subscriber->Queue.size(), std::memory_order_release);
+                    }
+                    subscriber->Doorbell.Ring();
+                }
+            };
+
+            /// <summary>
+            /// Counters of a subscription, all 0 for an unknown id
+            /// </summary>
+            SRE3021EventBusStats GetStats(int id) const
+            {
+                SRE3021EventBusStats stats{ 0, 0, 0, 0, 0 };
+                for (const auto& subscriber : *std::atomic_load(&subscribers))
+                {
+                    if (subscriber->Id != id)
+                    {
+                        continue;
+                    }
+                    std::lock_guard<std::mutex> lock(subscriber->mutexQueue);
+                    stats.DeliveredBatchCount = subscriber->DeliveredBatchCount;
+                    stats.DeliveredEventCount = subscriber->DeliveredEventCount;
+                    stats.DroppedBatchCount = subscriber->DroppedBatchCount;
+                    stats.DroppedEventCount = subscriber->DroppedEventCount;
+                    stats.QueueHighWaterMark = subscriber->QueueHighWaterMark;
+                }
+                return stats;
+            };
+
+        private:
+            struct Subscriber
+            {
+                int Id = 0;
+                Consumer Consume;
+                size_t Capacity = SRE3021_EVENT_BUS_QUEUE_CAPACITY;
+                std::thread DeliveryThread;
+                std::atomic<bool> isRunning{ false };
+                SRE3021Doorbell Doorbell{ SRE3021_EVENT_BUS_SPIN_BUDGET };
+                // Queue and counters are guarded by mutexQueue, QueuedCount lets the delivery thread wait without it
+                std::mutex mutexQueue;
+                std::deque<std::shared_ptr<const Batch>> Queue;
+                std::atomic<size_t> QueuedCount{ 0 };
+                size_t DeliveredBatchCount = 0;
+                size_t DeliveredEventCount = 0;
+                size_t DroppedBatchCount = 0;
+                size_t DroppedEventCount = 0;
+                size_t QueueHighWaterMark = 0;
+            };
+            typedef std::vector<std::shared_ptr<Subscriber>> SubscriberList;
+
+            static void Deliver(Subscriber& subscriber)
+            {
+                std::deque<std::shared_ptr<const Batch>> batches;
+                while (true)
+                {
+                    subscriber.Doorbell.Wait([&subscriber] { return subscriber.QueuedCount.load(std::memory_order_acquire) > 0 || !subscriber.isRunning.load(std::memory_order_acquire); },
+                        std::chrono::milliseconds(SRE3021_EVENT_BUS_PARK_TIMEOUT_MS));
+                    {
+                        std::lock_guard<std::mutex> lock(subscriber.mutexQueue);
+                        batches.swap(subscriber.Queue);
+                        subscriber.QueuedCount.store(0, std::memory_order_relaxed);
+                    }
+                    // Queued batches are delivered even when stopping
+                    if (batches.empty() && !subscriber.isRunning.load(std::memory_order_acquire))
+                    {
+                        break;
+                    }
+                    size_t eventCount = 0;
+                    for (const auto& batch : batches)
+                    {
+                        subscriber.Consume(*batch);
+                        eventCount += batch->size();
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(subscriber.mutexQueue);
+                        subscriber.DeliveredBatchCount += batches.size();
+                        subscriber.DeliveredEventCount += eventCount;
+                    }
+                    batches.clear();
+                }
+            };
+
+            static void Stop(Subscriber& subscriber)
+            {
+                subscriber.isRunning.store(false, std::memory_order_release);
+                subscriber.Doorbell.Ring();
+                if (subscriber.DeliveryThread.joinable())
+                {
+                    subscriber.DeliveryThread.join();
+                }
+            };
+
+            mutable std::mutex mutexSubscribers;
+            std::shared_ptr<const SubscriberList> subscribers;
+            int nextSubscriberId = 0;
+        };
+    };
+};
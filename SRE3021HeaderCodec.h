@@ -0,0 +1,143 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include "SRE3021Types.h"
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Header fields of a packet, as decoded by SRE3021HeaderCodec
+        /// </summary>
+        struct SRE3021HeaderFields {
+            int Version; int SystemNumber; SRE3021PacketType PacketType; SRE3021PacketSequence SequenceFlag; int PacketCount; unsigned __int32 Reserved; int DataLength;
+        };
+
+        /// <summary>
+        /// Raw header bytes in wire order
+        /// </summary>
+        struct SRE3021HeaderBytes {
+            unsigned __int8 Bytes[SRE3021_PACKET_HEADER_LENGTH];
+        };
+
+        /// <summary>
+        /// Packet header layout. Multi-byte fields are big endian on the wire and are assembled with shifts,
+        /// so the result does not depend on the byte order of the host.
+        /// byte 0: Version (3 bits) and SystemNumber (5 bits), byte 1: PacketType, bytes 2-3: SequenceFlag (2 bits) and PacketCount (14 bits),
+        /// bytes 4-7: Reserved or time stamp, bytes 8-9: DataLength.
+        /// </summary>
+        class SRE3021HeaderCodec
+        {
+        public:
+            static constexpr unsigned int ReadBigEndian16(const unsigned __int8* data)
+            {
+                return static_cast<unsigned int>(data[0]) << 8 | data[1];
+            };
+
+            static constexpr unsigned __int32 ReadBigEndian32(const unsigned __int8* data)
+            {
+                return static_cast<unsigned __int32>(data[0]) << 24 | static_cast<unsigned __int32>(data[1]) << 16 | static_cast<unsigned __int32>(data[2]) << 8 | data[3];
+            };
+
+            static constexpr int DecodeVersion(const unsigned __int8* data)
+            {
+                return data[0] >> 5;
+            };
+
+            static constexpr int DecodeSystemNumber(const unsigned __int8* data)
+            {
+                return data[0] & 0x1F;
+            };
+
+            static constexpr SRE3021PacketType DecodePacketType(const unsigned __int8* data)
+            {
+                return static_cast<SRE3021PacketType>(data[1]);
+            };
+
+            static constexpr SRE3021PacketSequence DecodeSequenceFlag(const unsigned __int8* data)
+            {
+                return static_cast<SRE3021PacketSequence>(data[2] >> 6);
+            };
+
+            static constexpr int DecodePacketCount(const unsigned __int8* data)
+            {
+                return static_cast<int>(ReadBigEndian16(data + 2) & 0x3FFF);
+            };
+
+            static constexpr unsigned __int32 DecodeReserved(const unsigned __int8* data)
+            {
+                return ReadBigEndian32(data + 4);
+            };
+
+            /// <summary>
+            /// The Reserved field, which the detector fills with its 32 bit hardware time stamp
+            /// </summary>
+            static constexpr unsigned __int32 DecodeTimestamp(const unsigned __int8* data)
+            {
+                return DecodeReserved(data);
+            };
+
+            static constexpr int DecodeDataLength(const unsigned __int8* data)
+            {
+                return static_cast<int>(ReadBigEndian16(data + 8));
+            };
+
+            static constexpr SRE3021HeaderFields Decode(const unsigned __int8* data)
+            {
+                return SRE3021HeaderFields{ DecodeVersion(data), DecodeSystemNumber(data), DecodePacketType(data), DecodeSequenceFlag(data),
+                    DecodePacketCount(data), DecodeReserved(data), DecodeDataLength(data) };
+            };
+
+            /// <summary>
+            /// Fields wider than their bit count are truncated
+            /// </summary>
+            static constexpr SRE3021HeaderBytes Encode(const SRE3021HeaderFields& fields)
+            {
+                return SRE3021HeaderBytes{ {
+                    static_cast<unsigned __int8>((fields.Version & 0x07) << 5 | (fields.SystemNumber & 0x1F)),
+                    static_cast<unsigned __int8>(static_cast<int>(fields.PacketType) & 0xFF),
+                    static_cast<unsigned __int8>((static_cast<int>(fields.SequenceFlag) & 0x03) << 6 | (fields.PacketCount >> 8 & 0x3F)),
+                    static_cast<unsigned __int8>(fields.PacketCount & 0xFF),
+                    static_cast<unsigned __int8>(fields.Reserved >> 24 & 0xFF),
+                    static_cast<unsigned __int8>(fields.Reserved >> 16 & 0xFF),
+                    static_cast<unsigned __int8>(fields.Reserved >> 8 & 0xFF),
+                    static_cast<unsigned __int8>(fields.Reserved & 0xFF),
+                    static_cast<unsigned __int8>(fields.DataLength >> 8 & 0xFF),
+                    static_cast<unsigned __int8>(fields.DataLength & 0xFF) } };
+            };
+
+            /// <summary>
+            /// Version 0, the expected type and a DataLength that matches the datagram size, checked together without branching on the fields
+            /// </summary>
+            static constexpr bool IsValid(const unsigned __int8* data, int datagramSize, SRE3021PacketType expectedType)
+            {
+                return datagramSize >= SRE3021_PACKET_HEADER_LENGTH
+                    && ((data[0] & 0xE0u) | (data[1] ^ static_cast<unsigned int>(expectedType))
+                        | (ReadBigEndian16(data + 8) ^ static_cast<unsigned int>(datagramSize - SRE3021_PACKET_HEADER_LENGTH))) == 0;
+            };
+        };
+    };
+};
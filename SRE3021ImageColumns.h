@@ -0,0 +1,86 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "SRE3021Types.h"
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// A batch of image events stored by column, for offline reprocessing and analysis over many events.
+        /// Each quantity is one array with the events next to each other. Anode planes hold all events of one pixel,
+        /// then the next pixel in packet order, pixel index Y * 11 + X. Values are baseline subtracted.
+        /// Timestamp is the header time stamp extended to 64 bits, as in SRE3021ImageData.
+        /// </summary>
+        struct SRE3021ImageColumns {
+            size_t EventCount = 0;
+            std::vector<unsigned long long> Timestamp;
+            std::vector<__int32> CathodeValue;
+            std::vector<__int32> CathodeTiming;
+            std::vector<__int32> AnodeValue;
+            std::vector<__int32> AnodeTiming;
+
+            void Resize(size_t eventCount)
+            {
+                EventCount = eventCount;
+                Timestamp.resize(eventCount);
+                CathodeValue.resize(eventCount);
+                CathodeTiming.resize(eventCount);
+                AnodeValue.resize(eventCount * 121);
+                AnodeTiming.resize(eventCount * 121);
+            };
+
+            /// <summary>
+            /// Anode values of every event for one pixel, EventCount entries
+            /// </summary>
+            const __int32* AnodeValuePlane(int X, int Y) const
+            {
+                return &AnodeValue[(Y * 11 + X) * EventCount];
+            };
+
+            /// <summary>
+            /// Anode timings of every event for one pixel, EventCount entries
+            /// </summary>
+            const __int32* AnodeTimingPlane(int X, int Y) const
+            {
+                return &AnodeTiming[(Y * 11 + X) * EventCount];
+            };
+
+            __int32 GetAnodeValue(size_t eventIndex, int X, int Y) const
+            {
+                return AnodeValue[(Y * 11 + X) * EventCount + eventIndex];
+            };
+
+            __int32 GetAnodeTiming(size_t eventIndex, int X, int Y) const
+            {
+                return AnodeTiming[(Y * 11 + X) * EventCount + eventIndex];
+            };
+        };
+    };
+};
@@ -0,0 +1,517 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021ImageDecoder.h"
+#include "SRE3021TimestampUnwrapper.h"
+
+#if SRE3021_HAS_X86_SIMD
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SRE3021_TARGET_SSE2
+#define SRE3021_TARGET_AVX2
+#else
+#define SRE3021_TARGET_SSE2 __attribute__((target("sse2")))
+#define SRE3021_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace hurel::sre3021;
+
+namespace {
+	void DecodeRowScalar(const unsigned __int8* row, const __int32* baseline, __int16* outRow)
+	{
+		for (int X = 0; X < 11; ++X)
+		{
+			outRow[X] = SRE3021CompactImageData::Saturate(static_cast<__int32>((row[2 * X] << 8) | row[2 * X + 1]) - baseline[X]);
+		}
+		for (int X = 11; X < SRE3021_COMPACT_ROW_STRIDE; ++X)
+		{
+			outRow[X] = 0;
+		}
+	}
+
+	void DecodeWordsScalar(const unsigned __int8* words, const __int32* baseline, __int32* outWords)
+	{
+		for (int i = 0; i < SRE3021_IMAGE_WORD_COUNT; ++i)
+		{
+			outWords[i] = static_cast<__int32>((words[2 * i] << 8) | words[2 * i + 1]) - baseline[i];
+		}
+	}
+
+	// Column of word i of the packet, i.e. pixel i % 121 of the anode values or timings
+	inline __int32* ColumnOfWord(SRE3021ImageColumns& columns, int i)
+	{
+		return i < SRE3021_IMAGE_PIXEL_COUNT ? &columns.AnodeValue[i * columns.EventCount] : &columns.AnodeTiming[(i - SRE3021_IMAGE_PIXEL_COUNT) * columns.EventCount];
+	}
+
+	void DecodeColumnsScalar(const unsigned __int8* const* packetWords, size_t eventCount, int firstWord, const __int32* baseline,
+		SRE3021ImageColumns& columns, size_t firstEvent)
+	{
+		for (int i = firstWord; i < SRE3021_IMAGE_WORD_COUNT; ++i)
+		{
+			__int32* column = ColumnOfWord(columns, i) + firstEvent;
+			for (size_t event = 0; event < eventCount; ++event)
+			{
+				column[event] = static_cast<__int32>((packetWords[event][2 * i] << 8) | packetWords[event][2 * i + 1]) - baseline[i];
+			}
+		}
+	}
+
+#if SRE3021_HAS_X86_SIMD
+	// Byte-swapped words [word, word + 8) of 8 packets, transposed so that out[k] holds word + k of each packet
+	SRE3021_TARGET_SSE2 inline void TransposeWordsSSE2(const unsigned __int8* const* packetWords, int word, __m128i* out)
+	{
+		__m128i rows[8];
+		for (int event = 0; event < 8; ++event)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packetWords[event] + 2 * word));
+			rows[event] = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		}
+		const __m128i pairs0 = _mm_unpacklo_epi16(rows[0], rows[1]);
+		const __m128i pairs1 = _mm_unpackhi_epi16(rows[0], rows[1]);
+		const __m128i pairs2 = _mm_unpacklo_epi16(rows[2], rows[3]);
+		const __m128i pairs3 = _mm_unpackhi_epi16(rows[2], rows[3]);
+		const __m128i pairs4 = _mm_unpacklo_epi16(rows[4], rows[5]);
+		const __m128i pairs5 = _mm_unpackhi_epi16(rows[4], rows[5]);
+		const __m128i pairs6 = _mm_unpacklo_epi16(rows[6], rows[7]);
+		const __m128i pairs7 = _mm_unpackhi_epi16(rows[6], rows[7]);
+		const __m128i quads0 = _mm_unpacklo_epi32(pairs0, pairs2);
+		const __m128i quads1 = _mm_unpackhi_epi32(pairs0, pairs2);
+		const __m128i quads2 = _mm_unpacklo_epi32(pairs1, pairs3);
+		const __m128i quads3 = _mm_unpackhi_epi32(pairs1, pairs3);
+		const __m128i quads4 = _mm_unpacklo_epi32(pairs4, pairs6);
+		const __m128i quads5 = _mm_unpackhi_epi32(pairs4, pairs6);
+		const __m128i quads6 = _mm_unpacklo_epi32(pairs5, pairs7);
+		const __m128i quads7 = _mm_unpackhi_epi32(pairs5, pairs7);
+		out[0] = _mm_unpacklo_epi64(quads0, quads4);
+		out[1] = _mm_unpackhi_epi64(quads0, quads4);
+		out[2] = _mm_unpacklo_epi64(quads1, quads5);
+		out[3] = _mm_unpackhi_epi64(quads1, quads5);
+		out[4] = _mm_unpacklo_epi64(quads2, quads6);
+		out[5] = _mm_unpackhi_epi64(quads2, quads6);
+		out[6] = _mm_unpacklo_epi64(quads3, quads7);
+		out[7] = _mm_unpackhi_epi64(quads3, quads7);
+	}
+
+	// Events go across the vector lanes, so each word needs only its own baseline broadcast
+	SRE3021_TARGET_SSE2 void DecodeColumnsSSE2(const unsigned __int8* const* packetWords, size_t eventCount, const __int32* baseline,
+		SRE3021ImageColumns& columns, size_t firstEvent)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i words[8];
+		for (int word = 0; word + 8 <= SRE3021_IMAGE_WORD_COUNT; word += 8)
+		{
+			for (size_t event = 0; event + 8 <= eventCount; event += 8)
+			{
+				TransposeWordsSSE2(packetWords + event, word, words);
+				for (int k = 0; k < 8; ++k)
+				{
+					const __m128i wordBaseline = _mm_set1_epi32(baseline[word + k]);
+					__int32* column = ColumnOfWord(columns, word + k) + firstEvent + event;
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(column), _mm_sub_epi32(_mm_unpacklo_epi16(words[k], zero), wordBaseline));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(column + 4), _mm_sub_epi32(_mm_unpackhi_epi16(words[k], zero), wordBaseline));
+				}
+			}
+		}
+	}
+
+	SRE3021_TARGET_AVX2 void DecodeColumnsAVX2(const unsigned __int8* const* packetWords, size_t eventCount, const __int32* baseline,
+		SRE3021ImageColumns& columns, size_t firstEvent)
+	{
+		__m128i words[8];
+		for (int word = 0; word + 8 <= SRE3021_IMAGE_WORD_COUNT; word += 8)
+		{
+			for (size_t event = 0; event + 8 <= eventCount; event += 8)
+			{
+				TransposeWordsSSE2(packetWords + event, word, words);
+				for (int k = 0; k < 8; ++k)
+				{
+					__int32* column = ColumnOfWord(columns, word + k) + firstEvent + event;
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(column), _mm256_sub_epi32(_mm256_cvtepu16_epi32(words[k]), _mm256_set1_epi32(baseline[word + k])));
+				}
+			}
+		}
+	}
+
+	SRE3021_TARGET_SSE2 void DecodeWordsSSE2(const unsigned __int8* words, const __int32* baseline, __int32* outWords)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		int i = 0;
+		for (; i + 8 <= SRE3021_IMAGE_WORD_COUNT; i += 8)
+		{
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2 * i));
+			v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+			const __m128i low = _mm_unpacklo_epi16(v, zero);
+			const __m128i high = _mm_unpackhi_epi16(v, zero);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(outWords + i), _mm_sub_epi32(low, _mm_loadu_si128(reinterpret_cast<const __m128i*>(baseline + i))));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(outWords + i + 4), _mm_sub_epi32(high, _mm_loadu_si128(reinterpret_cast<const __m128i*>(baseline + i + 4))));
+		}
+		for (; i < SRE3021_IMAGE_WORD_COUNT; ++i)
+		{
+			outWords[i] = static_cast<__int32>((words[2 * i] << 8) | words[2 * i + 1]) - baseline[i];
+		}
+	}
+
+	// Reads 32 bytes from row, 10 more than the row
+	SRE3021_TARGET_SSE2 inline void DecodeRowSSE2(const unsigned __int8* row, const __int32* baseline, __int16* outRow)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i padMask = _mm_setr_epi16(-1, -1, -1, 0, 0, 0, 0, 0);
+		__m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+		__m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 16));
+		first = _mm_or_si128(_mm_slli_epi16(first, 8), _mm_srli_epi16(first, 8));
+		second = _mm_or_si128(_mm_slli_epi16(second, 8), _mm_srli_epi16(second, 8));
+		const __m128i first0 = _mm_sub_epi32(_mm_unpacklo_epi16(first, zero), _mm_loadu_si128(reinterpret_cast<const __m128i*>(baseline)));
+		const __m128i first1 = _mm_sub_epi32(_mm_unpackhi_epi16(first, zero), _mm_loadu_si128(reinterpret_cast<const __m128i*>(baseline + 4)));
+		const __m128i second0 = _mm_sub_epi32(_mm_unpacklo_epi16(second, zero), _mm_loadu_si128(reinterpret_cast<const __m128i*>(baseline + 8)));
+		const __m128i second1 = _mm_sub_epi32(_mm_unpackhi_epi16(second, zero), _mm_loadu_si128(reinterpret_cast<const __m128i*>(baseline + 12)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(outRow), _mm_packs_epi32(first0, first1));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(outRow + 8), _mm_and_si128(_mm_packs_epi32(second0, second1), padMask));
+	}
+
+	// Reads 32 bytes from row, 10 more than the row
+	SRE3021_TARGET_AVX2 inline void DecodeRowAVX2(const unsigned __int8* row, const __int32* baseline, __int16* outRow)
+	{
+		const __m256i swap = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+			1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+		const __m256i padMask = _mm256_setr_epi16(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0);
+		const __m256i v = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row)), swap);
+		const __m256i low = _mm256_sub_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(v)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(baseline)));
+		const __m256i high = _mm256_sub_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(baseline + 8)));
+		// packs works per 128 bit lane, put the 64 bit blocks back in order
+		const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(outRow), _mm256_and_si256(packed, padMask));
+	}
+
+	SRE3021_TARGET_SSE2 void DecodeRowsSSE2(const unsigned __int8* words, const __int32 (*baseline)[SRE3021_COMPACT_ROW_STRIDE], __int16* const* planes, int rowCount)
+	{
+		for (int row = 0; row < rowCount; ++row)
+		{
+			DecodeRowSSE2(words + 22 * row, baseline[row], planes[row / 11] + (row % 11) * SRE3021_COMPACT_ROW_STRIDE);
+		}
+	}
+
+	SRE3021_TARGET_AVX2 void DecodeRowsAVX2(const unsigned __int8* words, const __int32 (*baseline)[SRE3021_COMPACT_ROW_STRIDE], __int16* const* planes, int rowCount)
+	{
+		for (int row = 0; row < rowCount; ++row)
+		{
+			DecodeRowAVX2(words + 22 * row, baseline[row], planes[row / 11] + (row % 11) * SRE3021_COMPACT_ROW_STRIDE);
+		}
+	}
+
+	SRE3021_TARGET_AVX2 void DecodeWordsAVX2(const unsigned __int8* words, const __int32* baseline, __int32* outWords)
+	{
+		const __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+		int i = 0;
+		for (; i + 8 <= SRE3021_IMAGE_WORD_COUNT; i += 8)
+		{
+			const __m128i v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2 * i)), swap);
+			const __m256i widened = _mm256_cvtepu16_epi32(v);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(outWords + i), _mm256_sub_epi32(widened, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(baseline + i))));
+		}
+		for (; i < SRE3021_IMAGE_WORD_COUNT; ++i)
+		{
+			outWords[i] = static_cast<__int32>((words[2 * i] << 8) | words[2 * i + 1]) - baseline[i];
+		}
+	}
+
+	// Packet order is Y major, SRE3021ImageData is X major. Gather one X row of 8 values at a time and widen to 64 bit.
+	SRE3021_TARGET_AVX2 void TransposeWordsAVX2(const __int32* words, SRE3021ImageData& outImageData)
+	{
+		const __m256i rowOffsets = _mm256_setr_epi32(0, 11, 22, 33, 44, 55, 66, 77);
+		for (int k = 0; k < 2; ++k)
+		{
+			const __int32* source = words + k * SRE3021_IMAGE_PIXEL_COUNT;
+			long long (*destination)[11] = k == 0 ? outImageData.AnodeValue : outImageData.AnodeTiming;
+			for (int X = 0; X < 11; ++X)
+			{
+				const __m256i column = _mm256_i32gather_epi32(reinterpret_cast<const int*>(source + X), rowOffsets, 4);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(&destination[X][0]), _mm256_cvtepi32_epi64(_mm256_castsi256_si128(column)));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(&destination[X][4]), _mm256_cvtepi32_epi64(_mm256_extracti128_si256(column, 1)));
+				destination[X][8] = source[88 + X];
+				destination[X][9] = source[99 + X];
+				destination[X][10] = source[110 + X];
+			}
+		}
+	}
+#endif
+}
+
+hurel::sre3021::SRE3021ImageDecoder::SRE3021ImageDecoder()
+{
+	// Zero baseline, padding included
+	baselineTables.push_back(std::unique_ptr<BaselineTable>(new BaselineTable()));
+	baseline.store(baselineTables.back().get(), std::memory_order_release);
+	for (int channel = 0; channel < SRE3021_ASIC_CHANNEL_COUNT; ++channel)
+	{
+		asicChannelPixel[channel] = -1;
+	}
+	for (int X = 0; X < 11; ++X)
+	{
+		for (int Y = 0; Y < 11; ++Y)
+		{
+			asicChannelPixel[ASICChannelNumber[X][Y]] = Y * 11 + X;
+		}
+	}
+	simdLevel = DetectSimdLevel();
+}
+
+void hurel::sre3021::SRE3021ImageDecoder::SetBaseline(const size_t (*anodeValueBaseline)[11], const size_t (*anodeTimingBaseline)[11],
+	size_t cathodeValueBaseline, size_t cathodeTimingBaseline)
+{
+	std::unique_ptr<BaselineTable> table(new BaselineTable());
+	for (int Y = 0; Y < 11; ++Y)
+	{
+		for (int X = 0; X < 11; ++X)
+		{
+			table->Word[Y * 11 + X] = static_cast<__int32>(anodeValueBaseline[X][Y]);
+			table->Word[SRE3021_IMAGE_PIXEL_COUNT + Y * 11 + X] = static_cast<__int32>(anodeTimingBaseline[X][Y]);
+			table->Row[Y][X] = static_cast<__int32>(anodeValueBaseline[X][Y]);
+			table->Row[11 + Y][X] = static_cast<__int32>(anodeTimingBaseline[X][Y]);
+		}
+	}
+	table->CathodeValue = static_cast<long long>(cathodeValueBaseline);
+	table->CathodeTiming = static_cast<long long>(cathodeTimingBaseline);
+
+	std::lock_guard<std::mutex> lock(mutexBaselineTables);
+	baselineTables.push_back(std::move(table));
+	baseline.store(baselineTables.back().get(), std::memory_order_release);
+}
+
+void hurel::sre3021::SRE3021ImageDecoder::DecodeWords(const unsigned __int8* packet, __int32* outWords) const
+{
+	const BaselineTable& table = LoadBaseline();
+	const unsigned __int8* words = packet + SRE3021_IMAGE_WORD_OFFSET;
+	switch (simdLevel)
+	{
+#if SRE3021_HAS_X86_SIMD
+	case SRE3021SimdLevel::AVX2:
+		DecodeWordsAVX2(words, table.Word, outWords);
+		break;
+	case SRE3021SimdLevel::SSE2:
+		DecodeWordsSSE2(words, table.Word, outWords);
+		break;
+#endif
+	default:
+		DecodeWordsScalar(words, table.Word, outWords);
+		break;
+	}
+}
+
+void hurel::sre3021::SRE3021ImageDecoder::Decode(const unsigned __int8* packet, SRE3021ImageData& outImageData) const
+{
+	const BaselineTable& table = LoadBaseline();
+	outImageData.CathodeValue = static_cast<long long>((packet[20] << 8) | packet[21]) - table.CathodeValue;
+	outImageData.CathodeTiming = static_cast<long long>((packet[22] << 8) | packet[23]) - table.CathodeTiming;
+	outImageData.Timestamp = SRE3021HeaderCodec::DecodeTimestamp(packet);
+	outImageData.ReceiveTime = 0;
+	outImageData.AnodeTimingMode = SRE3021AnodeTimingMode::PULSE_TIMING;
+
+#if SRE3021_HAS_X86_SIMD
+	if (simdLevel == SRE3021SimdLevel::AVX2)
+	{
+		alignas(32) __int32 words[SRE3021_IMAGE_WORD_COUNT];
+		DecodeWordsAVX2(packet + SRE3021_IMAGE_WORD_OFFSET, table.Word, words);
+		TransposeWordsAVX2(words, outImageData);
+		return;
+	}
+#endif
+	// Filling the 64 bit fields is store bound, without a gather the transpose would cost more than SSE2 saves.
+	// Decode straight into place instead.
+	const unsigned __int8* words = packet + SRE3021_IMAGE_WORD_OFFSET;
+	for (int Y = 0; Y < 11; ++Y)
+	{
+		for (int X = 0; X < 11; ++X)
+		{
+			const int i = Y * 11 + X;
+			const int j = SRE3021_IMAGE_PIXEL_COUNT + i;
+			outImageData.AnodeValue[X][Y] = static_cast<__int32>((words[2 * i] << 8) | words[2 * i + 1]) - table.Word[i];
+			outImageData.AnodeTiming[X][Y] = static_cast<__int32>((words[2 * j] << 8) | words[2 * j + 1]) - table.Word[j];
+		}
+	}
+}
+
+void hurel::sre3021::SRE3021ImageDecoder::DecodeCompact(const unsigned __int8* packet, SRE3021CompactImageData& outImageData) const
+{
+	const BaselineTable& table = LoadBaseline();
+	outImageData.CathodeValue = static_cast<__int32>((packet[20] << 8) | packet[21]) - static_cast<__int32>(table.CathodeValue);
+	outImageData.CathodeTiming = static_cast<__int32>((packet[22] << 8) | packet[23]) - static_cast<__int32>(table.CathodeTiming);
+	outImageData.Timestamp = SRE3021HeaderCodec::DecodeTimestamp(packet);
+	outImageData.ReceiveTime = 0;
+	outImageData.AnodeTimingMode = SRE3021AnodeTimingMode::PULSE_TIMING;
+
+	const unsigned __int8* words = packet + SRE3021_IMAGE_WORD_OFFSET;
+	__int16* planes[2] = { &outImageData.AnodeValue[0][0], &outImageData.AnodeTiming[0][0] };
+	int row = 0;
+#if SRE3021_HAS_X86_SIMD
+	// The wide kernels read past the end of the row, the last row of the packet is decoded one word at a time
+	if (simdLevel == SRE3021SimdLevel::AVX2)
+	{
+		row = SRE3021_IMAGE_ROW_COUNT - 1;
+		DecodeRowsAVX2(words, table.Row, planes, row);
+	}
+	else if (simdLevel == SRE3021SimdLevel::SSE2)
+	{
+		row = SRE3021_IMAGE_ROW_COUNT - 1;
+		DecodeRowsSSE2(words, table.Row, planes, row);
+	}
+#endif
+	for (; row < SRE3021_IMAGE_ROW_COUNT; ++row)
+	{
+		DecodeRowScalar(words + 22 * row, table.Row[row], planes[row / 11] + (row % 11) * SRE3021_COMPACT_ROW_STRIDE);
+	}
+}
+
+void hurel::sre3021::SRE3021ImageDecoder::DecodeBatch(const unsigned __int8* packets, size_t packetCount, SRE3021ImageColumns& outColumns,
+	size_t packetStride) const
+{
+	const BaselineTable& table = LoadBaseline();
+	outColumns.Resize(packetCount);
+	SRE3021TimestampUnwrapper timestampUnwrapper;
+	const unsigned __int8* packetWords[SRE3021_IMAGE_BATCH_BLOCK];
+	for (size_t first = 0; first < packetCount; first += SRE3021_IMAGE_BATCH_BLOCK)
+	{
+		const size_t blockCount = packetCount - first < SRE3021_IMAGE_BATCH_BLOCK ? packetCount - first : SRE3021_IMAGE_BATCH_BLOCK;
+		for (size_t event = 0; event < blockCount; ++event)
+		{
+			const unsigned __int8* packet = packets + (first + event) * packetStride;
+			outColumns.CathodeValue[first + event] = static_cast<__int32>((packet[20] << 8) | packet[21]) - static_cast<__int32>(table.CathodeValue);
+			outColumns.CathodeTiming[first + event] = static_cast<__int32>((packet[22] << 8) | packet[23]) - static_cast<__int32>(table.CathodeTiming);
+			outColumns.Timestamp[first + event] = timestampUnwrapper.Unwrap(SRE3021HeaderCodec::DecodeSystemNumber(packet), SRE3021HeaderCodec::DecodeTimestamp(packet));
+			packetWords[event] = packet + SRE3021_IMAGE_WORD_OFFSET;
+		}
+
+		// The wide kernels take 8 events by 8 words, the rest is decoded one word at a time
+		size_t vectorEventCount = 0;
+#if SRE3021_HAS_X86_SIMD
+		if (simdLevel == SRE3021SimdLevel::AVX2)
+		{
+			vectorEventCount = blockCount / 8 * 8;
+			DecodeColumnsAVX2(packetWords, vectorEventCount, table.Word, outColumns, first);
+		}
+		else if (simdLevel == SRE3021SimdLevel::SSE2)
+		{
+			vectorEventCount = blockCount / 8 * 8;
+			DecodeColumnsSSE2(packetWords, vectorEventCount, table.Word, outColumns, first);
+		}
+#endif
+		DecodeColumnsScalar(packetWords, vectorEventCount, vectorEventCount == 0 ? 0 : SRE3021_IMAGE_WORD_COUNT / 8 * 8, table.Word, outColumns, first);
+		DecodeColumnsScalar(packetWords + vectorEventCount, blockCount - vectorEventCount, 0, table.Word, outColumns, first + vectorEventCount);
+	}
+}
+
+void hurel::sre3021::SRE3021ImageDecoder::DecodePulseHeightEvent(const SRE3021PulseHeightEvent& event, int sampleCount, SRE3021ImageData& outImageData) const
+{
+	const BaselineTable& table = LoadBaseline();
+	outImageData = SRE3021ImageData{};
+	outImageData.Timestamp = event.Timestamp;
+	outImageData.AnodeTimingMode = SRE3021AnodeTimingMode::TRIGGER_FLAG;
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		const SRE3021PulseHeightSample& sample = event.Samples[i];
+		const int pixel = GetPixelOfASICChannel(sample.ChannelId);
+		if (pixel < 0)
+		{
+			continue;
+		}
+		const int X = pixel % 11;
+		const int Y = pixel / 11;
+		outImageData.AnodeValue[X][Y] = static_cast<__int32>(sample.Sample) - table.Word[pixel];
+		outImageData.AnodeTiming[X][Y] = sample.TriggerType == SRE3021TriggerType::ASIC_TRIGGER ? 1 : 0;
+	}
+}
+
+void hurel::sre3021::SRE3021ImageDecoder::DecodePulseHeightEventCompact(const SRE3021PulseHeightEvent& event, int sampleCount, SRE3021CompactImageData& outImageData) const
+{
+	const BaselineTable& table = LoadBaseline();
+	outImageData = SRE3021CompactImageData{};
+	outImageData.Timestamp = event.Timestamp;
+	outImageData.AnodeTimingMode = SRE3021AnodeTimingMode::TRIGGER_FLAG;
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		const SRE3021PulseHeightSample& sample = event.Samples[i];
+		const int pixel = GetPixelOfASICChannel(sample.ChannelId);
+		if (pixel < 0)
+		{
+			continue;
+		}
+		const int X = pixel % 11;
+		const int Y = pixel / 11;
+		outImageData.AnodeValue[Y][X] = SRE3021CompactImageData::Saturate(static_cast<__int32>(sample.Sample) - table.Word[pixel]);
+		outImageData.AnodeTiming[Y][X] = sample.TriggerType == SRE3021TriggerType::ASIC_TRIGGER ? 1 : 0;
+	}
+}
+
+void hurel::sre3021::SRE3021ImageDecoder::DecodeChannelEvent(const SRE3021PulseHeightData& data, SRE3021ChannelEvent& outEvent) const
+{
+	const BaselineTable& table = LoadBaseline();
+	const int pixel = GetPixelOfASICChannel(data.ChannelId);
+	const __int32 sample = data.SampleCount > 0 ? static_cast<__int32>(data.Samples[data.SampleCount - 1]) : 0;
+	outEvent.Timestamp = 0;
+	outEvent.ReceiveTime = 0;
+	outEvent.Value = pixel < 0 ? sample : sample - table.Word[pixel];
+	outEvent.ChannelId = static_cast<__int16>(data.ChannelId);
+	outEvent.Pixel = static_cast<__int16>(pixel);
+}
+
+SRE3021SimdLevel hurel::sre3021::SRE3021ImageDecoder::DetectSimdLevel()
+{
+#if SRE3021_HAS_X86_SIMD
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+	__cpuid(info, 1);
+	const bool hasSSE2 = (info[3] & (1 << 26)) != 0;
+	const bool hasOSXSave = (info[2] & (1 << 27)) != 0;
+	bool hasAVX2 = false;
+	if (maxLeaf >= 7 && hasOSXSave && (_xgetbv(0) & 0x6) == 0x6)
+	{
+		__cpuidex(info, 7, 0);
+		hasAVX2 = (info[1] & (1 << 5)) != 0;
+	}
+#else
+	__builtin_cpu_init();
+	const bool hasSSE2 = __builtin_cpu_supports("sse2");
+	const bool hasAVX2 = __builtin_cpu_supports("avx2");
+#endif
+	if (hasAVX2)
+	{
+		return SRE3021SimdLevel::AVX2;
+	}
+	if (hasSSE2)
+	{
+		return SRE3021SimdLevel::SSE2;
+	}
+#endif
+	return SRE3021SimdLevel::SCALAR;
+}
+
+void hurel::sre3021::SRE3021ImageDecoder::SetSimdLevel(SRE3021SimdLevel level)
+{
+	const SRE3021SimdLevel detected = DetectSimdLevel();
+	simdLevel = static_cast<int>(level) > static_cast<int>(detected) ? detected : level;
+}
@@ -0,0 +1,167 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "SRE3021Types.h"
+#include "SRE3021CompactImageData.h"
+#include "SRE3021ImageColumns.h"
+#include "SRE3021HeaderCodec.h"
+#include "SRE3021PulseHeightDecoder.h"
+
+#define SRE3021_IMAGE_PIXEL_COUNT (121)
+// Anode values at byte 30 and anode timings at byte 272 form one run of big endian words
+#define SRE3021_IMAGE_WORD_OFFSET (30)
+#define SRE3021_IMAGE_WORD_COUNT (2 * SRE3021_IMAGE_PIXEL_COUNT)
+#define SRE3021_IMAGE_ROW_COUNT (22)
+// Packets decoded together. 256 packets, 128 KB, stay in L2 while their words go to the columns 8 columns at a time,
+// so only a few output streams are open at once.
+#define SRE3021_IMAGE_BATCH_BLOCK (256)
+#define SRE3021_ASIC_CHANNEL_COUNT (128)
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SRE3021_HAS_X86_SIMD (1)
+#endif
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Instruction set used by SRE3021ImageDecoder
+        /// </summary>
+        enum class SRE3021SimdLevel
+        {
+            SCALAR = 0,
+            SSE2 = 1,
+            AVX2 = 2
+        };
+
+        /// <summary>
+        /// Decodes image packets in one pass: byte-swaps the 242 anode words and subtracts a baseline kept in packet order.
+        /// Uses AVX2 or SSE2 when the CPU has it, picked at construction.
+        /// SetBaseline may run while other threads decode, each decode uses either the old or the new baseline as a whole.
+        /// </summary>
+        class SRE3021ImageDecoder
+        {
+        public:
+            SRE3021ImageDecoder();
+
+            /// <summary>
+            /// Copy baselines indexed [X][Y] into packet order. The previous table is kept for decodes still reading it,
+            /// about 2.4 KB per call for the life of the decoder.
+            /// </summary>
+            void SetBaseline(const size_t (*anodeValueBaseline)[11], const size_t (*anodeTimingBaseline)[11],
+                size_t cathodeValueBaseline, size_t cathodeTimingBaseline);
+
+            /// <summary>
+            /// Timestamp is set to the 32 bit header time stamp and ReceiveTime to 0, the UDP listener fills in both
+            /// </summary>
+            void Decode(const unsigned __int8* packet, SRE3021ImageData& outImageData) const;
+
+            /// <summary>
+            /// Decode into 16 bit planes. The packet must be followed by readable memory up to byte 524, as in a packet pool slot.
+            /// </summary>
+            void DecodeCompact(const unsigned __int8* packet, SRE3021CompactImageData& outImageData) const;
+
+            /// <summary>
+            /// Baseline subtracted anode words in packet order: 121 values then 121 timings, pixel index Y * 11 + X.
+            /// </summary>
+            void DecodeWords(const unsigned __int8* packet, __int32* outWords) const;
+
+            /// <summary>
+            /// Decode a run of image packets into columns, replacing one SRE3021ImageData per event.
+            /// Time stamps are extended to 64 bits starting from the first packet of each SystemNumber in the run.
+            /// </summary>
+            /// <param name="packets">first image packet, the next one starts packetStride bytes later</param>
+            /// <param name="packetCount">number of packets, outColumns is resized to it</param>
+            void DecodeBatch(const unsigned __int8* packets, size_t packetCount, SRE3021ImageColumns& outColumns,
+                size_t packetStride = SRE3021_IMAGE_PACKET_LENGTH) const;
+
+            /// <summary>
+            /// Image event from one event of multi-event pulse-height data. Samples go to the pixel of their ASIC channel,
+            /// see ASICChannelNumber, with the anode value baseline subtracted. Pixels without a sample and the cathode are 0.
+            /// AnodeTimingMode is TRIGGER_FLAG. Timestamp is the event time stamp and ReceiveTime 0.
+            /// </summary>
+            void DecodePulseHeightEvent(const SRE3021PulseHeightEvent& event, int sampleCount, SRE3021ImageData& outImageData) const;
+
+            void DecodePulseHeightEventCompact(const SRE3021PulseHeightEvent& event, int sampleCount, SRE3021CompactImageData& outImageData) const;
+
+            /// <summary>
+            /// Channel event from single-event pulse-height data of a single channel readout. The channel is the last one read out,
+            /// Value its sample. Timestamp and ReceiveTime are 0, the UDP listener fills in both.
+            /// </summary>
+            void DecodeChannelEvent(const SRE3021PulseHeightData& data, SRE3021ChannelEvent& outEvent) const;
+
+            /// <summary>
+            /// Pixel index Y * 11 + X of an ASIC channel, -1 for channels not connected to an anode pixel
+            /// </summary>
+            int GetPixelOfASICChannel(int channel) const
+            {
+                return channel >= 0 && channel < SRE3021_ASIC_CHANNEL_COUNT ? asicChannelPixel[channel] : -1;
+            };
+
+            /// <summary>
+            /// Best instruction set of this CPU
+            /// </summary>
+            static SRE3021SimdLevel DetectSimdLevel();
+
+            /// <summary>
+            /// Use a lower instruction set than detected, e.g. to compare kernels. Requests above the detected level are clamped.
+            /// </summary>
+            void SetSimdLevel(SRE3021SimdLevel level);
+
+            SRE3021SimdLevel GetSimdLevel() const
+            {
+                return simdLevel;
+            };
+
+        private:
+            struct BaselineTable {
+                __int32 Word[SRE3021_IMAGE_WORD_COUNT];
+                // Packet rows, anode values then anode timings, padded like SRE3021CompactImageData
+                __int32 Row[SRE3021_IMAGE_ROW_COUNT][SRE3021_COMPACT_ROW_STRIDE];
+                long long CathodeValue;
+                long long CathodeTiming;
+            };
+
+            const BaselineTable& LoadBaseline() const
+            {
+                return *baseline.load(std::memory_order_acquire);
+            };
+
+            // A table is never changed once published. SetBaseline publishes a new one and keeps the old ones,
+            // a decode that loaded one before may still be reading it.
+            std::atomic<const BaselineTable*> baseline;
+            std::mutex mutexBaselineTables;
+            std::vector<std::unique_ptr<BaselineTable>> baselineTables;
+            int asicChannelPixel[SRE3021_ASIC_CHANNEL_COUNT];
+            SRE3021SimdLevel simdLevel = SRE3021SimdLevel::SCALAR;
+        };
+    };
+};
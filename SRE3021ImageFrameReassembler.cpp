@@ -0,0 +1,192 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021ImageFrameReassembler.h"
+
+#include <cstring>
+
+using namespace hurel::sre3021;
+
+// Counters only the thread calling Add writes
+static void Increment(std::atomic<size_t>& counter)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void hurel::sre3021::SRE3021ImageFrameReassembler::Allocate(size_t count, size_t dataCapacity)
+{
+	frameCount = count;
+	packetDataCapacity = dataCapacity;
+	// Rounded up to a cache line so frame buffers do not share one
+	frameStride = (SRE3021_IMAGE_DATA_OFFSET + SRE3021_IMAGE_FRAME_PACKET_MAX * packetDataCapacity + 63) & ~static_cast<size_t>(63);
+	storage = std::vector<unsigned __int8>(frameCount * frameStride);
+	frames.reset(new Frame[frameCount]);
+	for (size_t i = 0; i < frameCount; ++i)
+	{
+		frames[i].IsUsed.store(false, std::memory_order_relaxed);
+		frames[i].IsPending = false;
+	}
+}
+
+void hurel::sre3021::SRE3021ImageFrameReassembler::ExpireFrames(long long receiveTime)
+{
+	for (size_t i = 0; i < frameCount; ++i)
+	{
+		Frame& frame = frames[i];
+		if (frame.IsPending && receiveTime - frame.FirstReceiveTime > timeout)
+		{
+			frame.IsPending = false;
+			frame.IsUsed.store(false, std::memory_order_release);
+			Increment(timedOutCount);
+		}
+	}
+}
+
+SRE3021ImageFrameStatus hurel::sre3021::SRE3021ImageFrameReassembler::Add(const unsigned __int8* packet, int packetLength, long long receiveTime,
+	unsigned __int32& outFrameIndex, unsigned __int32& outFrameLength)
+{
+	const int dataLength = packetLength - SRE3021_IMAGE_DATA_OFFSET;
+	const int dataPacketCount = DecodeDataPacketCount(packet);
+	const int dataSequence = static_cast<int>(SRE3021HeaderCodec::ReadBigEndian16(packet + SRE3021_IMAGE_FIELDS_OFFSET + 16));
+	if (dataLength < 0 || static_cast<size_t>(dataLength) > packetDataCapacity
+		|| dataPacketCount < 1 || dataPacketCount > SRE3021_IMAGE_FRAME_PACKET_MAX || dataSequence >= dataPacketCount)
+	{
+		Increment(invalidCount);
+		return SRE3021ImageFrameStatus::INVALID;
+	}
+	ExpireFrames(receiveTime);
+
+	const int systemNumber = SRE3021HeaderCodec::DecodeSystemNumber(packet);
+	const int frameNumber = static_cast<int>(SRE3021HeaderCodec::ReadBigEndian16(packet + SRE3021_IMAGE_FIELDS_OFFSET));
+	size_t index = frameCount;
+	size_t freeIndex = frameCount;
+	for (size_t i = 0; i < frameCount; ++i)
+	{
+		if (frames[i].IsPending)
+		{
+			if (frames[i].SystemNumber == systemNumber && frames[i].FrameNumber == frameNumber)
+			{
+				index = i;
+				break;
+			}
+		}
+		else if (freeIndex == frameCount && !frames[i].IsUsed.load(std::memory_order_acquire))
+		{
+			freeIndex = i;
+		}
+	}
+
+	unsigned __int8* data;
+	if (index == frameCount)
+	{
+		if (freeIndex == frameCount)
+		{
+			Increment(noFreeFrameCount);
+			return SRE3021ImageFrameStatus::NO_FREE_FRAME;
+		}
+		index = freeIndex;
+		Frame& frame = frames[index];
+		frame.IsUsed.store(true, std::memory_order_relaxed);
+		frame.IsPending = true;
+		frame.SystemNumber = systemNumber;
+		frame.FrameNumber = frameNumber;
+		frame.DataPacketCount = dataPacketCount;
+		frame.ReceivedMask = 0;
+		frame.FirstReceiveTime = receiveTime;
+		data = Data(static_cast<unsigned __int32>(index));
+		std::memcpy(data, packet, SRE3021_IMAGE_DATA_OFFSET);
+	}
+	else
+	{
+		data = Data(static_cast<unsigned __int32>(index));
+	}
+
+	Frame& frame = frames[index];
+	if (frame.DataPacketCount != dataPacketCount)
+	{
+		Increment(invalidCount);
+		return SRE3021ImageFrameStatus::INVALID;
+	}
+	const unsigned long long bit = 1ULL << dataSequence;
+	if ((frame.ReceivedMask & bit) != 0)
+	{
+		Increment(duplicateCount);
+		return SRE3021ImageFrameStatus::DUPLICATE;
+	}
+	std::memcpy(data + SRE3021_IMAGE_DATA_OFFSET + dataSequence * packetDataCapacity, packet + SRE3021_IMAGE_DATA_OFFSET, dataLength);
+	frame.DataLengths[dataSequence] = static_cast<unsigned __int16>(dataLength);
+	frame.ReceivedMask |= bit;
+	if (frame.ReceivedMask != (dataPacketCount == 64 ? ~0ULL : (1ULL << dataPacketCount) - 1))
+	{
+		return SRE3021ImageFrameStatus::INCOMPLETE;
+	}
+
+	// Close the gaps after short packets, regions only move towards the front
+	size_t frameLength = SRE3021_IMAGE_DATA_OFFSET;
+	for (int i = 0; i < dataPacketCount; ++i)
+	{
+		const unsigned __int8* region = data + SRE3021_IMAGE_DATA_OFFSET + i * packetDataCapacity;
+		if (data + frameLength != region)
+		{
+			std::memmove(data + frameLength, region, frame.DataLengths[i]);
+		}
+		frameLength += frame.DataLengths[i];
+	}
+	// Header and fields of a single packet image. The Data Length field saturates for frames beyond 64 kB.
+	const size_t headerDataLength = frameLength - SRE3021_PACKET_HEADER_LENGTH < 0xFFFF ? frameLength - SRE3021_PACKET_HEADER_LENGTH : 0xFFFF;
+	data[8] = static_cast<unsigned __int8>(headerDataLength >> 8);
+	data[9] = static_cast<unsigned __int8>(headerDataLength);
+	data[SRE3021_IMAGE_FIELDS_OFFSET + 14] = 0;
+	data[SRE3021_IMAGE_FIELDS_OFFSET + 15] = 1;
+	data[SRE3021_IMAGE_FIELDS_OFFSET + 16] = 0;
+	data[SRE3021_IMAGE_FIELDS_OFFSET + 17] = 0;
+
+	frame.IsPending = false;
+	Increment(completedCount);
+	outFrameIndex = static_cast<unsigned __int32>(index);
+	outFrameLength = static_cast<unsigned __int32>(frameLength);
+	return SRE3021ImageFrameStatus::COMPLETE;
+}
+
+SRE3021PacketDecodeStatus hurel::sre3021::SRE3021ImageFrameReassembler::DecodeImageFrame(const unsigned __int8* packet, int packetLength, SRE3021ImageFrame& outFrame)
+{
+	if (packetLength < SRE3021_IMAGE_DATA_OFFSET)
+	{
+		return SRE3021PacketDecodeStatus::ERROR_DATA_LENGTH;
+	}
+	const unsigned __int8* fields = packet + SRE3021_IMAGE_FIELDS_OFFSET;
+	outFrame.SystemNumber = SRE3021HeaderCodec::DecodeSystemNumber(packet);
+	outFrame.FrameNumber = static_cast<int>(SRE3021HeaderCodec::ReadBigEndian16(fields));
+	outFrame.Width = static_cast<int>(SRE3021HeaderCodec::ReadBigEndian16(fields + 2));
+	outFrame.Height = static_cast<int>(SRE3021HeaderCodec::ReadBigEndian16(fields + 4));
+	outFrame.SpectralChannels = static_cast<int>(SRE3021HeaderCodec::ReadBigEndian16(fields + 6));
+	outFrame.DataWidth = fields[9];
+	outFrame.UserDefined = SRE3021HeaderCodec::ReadBigEndian32(fields + 10);
+	outFrame.Data = packet + SRE3021_IMAGE_DATA_OFFSET;
+	outFrame.DataLength = static_cast<size_t>(packetLength - SRE3021_IMAGE_DATA_OFFSET);
+	outFrame.Timestamp = SRE3021HeaderCodec::DecodeTimestamp(packet);
+	outFrame.ReceiveTime = 0;
+	return SRE3021PacketDecodeStatus::SUCCESS;
+}
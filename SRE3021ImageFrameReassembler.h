@@ -0,0 +1,143 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "SRE3021Types.h"
+#include "SRE3021HeaderCodec.h"
+
+// Image data fields after the packet header: frame number, width, height, spectral channels (2 bytes each), a reserved byte,
+// data width (1 byte), user defined (4 bytes), number of data packets and position in the sequence (2 bytes each)
+#define SRE3021_IMAGE_FIELDS_OFFSET (SRE3021_PACKET_HEADER_LENGTH)
+#define SRE3021_IMAGE_FIELDS_LENGTH (18)
+#define SRE3021_IMAGE_DATA_OFFSET (SRE3021_IMAGE_FIELDS_OFFSET + SRE3021_IMAGE_FIELDS_LENGTH)
+#define SRE3021_IMAGE_FRAME_PACKET_MAX (64)
+#define SRE3021_IMAGE_FRAME_POOL_SIZE (32)
+#define SRE3021_IMAGE_FRAME_TIMEOUT_MS (100)
+// Packet slot indices with this bit set name a frame buffer of the reassembler instead of a packet pool slot
+#define SRE3021_IMAGE_FRAME_SLOT_FLAG (0x80000000u)
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// A whole image. Data is the big endian pixel data, DataWidth bytes per pixel, valid while its slot is held.
+        /// Timestamp and ReceiveTime are as in SRE3021ImageData.
+        /// </summary>
+        struct SRE3021ImageFrame {
+            int SystemNumber; int FrameNumber; int Width; int Height; int SpectralChannels; int DataWidth; unsigned __int32 UserDefined;
+            const unsigned __int8* Data; size_t DataLength; unsigned long long Timestamp; long long ReceiveTime;
+        };
+
+        struct SRE3021ImageFrameStats {
+            size_t Completed; size_t TimedOut; size_t Duplicate; size_t NoFreeFrame; size_t Invalid;
+        };
+
+        /// <summary>
+        /// Puts images split over several image data packets back together in a fixed pool of frame buffers.
+        /// Frames are keyed by SystemNumber and frame number, packets may arrive in any order. A frame still missing packets
+        /// after the timeout is dropped. A completed frame is laid out as a single image data packet and keeps its buffer
+        /// until Release.
+        /// Add is called by one thread, Release may be called from any thread.
+        /// </summary>
+        class SRE3021ImageFrameReassembler
+        {
+        public:
+            SRE3021ImageFrameReassembler() {};
+
+            /// <summary>
+            /// Allocate all frame buffers up front. Not thread safe, call only while no thread uses the reassembler.
+            /// </summary>
+            /// <param name="frameCount">number of frame buffers, frames being put together and frames not released yet</param>
+            /// <param name="packetDataCapacity">largest image data in one packet, after the image data fields</param>
+            void Allocate(size_t frameCount, size_t packetDataCapacity);
+
+            void SetTimeout(long long timeoutNanoseconds)
+            {
+                timeout = timeoutNanoseconds;
+            };
+
+            /// <summary>
+            /// Store an image data packet
+            /// </summary>
+            /// <param name="receiveTime">steady clock time of the packet in nanoseconds, for the timeout</param>
+            /// <param name="outFrameIndex">on COMPLETE, the frame buffer to pass to Data and Release</param>
+            /// <param name="outFrameLength">on COMPLETE, length of the frame laid out as one packet</param>
+            SRE3021ImageFrameStatus Add(const unsigned __int8* packet, int packetLength, long long receiveTime,
+                unsigned __int32& outFrameIndex, unsigned __int32& outFrameLength);
+
+            unsigned __int8* Data(unsigned __int32 index)
+            {
+                return &storage[static_cast<size_t>(index) * frameStride];
+            };
+
+            void Release(unsigned __int32 index)
+            {
+                frames[index].IsUsed.store(false, std::memory_order_release);
+            };
+
+            SRE3021ImageFrameStats GetStats() const
+            {
+                return SRE3021ImageFrameStats{ completedCount.load(std::memory_order_relaxed), timedOutCount.load(std::memory_order_relaxed),
+                    duplicateCount.load(std::memory_order_relaxed), noFreeFrameCount.load(std::memory_order_relaxed), invalidCount.load(std::memory_order_relaxed) };
+            };
+
+            static int DecodeDataPacketCount(const unsigned __int8* packet)
+            {
+                return static_cast<int>(SRE3021HeaderCodec::ReadBigEndian16(packet + SRE3021_IMAGE_FIELDS_OFFSET + 14));
+            };
+
+            /// <summary>
+            /// Read the image data fields of a packet holding a whole image
+            /// </summary>
+            static SRE3021PacketDecodeStatus DecodeImageFrame(const unsigned __int8* packet, int packetLength, SRE3021ImageFrame& outFrame);
+
+        private:
+            struct Frame {
+                std::atomic<bool> IsUsed; bool IsPending; int SystemNumber; int FrameNumber; int DataPacketCount;
+                unsigned long long ReceivedMask; long long FirstReceiveTime; unsigned __int16 DataLengths[SRE3021_IMAGE_FRAME_PACKET_MAX];
+            };
+
+            void ExpireFrames(long long receiveTime);
+
+            // Frame buffer: the fields of the first packet, then one packetDataCapacity region per packet position
+            std::vector<unsigned __int8> storage;
+            std::unique_ptr<Frame[]> frames;
+            size_t frameCount = 0;
+            size_t frameStride = 0;
+            size_t packetDataCapacity = 0;
+            long long timeout = SRE3021_IMAGE_FRAME_TIMEOUT_MS * 1000000LL;
+
+            std::atomic<size_t> completedCount{ 0 };
+            std::atomic<size_t> timedOutCount{ 0 };
+            std::atomic<size_t> duplicateCount{ 0 };
+            std::atomic<size_t> noFreeFrameCount{ 0 };
+            std::atomic<size_t> invalidCount{ 0 };
+        };
+    };
+};
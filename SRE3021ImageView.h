@@ -0,0 +1,157 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include "SRE3021Types.h"
+#include "SRE3021HeaderCodec.h"
+
+#define SRE3021_IMAGE_CATHODE_VALUE_OFFSET (20)
+#define SRE3021_IMAGE_CATHODE_TIMING_OFFSET (22)
+#define SRE3021_IMAGE_ANODE_VALUE_OFFSET (30)
+#define SRE3021_IMAGE_ANODE_TIMING_OFFSET (272)
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Read-only view of an image packet in its receive slot. Values are byte-swapped and baseline subtracted
+        /// only when asked for, so a function that looks at a few pixels does not pay for decoding all of them.
+        /// Valid only while the slot is held, i.e. during the image processing call it is passed to.
+        /// </summary>
+        class SRE3021ImageView
+        {
+        public:
+            SRE3021ImageView(const unsigned __int8* packet,
+                const size_t (*anodeValueBaseline)[11], const size_t (*anodeTimingBaseline)[11],
+                size_t cathodeValueBaseline, size_t cathodeTimingBaseline, unsigned long long timestamp = 0, long long receiveTime = 0) :
+                bytes(packet), anodeValueBaseline(anodeValueBaseline), anodeTimingBaseline(anodeTimingBaseline),
+                cathodeValueBaseline(cathodeValueBaseline), cathodeTimingBaseline(cathodeTimingBaseline),
+                timestamp(timestamp), receiveTime(receiveTime)
+            {
+            };
+
+            /// <summary>
+            /// Header time stamp extended to 64 bits, as in SRE3021ImageData
+            /// </summary>
+            unsigned long long Timestamp() const
+            {
+                return timestamp;
+            };
+
+            /// <summary>
+            /// Host steady_clock nanoseconds at which the packet was received
+            /// </summary>
+            long long ReceiveTime() const
+            {
+                return receiveTime;
+            };
+
+            /// <summary>
+            /// 32 bit time stamp as sent in the header
+            /// </summary>
+            unsigned __int32 RawTimestamp() const
+            {
+                return SRE3021HeaderCodec::DecodeTimestamp(bytes);
+            };
+
+            long long AnodeValue(int X, int Y) const
+            {
+                return static_cast<long long>(RawAnodeValue(X, Y)) - static_cast<long long>(anodeValueBaseline[X][Y]);
+            };
+
+            long long AnodeTiming(int X, int Y) const
+            {
+                return static_cast<long long>(RawAnodeTiming(X, Y)) - static_cast<long long>(anodeTimingBaseline[X][Y]);
+            };
+
+            long long CathodeValue() const
+            {
+                return static_cast<long long>(ReadWord(SRE3021_IMAGE_CATHODE_VALUE_OFFSET)) - static_cast<long long>(cathodeValueBaseline);
+            };
+
+            long long CathodeTiming() const
+            {
+                return static_cast<long long>(ReadWord(SRE3021_IMAGE_CATHODE_TIMING_OFFSET)) - static_cast<long long>(cathodeTimingBaseline);
+            };
+
+            /// <summary>
+            /// Pixel values as sent by the detector, without baseline subtraction
+            /// </summary>
+            unsigned __int16 RawAnodeValue(int X, int Y) const
+            {
+                return ReadWord(SRE3021_IMAGE_ANODE_VALUE_OFFSET + 2 * (Y * 11 + X));
+            };
+
+            unsigned __int16 RawAnodeTiming(int X, int Y) const
+            {
+                return ReadWord(SRE3021_IMAGE_ANODE_TIMING_OFFSET + 2 * (Y * 11 + X));
+            };
+
+            /// <summary>
+            /// Whole packet, starting with the packet header
+            /// </summary>
+            const unsigned __int8* Data() const
+            {
+                return bytes;
+            };
+
+            /// <summary>
+            /// Decode every pixel, same result as the SRE3021ImageData passed to image processing functions
+            /// </summary>
+            SRE3021ImageData Decode() const
+            {
+                SRE3021ImageData imageData;
+                imageData.CathodeValue = CathodeValue();
+                imageData.CathodeTiming = CathodeTiming();
+                imageData.Timestamp = timestamp;
+                imageData.ReceiveTime = receiveTime;
+                for (int Y = 0; Y < 11; ++Y)
+                {
+                    for (int X = 0; X < 11; ++X)
+                    {
+                        imageData.AnodeValue[X][Y] = AnodeValue(X, Y);
+                        imageData.AnodeTiming[X][Y] = AnodeTiming(X, Y);
+                    }
+                }
+                return imageData;
+            };
+
+        private:
+            // Image data is big endian on the wire
+            unsigned __int16 ReadWord(int offset) const
+            {
+                return static_cast<unsigned __int16>((bytes[offset] << 8) | bytes[offset + 1]);
+            };
+
+            const unsigned __int8* bytes;
+            const size_t (*anodeValueBaseline)[11];
+            const size_t (*anodeTimingBaseline)[11];
+            size_t cathodeValueBaseline;
+            size_t cathodeTimingBaseline;
+            unsigned long long timestamp;
+            long long receiveTime;
+        };
+    };
+};
@@ -0,0 +1,390 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021IoUringReceiver.h"
+
+#if SRE3021_HAS_IO_URING
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+using namespace hurel::sre3021;
+
+#define SRE3021_IO_URING_BUFFER_GROUP (0)
+// user_data of the multishot recv and of its cancel request
+#define SRE3021_IO_URING_RECV_USER_DATA (1)
+#define SRE3021_IO_URING_CANCEL_USER_DATA (2)
+// Close waits at most this many timeouts for the cancelled recv to complete
+#define SRE3021_IO_URING_CANCEL_WAIT_COUNT (10)
+#define SRE3021_IO_URING_CANCEL_WAIT_MS (100)
+
+hurel::sre3021::SRE3021IoUringReceiver::~SRE3021IoUringReceiver()
+{
+	Close();
+}
+
+#if SRE3021_HAS_IO_URING
+
+bool hurel::sre3021::SRE3021IoUringReceiver::Open(int socketHandle, SRE3021PacketPool& pool)
+{
+	Close();
+	if (pool.GetSlotCount() > 0x10000)
+	{
+		printf("io_uring: pool slot index does not fit the 16 bit buffer id\n");
+		return false;
+	}
+	socketFd = socketHandle;
+	packetPool = &pool;
+
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	ringFd = static_cast<int>(syscall(__NR_io_uring_setup, SRE3021_IO_URING_QUEUE_DEPTH, &params));
+	if (ringFd < 0)
+	{
+		printf("io_uring: setup failed, errno %d\n", errno);
+		ringFd = -1;
+		return false;
+	}
+	if (!(params.features & IORING_FEAT_EXT_ARG))
+	{
+		printf("io_uring: kernel has no wait timeout support\n");
+		Close();
+		return false;
+	}
+
+	sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		sqRingSize = cqRingSize = sqRingSize > cqRingSize ? sqRingSize : cqRingSize;
+	}
+	sqRingPtr = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+	if (sqRingPtr == MAP_FAILED)
+	{
+		sqRingPtr = nullptr;
+		Close();
+		return false;
+	}
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		cqRingPtr = sqRingPtr;
+	}
+	else
+	{
+		cqRingPtr = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+		if (cqRingPtr == MAP_FAILED)
+		{
+			cqRingPtr = nullptr;
+			Close();
+			return false;
+		}
+	}
+	sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	sqesPtr = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+	if (sqesPtr == MAP_FAILED)
+	{
+		sqesPtr = nullptr;
+		Close();
+		return false;
+	}
+
+	char* sq = static_cast<char*>(sqRingPtr);
+	sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+	char* cq = static_cast<char*>(cqRingPtr);
+	cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	cqes = cq + params.cq_off.cqes;
+
+	// Provided buffer ring, the kernel needs it page aligned
+	bufRingSize = SRE3021_IO_URING_BUFFER_COUNT * sizeof(io_uring_buf);
+	bufRing = mmap(nullptr, bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (bufRing == MAP_FAILED)
+	{
+		bufRing = nullptr;
+		Close();
+		return false;
+	}
+	io_uring_buf_reg reg;
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = reinterpret_cast<unsigned long long>(bufRing);
+	reg.ring_entries = SRE3021_IO_URING_BUFFER_COUNT;
+	reg.bgid = SRE3021_IO_URING_BUFFER_GROUP;
+	if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+	{
+		printf("io_uring: provided buffer ring not supported, errno %d\n", errno);
+		Close();
+		return false;
+	}
+
+	bufRingTail = 0;
+	providedBufferCount = 0;
+	isRecvArmed = false;
+	pendingSubmitCount = 0;
+	noBufferCount = 0;
+	TopUpBuffers();
+	return true;
+}
+
+int hurel::sre3021::SRE3021IoUringReceiver::Receive(SRE3021PacketSlot* outSlots, int maxCount, int timeoutMilliseconds)
+{
+	TopUpBuffers();
+	if (!isRecvArmed && providedBufferCount > 0)
+	{
+		ArmRecv();
+	}
+
+	Enter(timeoutMilliseconds);
+	const long long receiveTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+	unsigned head = *cqHead;
+	const unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+	int receivedCount = 0;
+	io_uring_cqe* cqeArray = static_cast<io_uring_cqe*>(cqes);
+	while (head != tail && receivedCount < maxCount)
+	{
+		const io_uring_cqe& cqe = cqeArray[head & *cqMask];
+		if (cqe.user_data != SRE3021_IO_URING_RECV_USER_DATA)
+		{
+			++head;
+			continue;
+		}
+		if (cqe.flags & IORING_CQE_F_BUFFER)
+		{
+			--providedBufferCount;
+			const unsigned __int32 slotIndex = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+			if (cqe.res >= 0)
+			{
+				outSlots[receivedCount] = SRE3021PacketSlot{ slotIndex, static_cast<unsigned __int32>(cqe.res), 0, receiveTime };
+				++receivedCount;
+			}
+			else
+			{
+				Recycle(slotIndex);
+			}
+		}
+		if (!(cqe.flags & IORING_CQE_F_MORE))
+		{
+			// Multishot recv ended, rearmed on the next call once buffers are available again
+			isRecvArmed = false;
+			if (cqe.res == -ENOBUFS)
+			{
+				++noBufferCount;
+			}
+		}
+		++head;
+	}
+	__atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+	return receivedCount;
+}
+
+void hurel::sre3021::SRE3021IoUringReceiver::Recycle(unsigned __int32 slotIndex)
+{
+	AddBuffer(slotIndex);
+	PublishBuffers();
+}
+
+void hurel::sre3021::SRE3021IoUringReceiver::Close()
+{
+	if (isRecvArmed)
+	{
+		CancelRecv();
+	}
+	// The kernel may still write into the rings and pick buffers until the ring is gone, unmap only after that
+	if (ringFd >= 0)
+	{
+		if (bufRing != nullptr)
+		{
+			io_uring_buf_reg reg;
+			memset(&reg, 0, sizeof(reg));
+			reg.bgid = SRE3021_IO_URING_BUFFER_GROUP;
+			syscall(__NR_io_uring_register, ringFd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+		}
+		close(ringFd);
+		ringFd = -1;
+	}
+	if (bufRing != nullptr)
+	{
+		munmap(bufRing, bufRingSize);
+		bufRing = nullptr;
+	}
+	if (sqesPtr != nullptr)
+	{
+		munmap(sqesPtr, sqesSize);
+		sqesPtr = nullptr;
+	}
+	if (cqRingPtr != nullptr && cqRingPtr != sqRingPtr)
+	{
+		munmap(cqRingPtr, cqRingSize);
+	}
+	cqRingPtr = nullptr;
+	if (sqRingPtr != nullptr)
+	{
+		munmap(sqRingPtr, sqRingSize);
+		sqRingPtr = nullptr;
+	}
+	isRecvArmed = false;
+}
+
+void hurel::sre3021::SRE3021IoUringReceiver::TopUpBuffers()
+{
+	unsigned __int32 slotIndex = 0;
+	bool added = false;
+	while (providedBufferCount < SRE3021_IO_URING_BUFFER_COUNT && packetPool->TryAcquire(slotIndex))
+	{
+		AddBuffer(slotIndex);
+		added = true;
+	}
+	if (added)
+	{
+		PublishBuffers();
+	}
+}
+
+void hurel::sre3021::SRE3021IoUringReceiver::AddBuffer(unsigned __int32 slotIndex)
+{
+	io_uring_buf& buf = static_cast<io_uring_buf*>(bufRing)[bufRingTail & (SRE3021_IO_URING_BUFFER_COUNT - 1)];
+	buf.addr = reinterpret_cast<unsigned long long>(packetPool->Data(slotIndex));
+	buf.len = static_cast<unsigned __int32>(packetPool->GetSlotStride());
+	buf.bid = static_cast<unsigned __int16>(slotIndex);
+	++bufRingTail;
+	++providedBufferCount;
+}
+
+void hurel::sre3021::SRE3021IoUringReceiver::PublishBuffers()
+{
+	// The ring tail overlays resv of the first entry. io_uring_buf_ring is not used because
+	// its flexible array member gets a different offset when compiled as C++.
+	__atomic_store_n(&static_cast<io_uring_buf*>(bufRing)[0].resv, bufRingTail, __ATOMIC_RELEASE);
+}
+
+void hurel::sre3021::SRE3021IoUringReceiver::ArmRecv()
+{
+	io_uring_sqe* sqe = NextSqe();
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = socketFd;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = SRE3021_IO_URING_BUFFER_GROUP;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->user_data = SRE3021_IO_URING_RECV_USER_DATA;
+	isRecvArmed = true;
+}
+
+void hurel::sre3021::SRE3021IoUringReceiver::CancelRecv()
+{
+	io_uring_sqe* sqe = NextSqe();
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = SRE3021_IO_URING_RECV_USER_DATA;
+	sqe->user_data = SRE3021_IO_URING_CANCEL_USER_DATA;
+
+	// Datagrams completed in the meantime are dropped, their slots stay out of the pool like the provided ones
+	for (int i = 0; i < SRE3021_IO_URING_CANCEL_WAIT_COUNT && isRecvArmed; ++i)
+	{
+		Enter(SRE3021_IO_URING_CANCEL_WAIT_MS);
+		unsigned head = *cqHead;
+		const unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+		io_uring_cqe* cqeArray = static_cast<io_uring_cqe*>(cqes);
+		for (; head != tail; ++head)
+		{
+			const io_uring_cqe& cqe = cqeArray[head & *cqMask];
+			if (cqe.user_data == SRE3021_IO_URING_RECV_USER_DATA && !(cqe.flags & IORING_CQE_F_MORE))
+			{
+				isRecvArmed = false;
+			}
+		}
+		__atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+	}
+	if (isRecvArmed)
+	{
+		printf("io_uring: recv did not complete after cancel\n");
+		isRecvArmed = false;
+	}
+}
+
+io_uring_sqe* hurel::sre3021::SRE3021IoUringReceiver::NextSqe()
+{
+	const unsigned tail = *sqTail;
+	const unsigned index = tail & *sqMask;
+	io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqesPtr) + index;
+	memset(sqe, 0, sizeof(io_uring_sqe));
+	sqArray[index] = index;
+	__atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+	++pendingSubmitCount;
+	return sqe;
+}
+
+void hurel::sre3021::SRE3021IoUringReceiver::Enter(int timeoutMilliseconds)
+{
+	// Submit what is pending, and wait for a completion only if there is none yet
+	const bool isEmpty = *cqHead == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+	if (!isEmpty && pendingSubmitCount == 0)
+	{
+		return;
+	}
+	__kernel_timespec timeout;
+	timeout.tv_sec = timeoutMilliseconds / 1000;
+	timeout.tv_nsec = (timeoutMilliseconds % 1000) * 1000000LL;
+	io_uring_getevents_arg arg;
+	memset(&arg, 0, sizeof(arg));
+	arg.ts = reinterpret_cast<unsigned long long>(&timeout);
+	const unsigned waitCount = isEmpty ? 1 : 0;
+	const unsigned flags = waitCount > 0 ? IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG : IORING_ENTER_EXT_ARG;
+	long ret = syscall(__NR_io_uring_enter, ringFd, pendingSubmitCount, waitCount, flags, &arg, sizeof(arg));
+	if (ret >= 0)
+	{
+		pendingSubmitCount -= static_cast<unsigned>(ret);
+	}
+}
+
+#else
+
+bool hurel::sre3021::SRE3021IoUringReceiver::Open(int socketHandle, SRE3021PacketPool& pool)
+{
+	return false;
+}
+
+int hurel::sre3021::SRE3021IoUringReceiver::Receive(SRE3021PacketSlot* outSlots, int maxCount, int timeoutMilliseconds)
+{
+	return 0;
+}
+
+void hurel::sre3021::SRE3021IoUringReceiver::Recycle(unsigned __int32 slotIndex)
+{
+}
+
+void hurel::sre3021::SRE3021IoUringReceiver::Close()
+{
+}
+
+#endif
@@ -0,0 +1,128 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include "SRE3021PacketPool.h"
+
+#if defined(__linux__)
+#define SRE3021_HAS_IO_URING (1)
+struct io_uring_sqe;
+#endif
+
+#define SRE3021_IO_URING_QUEUE_DEPTH (64)
+#define SRE3021_IO_URING_BUFFER_COUNT (4096)
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// io_uring receive engine for a bound UDP socket (Linux only).
+        /// One multishot recv keeps running while the kernel picks buffers from a provided buffer ring.
+        /// The provided buffers are packet pool slots, so datagrams land directly in pool slots.
+        /// Open, Receive, Recycle and Close must be called from the same thread, which is also the pool's acquiring thread.
+        /// </summary>
+        class SRE3021IoUringReceiver
+        {
+        public:
+            SRE3021IoUringReceiver() {};
+            ~SRE3021IoUringReceiver();
+
+            /// <summary>
+            /// Set up the ring and the provided buffer ring. Returns false if the kernel does not support it (needs 6.0 or later).
+            /// </summary>
+            /// <param name="socketHandle">bound UDP socket, stays owned by the caller</param>
+            /// <param name="pool">pool to take buffers from. Slot indices must fit in 16 bits</param>
+            bool Open(int socketHandle, SRE3021PacketPool& pool);
+
+            /// <summary>
+            /// Wait up to timeoutMilliseconds for datagrams and return up to maxCount filled slots.
+            /// ReceiveTime of a slot is the steady clock time its completion was reaped, Timestamp is left 0.
+            /// The caller owns the returned slots. Slots it does not pass on must be given back with Recycle.
+            /// </summary>
+            int Receive(SRE3021PacketSlot* outSlots, int maxCount, int timeoutMilliseconds);
+
+            /// <summary>
+            /// Give a slot returned by Receive straight back to the kernel.
+            /// </summary>
+            void Recycle(unsigned __int32 slotIndex);
+
+            /// <summary>
+            /// Cancel the running recv and wait for its last completion, then tear the ring down.
+            /// Buffers still provided to the kernel are not given back to the pool.
+            /// </summary>
+            void Close();
+
+            bool IsOpen() const
+            {
+                return ringFd >= 0;
+            };
+
+            /// <summary>
+            /// Number of times the multishot recv stopped because no provided buffer was left.
+            /// </summary>
+            size_t GetNoBufferCount() const
+            {
+                return noBufferCount;
+            };
+
+        private:
+#if SRE3021_HAS_IO_URING
+            void TopUpBuffers();
+            void AddBuffer(unsigned __int32 slotIndex);
+            void PublishBuffers();
+            void ArmRecv();
+            void CancelRecv();
+            io_uring_sqe* NextSqe();
+            void Enter(int timeoutMilliseconds);
+
+            int socketFd = -1;
+            SRE3021PacketPool* packetPool = nullptr;
+
+            void* sqRingPtr = nullptr;
+            size_t sqRingSize = 0;
+            void* cqRingPtr = nullptr;
+            size_t cqRingSize = 0;
+            void* sqesPtr = nullptr;
+            size_t sqesSize = 0;
+            unsigned* sqTail = nullptr;
+            unsigned* sqMask = nullptr;
+            unsigned* sqArray = nullptr;
+            unsigned* cqHead = nullptr;
+            unsigned* cqTail = nullptr;
+            unsigned* cqMask = nullptr;
+            void* cqes = nullptr;
+            unsigned pendingSubmitCount = 0;
+
+            void* bufRing = nullptr;
+            size_t bufRingSize = 0;
+            unsigned short bufRingTail = 0;
+            size_t providedBufferCount = 0;
+            bool isRecvArmed = false;
+#endif
+            int ringFd = -1;
+            size_t noBufferCount = 0;
+        };
+    };
+};
@@ -0,0 +1,238 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "SRE3021RingBuffer.h"
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Bounded lock-free ring buffer for any number of producer and consumer threads (D. Vyukov's bounded MPMC queue).
+        /// Capacity is rounded up to a power of two, at least 2.
+        /// Every cell carries a sequence number. A thread first claims a position with a CAS and only then touches the cell,
+        /// and the sequence number tells it when the previous owner of the cell is done, so items are never read while being written.
+        /// A producer can make room by popping the oldest item itself.
+        /// </summary>
+        template <typename T>
+        class SRE3021MPMCRingBuffer
+        {
+        public:
+            SRE3021MPMCRingBuffer()
+            {
+                Resize(2);
+            };
+            SRE3021MPMCRingBuffer(size_t capacity)
+            {
+                Resize(capacity);
+            };
+
+            /// <summary>
+            /// Reallocate the ring and clear all counters. Not thread safe, call only while no thread uses the ring.
+            /// </summary>
+            void Resize(size_t capacity)
+            {
+                size_t roundedCapacity = 2;
+                while (roundedCapacity < capacity)
+                {
+                    roundedCapacity <<= 1;
+                }
+                cells.reset(new Cell[roundedCapacity]);
+                for (size_t i = 0; i < roundedCapacity; ++i)
+                {
+                    cells[i].Sequence.store(i, std::memory_order_relaxed);
+                }
+                cellCount = roundedCapacity;
+                mask = roundedCapacity - 1;
+                enqueuePosition.store(0, std::memory_order_relaxed);
+                dequeuePosition.store(0, std::memory_order_relaxed);
+                highWaterMark.store(0, std::memory_order_relaxed);
+                pushFailCount.store(0, std::memory_order_relaxed);
+            };
+
+            /// <summary>
+            /// Returns false when the ring is full.
+            /// </summary>
+            bool TryPush(const T& item)
+            {
+                size_t position = enqueuePosition.load(std::memory_order_relaxed);
+                Cell* cell;
+                while (true)
+                {
+                    cell = &cells[position & mask];
+                    const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(cell->Sequence.load(std::memory_order_acquire) - position);
+                    if (difference == 0)
+                    {
+                        if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        {
+                            break;
+                        }
+                    }
+                    else if (difference < 0)
+                    {
+                        pushFailCount.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+                    else
+                    {
+                        position = enqueuePosition.load(std::memory_order_relaxed);
+                    }
+                }
+                cell->Item = item;
+                cell->Sequence.store(position + 1, std::memory_order_release);
+                UpdateHighWaterMark(position + 1);
+                return true;
+            };
+
+            /// <summary>
+            /// Returns false when the ring is empty.
+            /// </summary>
+            bool TryPop(T& outItem)
+            {
+                size_t ticket;
+                return TryPop(outItem, ticket, static_cast<size_t>(-1));
+            };
+
+            /// <summary>
+            /// TryPop that also returns the ticket of the item, which numbers the items in push order from 0 at Resize.
+            /// Items at or beyond ticketLimit stay in the ring, so a consumer can bound how far it runs ahead.
+            /// </summary>
+            bool TryPop(T& outItem, size_t& outTicket, size_t ticketLimit)
+            {
+                size_t position = dequeuePosition.load(std::memory_order_relaxed);
+                Cell* cell;
+                while (true)
+                {
+                    if (position >= ticketLimit)
+                    {
+                        return false;
+                    }
+                    cell = &cells[position & mask];
+                    const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(cell->Sequence.load(std::memory_order_acquire) - (position + 1));
+                    if (difference == 0)
+                    {
+                        if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        {
+                            break;
+                        }
+                    }
+                    else if (difference < 0)
+                    {
+                        return false;
+                    }
+                    else
+                    {
+                        position = dequeuePosition.load(std::memory_order_relaxed);
+                    }
+                }
+                outItem = std::move(cell->Item);
+                cell->Sequence.store(position + mask + 1, std::memory_order_release);
+                outTicket = position;
+                return true;
+            };
+
+            bool Full() const
+            {
+                return Size() >= cellCount;
+            };
+
+            /// <summary>
+            /// Number of items currently queued, including pushes and pops still in progress. Approximate while threads are running.
+            /// </summary>
+            size_t Size() const
+            {
+                const size_t currentDequeue = dequeuePosition.load(std::memory_order_acquire);
+                const size_t currentEnqueue = enqueuePosition.load(std::memory_order_acquire);
+                const std::ptrdiff_t size = static_cast<std::ptrdiff_t>(currentEnqueue - currentDequeue);
+                return size < 0 ? 0 : (static_cast<size_t>(size) > cellCount ? cellCount : static_cast<size_t>(size));
+            };
+
+            bool Empty() const
+            {
+                return Size() == 0;
+            };
+
+            size_t Capacity() const
+            {
+                return cellCount;
+            };
+
+            /// <summary>
+            /// Largest occupancy seen by a push since the last Resize or ResetHighWaterMark.
+            /// </summary>
+            size_t HighWaterMark() const
+            {
+                return highWaterMark.load(std::memory_order_relaxed);
+            };
+
+            void ResetHighWaterMark()
+            {
+                highWaterMark.store(Size(), std::memory_order_relaxed);
+            };
+
+            /// <summary>
+            /// Number of TryPush calls rejected because the ring was full.
+            /// </summary>
+            size_t PushFailCount() const
+            {
+                return pushFailCount.load(std::memory_order_relaxed);
+            };
+
+        private:
+            struct Cell {
+                std::atomic<size_t> Sequence; T Item;
+            };
+
+            void UpdateHighWaterMark(size_t newEnqueuePosition)
+            {
+                const size_t occupancy = newEnqueuePosition - dequeuePosition.load(std::memory_order_relaxed);
+                size_t current = highWaterMark.load(std::memory_order_relaxed);
+                while (occupancy > current && occupancy <= cellCount
+                    && !highWaterMark.compare_exchange_weak(current, occupancy, std::memory_order_relaxed))
+                {
+                }
+            };
+
+            // Producer line
+            std::atomic<size_t> enqueuePosition{ 0 };
+            std::atomic<size_t> highWaterMark{ 0 };
+            std::atomic<size_t> pushFailCount{ 0 };
+            char producerPadding[SRE3021_CACHE_LINE_SIZE];
+
+            // Consumer line
+            std::atomic<size_t> dequeuePosition{ 0 };
+            char consumerPadding[SRE3021_CACHE_LINE_SIZE];
+
+            std::unique_ptr<Cell[]> cells;
+            size_t cellCount = 0;
+            size_t mask = 0;
+        };
+    };
+};
@@ -27,25 +27,43 @@
 
 using namespace std;
 using namespace hurel::sre3021;
+
+// Round trips of the header codec, checked by the compiler
+static_assert(SRE3021HeaderCodec::DecodeVersion(SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 5, 0, SRE3021PacketType::UNUSED, SRE3021PacketSequence::STAND_ALONE, 0, 0, 0 }).Bytes) == 5, "Version");
+static_assert(SRE3021HeaderCodec::DecodeSystemNumber(SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 7, 0x1F, SRE3021PacketType::IMG_DATA, SRE3021PacketSequence::LAST_PACKET, 0x3FFF, 0, 0 }).Bytes) == 0x1F, "SystemNumber");
+static_assert(SRE3021HeaderCodec::DecodePacketType(SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 0, 3, SRE3021PacketType::IMG_DATA, SRE3021PacketSequence::STAND_ALONE, 0, 0, 504 }).Bytes) == SRE3021PacketType::IMG_DATA, "PacketType");
+static_assert(SRE3021HeaderCodec::DecodeSequenceFlag(SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 0, 0, SRE3021PacketType::UNUSED, SRE3021PacketSequence::LAST_PACKET, 0x3FFF, 0, 0 }).Bytes) == SRE3021PacketSequence::LAST_PACKET, "SequenceFlag");
+static_assert(SRE3021HeaderCodec::DecodePacketCount(SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 7, 0x1F, SRE3021PacketType::READBACK_ASIC_REG, SRE3021PacketSequence::LAST_PACKET, 0x2A5C, 0xFFFFFFFF, 0xFFFF }).Bytes) == 0x2A5C, "PacketCount");
+static_assert(SRE3021HeaderCodec::DecodePacketCount(SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 0, 0, SRE3021PacketType::UNUSED, SRE3021PacketSequence::STAND_ALONE, 0x4001, 0, 0 }).Bytes) == 1, "PacketCount truncation");
+static_assert(SRE3021HeaderCodec::DecodeReserved(SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 0, 0, SRE3021PacketType::UNUSED, SRE3021PacketSequence::STAND_ALONE, 0, 0x89ABCDEF, 0 }).Bytes) == 0x89ABCDEF, "Reserved");
+static_assert(SRE3021HeaderCodec::DecodeDataLength(SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 0, 0, SRE3021PacketType::UNUSED, SRE3021PacketSequence::STAND_ALONE, 0, 0, 0xBEEF }).Bytes) == 0xBEEF, "DataLength");
+static_assert(SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 0, 2, SRE3021PacketType::READBACK_SYS_REG, SRE3021PacketSequence::FIRST_PACKET, 0x0123, 0, 4 }).Bytes[0] == 0x02
+	&& SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 0, 2, SRE3021PacketType::READBACK_SYS_REG, SRE3021PacketSequence::FIRST_PACKET, 0x0123, 0, 4 }).Bytes[2] == 0x41
+	&& SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 0, 2, SRE3021PacketType::READBACK_SYS_REG, SRE3021PacketSequence::FIRST_PACKET, 0x0123, 0, 4 }).Bytes[9] == 0x04, "Wire order");
+static_assert(SRE3021HeaderCodec::IsValid(SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 0, 1, SRE3021PacketType::IMG_DATA, SRE3021PacketSequence::STAND_ALONE, 9, 0, SRE3021_IMAGE_PACKET_LENGTH - SRE3021_PACKET_HEADER_LENGTH }).Bytes,
+	SRE3021_IMAGE_PACKET_LENGTH, SRE3021PacketType::IMG_DATA), "Valid header");
+static_assert(!SRE3021HeaderCodec::IsValid(SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 1, 1, SRE3021PacketType::IMG_DATA, SRE3021PacketSequence::STAND_ALONE, 9, 0, SRE3021_IMAGE_PACKET_LENGTH - SRE3021_PACKET_HEADER_LENGTH }).Bytes,
+	SRE3021_IMAGE_PACKET_LENGTH, SRE3021PacketType::IMG_DATA), "Wrong version");
+static_assert(!SRE3021HeaderCodec::IsValid(SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 0, 1, SRE3021PacketType::IMG_DATA, SRE3021PacketSequence::STAND_ALONE, 9, 0, SRE3021_IMAGE_PACKET_LENGTH - SRE3021_PACKET_HEADER_LENGTH }).Bytes,
+	SRE3021_IMAGE_PACKET_LENGTH - 1, SRE3021PacketType::IMG_DATA), "Wrong length");
+static_assert(!SRE3021HeaderCodec::IsValid(SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 0, 1, SRE3021PacketType::READBACK_SYS_REG, SRE3021PacketSequence::STAND_ALONE, 9, 0, SRE3021_IMAGE_PACKET_LENGTH - SRE3021_PACKET_HEADER_LENGTH }).Bytes,
+	SRE3021_IMAGE_PACKET_LENGTH, SRE3021PacketType::IMG_DATA), "Wrong type");
+
 SRE3021PacketHeader::SRE3021PacketHeader(unsigned __int8& data)
 {
 	for (int i = 0; i < SRE3021_PACKET_HEADER_LENGTH; ++i)
 	{
 		ByteData[i] = (&data)[i];
 	}
-	unsigned __int8 idPacket[2]{ ByteData[1], ByteData[0] };
-	auto calcPacketID = CalcPacketID(*idPacket);
-	Version = get<0>(calcPacketID);
-	SystemNumber = get<1>(calcPacketID);
-	PacketType = get<2>(calcPacketID);
-
-	unsigned __int8 sequencePacket[2]{ ByteData[3], ByteData[2] };
-	auto calcPacketSequence = CalcPacketSequence(*sequencePacket);
-	SequenceFlag = get<0>(calcPacketSequence);
-	PacketCount = get<1>(calcPacketSequence);
-	Reserved = 0;
-	unsigned __int8 lengthPacket[2]{ ByteData[9], ByteData[8] };
-	DataLength = GetValueFromBytes(*static_cast<unsigned __int16*>(static_cast<void*>(lengthPacket)), 0, 15);
+	const SRE3021HeaderFields fields = SRE3021HeaderCodec::Decode(ByteData);
+	Version = fields.Version;
+	SystemNumber = fields.SystemNumber;
+	PacketType = fields.PacketType;
+	SequenceFlag = fields.SequenceFlag;
+	PacketCount = fields.PacketCount;
+	Reserved = static_cast<int>(fields.Reserved);
+	Timestamp = fields.Reserved;
+	DataLength = fields.DataLength;
 
 	IsFromPCToSys = false;
 }
@@ -60,24 +78,14 @@ SRE3021PacketHeader::SRE3021PacketHeader(SRE3021PacketType packetType, unsigned
 	SequenceFlag = SRE3021PacketSequence::STAND_ALONE;
 	PacketCount = TotalPacketCount;
 	Reserved = 0;
+	Timestamp = 0;
 	DataLength = datalength;
 	IsFromPCToSys = true;
 
-	unsigned __int8 resultPacketID_SysNum = 0x00;
-	unsigned __int8 resultPacket_Type = static_cast<unsigned __int8>(packetType);
-
-	unsigned __int8* resultPacketSequence = static_cast<unsigned __int8*>(static_cast<void*>(&TotalPacketCount));
-
-
-	unsigned __int8 resultPacketTimestamp[4]{0x0, 0x00, 0x00, 0x00};
-
-	unsigned __int8* resultPacketDatalength = static_cast<unsigned __int8*>(static_cast<void*>(&datalength));
-	unsigned __int8 bData[10]{
-		resultPacketID_SysNum, resultPacket_Type, resultPacketSequence[1], resultPacketSequence[0], resultPacketTimestamp[3], resultPacketTimestamp[2], resultPacketTimestamp[1], resultPacketTimestamp[0], resultPacketDatalength[1], resultPacketDatalength[0]
-	};
-	for (int i = 0; i < 10; ++i)
+	const SRE3021HeaderBytes bytes = SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ Version, SystemNumber, PacketType, SequenceFlag, PacketCount, 0, DataLength });
+	for (int i = 0; i < SRE3021_PACKET_HEADER_LENGTH; ++i)
 	{
-		ByteData[i] = bData[i];
+		ByteData[i] = bytes.Bytes[i];
 	}
 	++TotalPacketCount;
 	constexpr int maxTotalPacketCount = 0b0100000000000000 - 1;
@@ -89,59 +97,27 @@ SRE3021PacketHeader::SRE3021PacketHeader(SRE3021PacketType packetType, unsigned
 
 std::tuple<SRE3021PacketSequence, int> SRE3021PacketHeader::CalcPacketSequence(unsigned __int8& data)
 {
-	int seFalg = GetValueFromBytes((&data)[1], 6, 7);
-	unsigned __int8 pData[2]{ (&data)[0], (&data)[1] };
-	int pCount = GetValueFromBytes(*static_cast<unsigned __int16*>(static_cast<void*>(&pData)), 0, 4);
-	return std::tuple<SRE3021PacketSequence, int>(static_cast<SRE3021PacketSequence>(seFalg), pCount);
+	// data holds bytes 3 and 2 of the header, in that order
+	const unsigned __int8 sequenceBytes[2]{ (&data)[1], (&data)[0] };
+	const unsigned int sequence = SRE3021HeaderCodec::ReadBigEndian16(sequenceBytes);
+	return std::tuple<SRE3021PacketSequence, int>(static_cast<SRE3021PacketSequence>(sequence >> 14), static_cast<int>(sequence & 0x3FFF));
 }
 
 
 std::tuple<int, int, SRE3021PacketType> SRE3021PacketHeader::CalcPacketID(unsigned __int8& data)
 {
-	int ver = GetValueFromBytes((&data)[1], 5, 7);
-	int sysNum = GetValueFromBytes((&data)[1], 0, 4);
-	SRE3021PacketType pType = (SRE3021PacketType)GetValueFromBytes((&data)[0], 0, 7);
-
-	return std::tuple<int, int, SRE3021PacketType>(ver, sysNum, pType);
+	// data holds bytes 1 and 0 of the header, in that order
+	const unsigned __int8 idBytes[2]{ (&data)[1], (&data)[0] };
+	return std::tuple<int, int, SRE3021PacketType>(SRE3021HeaderCodec::DecodeVersion(idBytes), SRE3021HeaderCodec::DecodeSystemNumber(idBytes), SRE3021HeaderCodec::DecodePacketType(idBytes));
 }
 
 
 int SRE3021PacketHeader::GetValueFromBytes(unsigned __int8 data, unsigned int startIdx, unsigned int endIdx)
 {
-	bitset<8> bits;
-
-	for (unsigned int i = startIdx; i <= endIdx; ++i)
-	{
-		bool bit = data >> i & 0b0001;
-		bits[i - startIdx] = bit;
-	}
-	return bits.to_ulong();
+	return static_cast<int>((static_cast<unsigned int>(data) >> startIdx) & ((2u << (endIdx - startIdx)) - 1));
 }
 
 int SRE3021PacketHeader::GetValueFromBytes(unsigned __int16 data, unsigned int startIdx, unsigned int endIdx)
 {
-	bitset<16> bits;
-#if LITTLE_ENDIAN
-	for (unsigned int i = startIdx; i <= endIdx; ++i)
-	{
-		bool bit = data >> i & 0b0001;
-		bits[i - startIdx] = bit;
-	}
-#endif
-#if BIG_ENDIAN
-	for (unsigned int i = startIdx; i <= endIdx; ++i)
-	{
-		bool bit = data >> i & 0b0001;
-		if (i - startIdx < 8)
-		{
-			bits[i - startIdx + 7] = bit;
-		}
-		else
-		{
-			bits[i - startIdx - 7] = bit;
-		}
-		
-	}
-#endif
-	return bits.to_ulong();
+	return static_cast<int>((static_cast<unsigned int>(data) >> startIdx) & ((2u << (endIdx - startIdx)) - 1));
 }
@@ -27,9 +27,9 @@
 
 #include <cassert>
 #include <tuple>
-#include <bitset>
 
 #include "SRE3021Types.h"
+#include "SRE3021HeaderCodec.h"
 
 namespace hurel {
     namespace sre3021 {
@@ -67,6 +67,11 @@ namespace hurel {
             /// </summary>
             int Reserved;
 
+            /// <summary>
+            /// 32 bits, the Reserved field read as the hardware time stamp
+            /// </summary>
+            unsigned __int32 Timestamp;
+
             /// <summary>
             /// Uint16, Data length
             /// </summary>
@@ -92,6 +97,22 @@ namespace hurel {
             int GetValueFromBytes(unsigned __int8 data, unsigned int startIdx, unsigned int endIdx);
             int GetValueFromBytes(unsigned __int16 data, unsigned int startIdx, unsigned int endIdx);
 
+            /// <summary>
+            /// 5 bits SystemNumber of raw header bytes, without decoding the whole header
+            /// </summary>
+            static int DecodeSystemNumber(const unsigned __int8* data)
+            {
+                return SRE3021HeaderCodec::DecodeSystemNumber(data);
+            };
+
+            /// <summary>
+            /// 14 bits PacketCount of raw header bytes, without decoding the whole header
+            /// </summary>
+            static int DecodePacketCount(const unsigned __int8* data)
+            {
+                return SRE3021HeaderCodec::DecodePacketCount(data);
+            };
+
 
         };
     }
@@ -0,0 +1,348 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021PacketMmapReceiver.h"
+
+#if SRE3021_HAS_PACKET_MMAP
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#endif
+
+using namespace hurel::sre3021;
+
+hurel::sre3021::SRE3021PacketMmapReceiver::~SRE3021PacketMmapReceiver()
+{
+	Close();
+}
+
+#if SRE3021_HAS_PACKET_MMAP
+
+bool hurel::sre3021::SRE3021PacketMmapReceiver::Open(const std::string& interfaceName, unsigned short port, int fanoutGroupId)
+{
+	Close();
+	udpPort = port;
+
+	const unsigned int interfaceIndex = if_nametoindex(interfaceName.c_str());
+	if (interfaceIndex == 0)
+	{
+		printf("packet mmap: unknown interface %s\n", interfaceName.c_str());
+		return false;
+	}
+
+	socketFd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+	if (socketFd < 0)
+	{
+		printf("packet mmap: socket failed, errno %d\n", errno);
+		socketFd = -1;
+		return false;
+	}
+
+	// udp dst port <port> on ethernet, IPv4 without fragments (tcpdump -dd)
+	sock_filter filterCode[] = {
+		{ 0x28, 0, 0, 0x0000000c },
+		{ 0x15, 0, 8, 0x00000800 },
+		{ 0x30, 0, 0, 0x00000017 },
+		{ 0x15, 0, 6, 0x00000011 },
+		{ 0x28, 0, 0, 0x00000014 },
+		{ 0x45, 4, 0, 0x00001fff },
+		{ 0xb1, 0, 0, 0x0000000e },
+		{ 0x48, 0, 0, 0x00000010 },
+		{ 0x15, 0, 1, port },
+		{ 0x06, 0, 0, 0x00040000 },
+		{ 0x06, 0, 0, 0x00000000 },
+	};
+	sock_fprog filter{ static_cast<unsigned short>(sizeof(filterCode) / sizeof(filterCode[0])), filterCode };
+	if (setsockopt(socketFd, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter)) < 0)
+	{
+		printf("packet mmap: attaching filter failed, errno %d\n", errno);
+	}
+
+	int version = TPACKET_V3;
+	if (setsockopt(socketFd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+	{
+		printf("packet mmap: TPACKET_V3 not supported, errno %d\n", errno);
+		Close();
+		return false;
+	}
+
+	tpacket_req3 req;
+	memset(&req, 0, sizeof(req));
+	req.tp_block_size = SRE3021_PACKET_MMAP_BLOCK_SIZE;
+	req.tp_block_nr = SRE3021_PACKET_MMAP_BLOCK_COUNT;
+	req.tp_frame_size = SRE3021_PACKET_MMAP_FRAME_SIZE;
+	req.tp_frame_nr = SRE3021_PACKET_MMAP_BLOCK_SIZE / SRE3021_PACKET_MMAP_FRAME_SIZE * SRE3021_PACKET_MMAP_BLOCK_COUNT;
+	req.tp_retire_blk_tov = SRE3021_PACKET_MMAP_BLOCK_TIMEOUT_MS;
+	if (setsockopt(socketFd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0)
+	{
+		printf("packet mmap: PACKET_RX_RING failed, errno %d\n", errno);
+		Close();
+		return false;
+	}
+
+	ringSize = static_cast<size_t>(req.tp_block_size) * req.tp_block_nr;
+	void* mapped = mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, socketFd, 0);
+	if (mapped == MAP_FAILED)
+	{
+		mapped = mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_SHARED, socketFd, 0);
+	}
+	if (mapped == MAP_FAILED)
+	{
+		printf("packet mmap: mmap failed, errno %d\n", errno);
+		Close();
+		return false;
+	}
+	ring = static_cast<unsigned __int8*>(mapped);
+
+	sockaddr_ll address;
+	memset(&address, 0, sizeof(address));
+	address.sll_family = AF_PACKET;
+	address.sll_protocol = htons(ETH_P_ALL);
+	address.sll_ifindex = static_cast<int>(interfaceIndex);
+	if (bind(socketFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+	{
+		printf("packet mmap: bind to %s failed, errno %d\n", interfaceName.c_str(), errno);
+		Close();
+		return false;
+	}
+
+	if (fanoutGroupId >= 0)
+	{
+		int fanout = (fanoutGroupId & 0xFFFF) | (PACKET_FANOUT_HASH << 16);
+		if (setsockopt(socketFd, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(fanout)) < 0)
+		{
+			printf("packet mmap: joining fanout group %d failed, errno %d\n", fanoutGroupId, errno);
+			Close();
+			return false;
+		}
+	}
+
+	blockReferences.reset(new std::atomic<int>[SRE3021_PACKET_MMAP_BLOCK_COUNT]);
+	for (int i = 0; i < SRE3021_PACKET_MMAP_BLOCK_COUNT; ++i)
+	{
+		blockReferences[i].store(0, std::memory_order_relaxed);
+	}
+	currentBlock = 0;
+	isInBlock = false;
+	dropCount = 0;
+	return true;
+}
+
+int hurel::sre3021::SRE3021PacketMmapReceiver::Receive(SRE3021PacketSlot* outSlots, int maxCount, int timeoutMilliseconds)
+{
+	int receivedCount = 0;
+	bool isPolled = false;
+	while (receivedCount < maxCount)
+	{
+		const size_t blockOffset = static_cast<size_t>(currentBlock) << SRE3021_PACKET_MMAP_BLOCK_SHIFT;
+		tpacket_block_desc* block = reinterpret_cast<tpacket_block_desc*>(ring + blockOffset);
+		if (!isInBlock)
+		{
+			if (!(__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER))
+			{
+				if (receivedCount > 0 || isPolled)
+				{
+					break;
+				}
+				pollfd pfd{ socketFd, POLLIN | POLLERR, 0 };
+				poll(&pfd, 1, timeoutMilliseconds);
+				isPolled = true;
+				continue;
+			}
+			// The receiver holds one reference until it has walked the whole block
+			blockReferences[currentBlock].store(1, std::memory_order_relaxed);
+			blockReceiveTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+			isInBlock = true;
+			framesLeft = block->hdr.bh1.num_pkts;
+			frameOffset = block->hdr.bh1.offset_to_first_pkt;
+		}
+
+		while (framesLeft > 0 && receivedCount < maxCount)
+		{
+			const tpacket3_hdr* frame = reinterpret_cast<const tpacket3_hdr*>(ring + blockOffset + frameOffset);
+			unsigned __int32 payloadOffset = 0;
+			unsigned __int32 payloadLength = 0;
+			if (ParseFrame(reinterpret_cast<const unsigned __int8*>(frame), payloadOffset, payloadLength))
+			{
+				blockReferences[currentBlock].fetch_add(1, std::memory_order_relaxed);
+				const unsigned __int32 slotIndex = static_cast<unsigned __int32>(blockOffset + frameOffset + payloadOffset);
+				outSlots[receivedCount] = SRE3021PacketSlot{ slotIndex, payloadLength, 0, blockReceiveTime };
+				++receivedCount;
+			}
+			--framesLeft;
+			frameOffset += frame->tp_next_offset;
+		}
+
+		if (framesLeft == 0)
+		{
+			isInBlock = false;
+			const unsigned __int32 finishedBlock = currentBlock;
+			currentBlock = (currentBlock + 1) % SRE3021_PACKET_MMAP_BLOCK_COUNT;
+			if (blockReferences[finishedBlock].fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				ReturnBlock(finishedBlock);
+			}
+		}
+	}
+	return receivedCount;
+}
+
+void hurel::sre3021::SRE3021PacketMmapReceiver::Release(unsigned __int32 slotIndex)
+{
+	const unsigned __int32 blockIndex = slotIndex >> SRE3021_PACKET_MMAP_BLOCK_SHIFT;
+	if (blockReferences[blockIndex].fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		ReturnBlock(blockIndex);
+	}
+}
+
+void hurel::sre3021::SRE3021PacketMmapReceiver::Close()
+{
+	if (ring != nullptr)
+	{
+		munmap(ring, ringSize);
+		ring = nullptr;
+	}
+	if (socketFd >= 0)
+	{
+		close(socketFd);
+		socketFd = -1;
+	}
+	isInBlock = false;
+}
+
+size_t hurel::sre3021::SRE3021PacketMmapReceiver::GetDropCount()
+{
+	if (socketFd < 0)
+	{
+		return dropCount;
+	}
+	// Reading the statistics resets them in the kernel
+	tpacket_stats_v3 stats;
+	socklen_t length = sizeof(stats);
+	if (getsockopt(socketFd, SOL_PACKET, PACKET_STATISTICS, &stats, &length) == 0)
+	{
+		dropCount += stats.tp_drops;
+	}
+	return dropCount;
+}
+
+void hurel::sre3021::SRE3021PacketMmapReceiver::ReturnBlock(unsigned __int32 blockIndex)
+{
+	tpacket_block_desc* block = reinterpret_cast<tpacket_block_desc*>(ring + (static_cast<size_t>(blockIndex) << SRE3021_PACKET_MMAP_BLOCK_SHIFT));
+	__atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+}
+
+bool hurel::sre3021::SRE3021PacketMmapReceiver::ParseFrame(const unsigned __int8* frame, unsigned __int32& outPayloadOffset, unsigned __int32& outPayloadLength)
+{
+	const tpacket3_hdr* header = reinterpret_cast<const tpacket3_hdr*>(frame);
+	const sockaddr_ll* link = reinterpret_cast<const sockaddr_ll*>(frame + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+	if (link->sll_pkttype == PACKET_OUTGOING)
+	{
+		return false;
+	}
+
+	// The kernel has already taken any 802.1Q tag out of the frame, see Open
+	const unsigned __int8* packet = frame + header->tp_mac;
+	const unsigned __int8* packetEnd = packet + header->tp_snaplen;
+	const unsigned __int16 etherType = static_cast<unsigned __int16>(packet[12] << 8 | packet[13]);
+	if (etherType != 0x0800)
+	{
+		return false;
+	}
+
+	const unsigned __int8* ip = packet + 14;
+	if (ip + 20 > packetEnd || (ip[0] >> 4) != 4 || ip[9] != 17)
+	{
+		return false;
+	}
+	// Image datagrams are never fragmented, skip any fragment
+	if ((ip[6] & 0x3F) != 0 || ip[7] != 0)
+	{
+		return false;
+	}
+	const unsigned __int32 ipHeaderLength = (ip[0] & 0x0F) * 4u;
+	const unsigned __int8* udp = ip + ipHeaderLength;
+	if (udp + 8 > packetEnd)
+	{
+		return false;
+	}
+	const unsigned __int16 destinationPort = static_cast<unsigned __int16>(udp[2] << 8 | udp[3]);
+	const unsigned __int16 udpLength = static_cast<unsigned __int16>(udp[4] << 8 | udp[5]);
+	if (destinationPort != udpPort || udpLength < 8 || udp + udpLength > packetEnd)
+	{
+		return false;
+	}
+
+	outPayloadOffset = static_cast<unsigned __int32>(udp + 8 - frame);
+	outPayloadLength = udpLength - 8u;
+	return true;
+}
+
+#else
+
+bool hurel::sre3021::SRE3021PacketMmapReceiver::Open(const std::string& interfaceName, unsigned short port, int fanoutGroupId)
+{
+	return false;
+}
+
+int hurel::sre3021::SRE3021PacketMmapReceiver::Receive(SRE3021PacketSlot* outSlots, int maxCount, int timeoutMilliseconds)
+{
+	return 0;
+}
+
+void hurel::sre3021::SRE3021PacketMmapReceiver::Release(unsigned __int32 slotIndex)
+{
+}
+
+void hurel::sre3021::SRE3021PacketMmapReceiver::Close()
+{
+}
+
+size_t hurel::sre3021::SRE3021PacketMmapReceiver::GetDropCount()
+{
+	return dropCount;
+}
+
+void hurel::sre3021::SRE3021PacketMmapReceiver::ReturnBlock(unsigned __int32 blockIndex)
+{
+}
+
+bool hurel::sre3021::SRE3021PacketMmapReceiver::ParseFrame(const unsigned __int8* frame, unsigned __int32& outPayloadOffset, unsigned __int32& outPayloadLength)
+{
+	return false;
+}
+
+#endif
@@ -0,0 +1,114 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <string>
+#include <memory>
+#include <atomic>
+
+#include "SRE3021PacketPool.h"
+
+#if defined(__linux__)
+#define SRE3021_HAS_PACKET_MMAP (1)
+#endif
+
+#define SRE3021_PACKET_MMAP_BLOCK_SHIFT (20)
+#define SRE3021_PACKET_MMAP_BLOCK_SIZE (1 << SRE3021_PACKET_MMAP_BLOCK_SHIFT)
+#define SRE3021_PACKET_MMAP_BLOCK_COUNT (64)
+#define SRE3021_PACKET_MMAP_FRAME_SIZE (2048)
+#define SRE3021_PACKET_MMAP_BLOCK_TIMEOUT_MS (10)
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Captures UDP datagrams for one port straight from a network interface through a memory mapped
+        /// AF_PACKET TPACKET_V3 ring (Linux only, needs CAP_NET_RAW). IP and UDP headers are parsed here.
+        /// Returned slots point into the ring itself. A ring block goes back to the kernel once every slot
+        /// taken from it has been released, so slots must be released in reasonable time.
+        /// Open and Receive must be called from one thread, Data and Release from any thread.
+        /// </summary>
+        class SRE3021PacketMmapReceiver
+        {
+        public:
+            SRE3021PacketMmapReceiver() {};
+            ~SRE3021PacketMmapReceiver();
+
+            /// <summary>
+            /// Map the capture ring and attach a kernel filter for IPv4 UDP packets to the port.
+            /// 802.1Q tags never show up in the frames: the kernel strips them before packet sockets and the filter see the
+            /// frame, so VLAN tagged image packets are received like untagged ones.
+            /// </summary>
+            /// <param name="interfaceName">network interface the SRE3021 is connected to, e.g. "eth1"</param>
+            /// <param name="port">UDP destination port</param>
+            /// <param name="fanoutGroupId">when not negative, join this PACKET_FANOUT group so that receivers opened with
+            /// the same id share the traffic, split by flow hash. Each detector stream stays on one receiver.</param>
+            bool Open(const std::string& interfaceName, unsigned short port, int fanoutGroupId = -1);
+
+            /// <summary>
+            /// Wait up to timeoutMilliseconds for datagrams and return up to maxCount slots.
+            /// Length of a slot is the UDP payload length. ReceiveTime is the steady clock time the ring block
+            /// holding the datagram was picked up, Timestamp is left 0.
+            /// </summary>
+            int Receive(SRE3021PacketSlot* outSlots, int maxCount, int timeoutMilliseconds);
+
+            const unsigned __int8* Data(unsigned __int32 slotIndex) const
+            {
+                return ring + slotIndex;
+            };
+
+            void Release(unsigned __int32 slotIndex);
+
+            void Close();
+
+            bool IsOpen() const
+            {
+                return socketFd >= 0;
+            };
+
+            /// <summary>
+            /// Packets the kernel could not put in the ring because no block was free, as reported by PACKET_STATISTICS.
+            /// </summary>
+            size_t GetDropCount();
+
+        private:
+            void ReturnBlock(unsigned __int32 blockIndex);
+            bool ParseFrame(const unsigned __int8* frame, unsigned __int32& outPayloadOffset, unsigned __int32& outPayloadLength);
+
+            int socketFd = -1;
+            unsigned short udpPort = 0;
+            unsigned __int8* ring = nullptr;
+            size_t ringSize = 0;
+            std::unique_ptr<std::atomic<int>[]> blockReferences;
+
+            unsigned __int32 currentBlock = 0;
+            bool isInBlock = false;
+            unsigned __int32 framesLeft = 0;
+            unsigned __int32 frameOffset = 0;
+            long long blockReceiveTime = 0;
+            size_t dropCount = 0;
+        };
+    };
+};
@@ -0,0 +1,56 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021PacketPool.h"
+
+#include <cstdint>
+
+using namespace hurel::sre3021;
+
+void hurel::sre3021::SRE3021PacketPool::Allocate(size_t slotCount, size_t slotSize)
+{
+	SlotStride = (slotSize + SRE3021_CACHE_LINE_SIZE - 1) / SRE3021_CACHE_LINE_SIZE * SRE3021_CACHE_LINE_SIZE;
+	SlotCount = slotCount;
+	Storage = std::vector<unsigned __int8>(SlotStride * SlotCount + SRE3021_CACHE_LINE_SIZE - 1);
+	std::uintptr_t address = reinterpret_cast<std::uintptr_t>(Storage.data());
+	Slots = Storage.data() + ((SRE3021_CACHE_LINE_SIZE - address % SRE3021_CACHE_LINE_SIZE) % SRE3021_CACHE_LINE_SIZE);
+
+	FreeSlots.Resize(SlotCount);
+	for (size_t i = 0; i < SlotCount; ++i)
+	{
+		FreeSlots.TryPush(static_cast<unsigned __int32>(i));
+	}
+}
+
+bool hurel::sre3021::SRE3021PacketPool::TryAcquire(unsigned __int32& outIndex)
+{
+	return FreeSlots.TryPop(outIndex);
+}
+
+void hurel::sre3021::SRE3021PacketPool::Release(unsigned __int32 index)
+{
+	// The free ring has room for every slot, and a slot is only released while it is out of the ring
+	FreeSlots.TryPush(index);
+}
@@ -0,0 +1,107 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <vector>
+
+#include "SRE3021Types.h"
+#include "SRE3021MPMCRingBuffer.h"
+
+#define SRE3021_PACKET_SLOT_NONE (0xFFFFFFFFu)
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Handle of a filled datagram slot. Passed from the UDP listener to the image processing thread.
+        /// Timestamp and ReceiveTime are filled in by the UDP listener when the slot is queued, see SRE3021ImageData.
+        /// CellPointer is the pipeline cell pointer of the readout a pipeline sampling packet belongs to, -1 if unknown.
+        /// </summary>
+        struct SRE3021PacketSlot {
+            unsigned __int32 Index; unsigned __int32 Length; unsigned long long Timestamp; long long ReceiveTime; __int32 CellPointer = -1;
+        };
+
+        /// <summary>
+        /// Fixed number of preallocated datagram slots. Every slot starts on a cache line.
+        /// The UDP listener acquires a slot and receives directly into it, the thread that decoded it releases it when done.
+        /// Any number of threads may acquire and release concurrently.
+        /// </summary>
+        class SRE3021PacketPool
+        {
+        public:
+            SRE3021PacketPool() {};
+
+            /// <summary>
+            /// Allocate all slots up front. Not thread safe, call only while no thread uses the pool.
+            /// </summary>
+            /// <param name="slotCount">number of slots</param>
+            /// <param name="slotSize">usable bytes per slot, rounded up to a cache line for the slot stride</param>
+            void Allocate(size_t slotCount, size_t slotSize = SRE3021_IMAGE_PACKET_LENGTH);
+
+            /// <summary>
+            /// Take a free slot. Returns false when every slot is in use.
+            /// </summary>
+            bool TryAcquire(unsigned __int32& outIndex);
+
+            /// <summary>
+            /// Give a slot back to the pool. Every acquired slot must be released exactly once,
+            /// then the free ring always has room for it and this can not fail.
+            /// </summary>
+            void Release(unsigned __int32 index);
+
+            unsigned __int8* Data(unsigned __int32 index)
+            {
+                return Slots + static_cast<size_t>(index) * SlotStride;
+            };
+
+            /// <summary>
+            /// Bytes that can be written to a slot. Datagrams longer than the requested slot size still fit up to this length,
+            /// so oversized packets can be detected by their length.
+            /// </summary>
+            size_t GetSlotStride() const
+            {
+                return SlotStride;
+            };
+
+            size_t GetSlotCount() const
+            {
+                return SlotCount;
+            };
+
+            size_t GetFreeSlotCount() const
+            {
+                return FreeSlots.Size();
+            };
+
+        private:
+            // Over-allocated by one cache line, Slots is the first cache line aligned byte in it
+            std::vector<unsigned __int8> Storage;
+            unsigned __int8* Slots = nullptr;
+            SRE3021MPMCRingBuffer<unsigned __int32> FreeSlots;
+            size_t SlotStride = 0;
+            size_t SlotCount = 0;
+        };
+    };
+};
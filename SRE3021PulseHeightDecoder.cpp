@@ -0,0 +1,216 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021PulseHeightDecoder.h"
+#include "SRE3021HeaderCodec.h"
+
+using namespace hurel::sre3021;
+
+SRE3021PacketDecodeStatus hurel::sre3021::SRE3021PulseHeightDecoder::ReadPulseHeightFields(const unsigned __int8* data, int dataLength, SRE3021PulseHeightData& outData)
+{
+	outData.SampleCount = 0;
+	outData.Samples = nullptr;
+	if (dataLength < SRE3021_PULSE_HEIGHT_MIN_LENGTH)
+	{
+		return SRE3021PacketDecodeStatus::ERROR_DATA_LENGTH;
+	}
+	outData.SourceId = data[0];
+	outData.TriggerType = static_cast<SRE3021TriggerType>(data[1]);
+	outData.ChannelId = data[2];
+	outData.HoldDelay = SRE3021HeaderCodec::ReadBigEndian16(&data[3]);
+	int sampleCount = SRE3021HeaderCodec::ReadBigEndian16(&data[5]);
+	// Trailing bytes after the samples are padding and ignored
+	if (sampleCount == 0 || SRE3021_PULSE_HEIGHT_FIELDS_LENGTH + 2 * sampleCount > dataLength)
+	{
+		return SRE3021PacketDecodeStatus::ERROR_DATA_LENGTH;
+	}
+	outData.SampleCount = sampleCount;
+	return SRE3021PacketDecodeStatus::SUCCESS;
+}
+
+SRE3021PacketDecodeStatus hurel::sre3021::SRE3021PulseHeightDecoder::DecodePulseHeight(const unsigned __int8* data, int dataLength, SRE3021PulseHeightData& outData,
+	unsigned __int16* samples, size_t sampleCapacity)
+{
+	SRE3021PacketDecodeStatus status = ReadPulseHeightFields(data, dataLength, outData);
+	if (status != SRE3021PacketDecodeStatus::SUCCESS)
+	{
+		return status;
+	}
+	if (static_cast<size_t>(outData.SampleCount) > sampleCapacity)
+	{
+		return SRE3021PacketDecodeStatus::ERROR_CAPACITY;
+	}
+	const unsigned __int8* sampleData = data + SRE3021_PULSE_HEIGHT_FIELDS_LENGTH;
+	for (int i = 0; i < outData.SampleCount; ++i)
+	{
+		samples[i] = static_cast<unsigned __int16>(SRE3021HeaderCodec::ReadBigEndian16(&sampleData[2 * i]));
+	}
+	outData.Samples = samples;
+	return SRE3021PacketDecodeStatus::SUCCESS;
+}
+
+SRE3021PacketDecodeStatus hurel::sre3021::SRE3021PulseHeightDecoder::DecodePulseHeight(const unsigned __int8* data, int dataLength, SRE3021PulseHeightData& outData,
+	SRE3021DecodeArena& arena)
+{
+	SRE3021PacketDecodeStatus status = ReadPulseHeightFields(data, dataLength, outData);
+	if (status != SRE3021PacketDecodeStatus::SUCCESS)
+	{
+		return status;
+	}
+	unsigned __int16* samples = arena.Take<unsigned __int16>(outData.SampleCount);
+	if (samples == nullptr)
+	{
+		return SRE3021PacketDecodeStatus::ERROR_CAPACITY;
+	}
+	return DecodePulseHeight(data, dataLength, outData, samples, outData.SampleCount);
+}
+
+SRE3021PacketDecodeStatus hurel::sre3021::SRE3021PulseHeightDecoder::ReadMultiPulseHeightFields(const unsigned __int8* data, int dataLength, SRE3021MultiPulseHeightData& outData)
+{
+	outData.EventCount = 0;
+	outData.SampleCount = 0;
+	outData.Events = nullptr;
+	if (dataLength < SRE3021_MULTI_PULSE_HEIGHT_MIN_LENGTH)
+	{
+		return SRE3021PacketDecodeStatus::ERROR_DATA_LENGTH;
+	}
+	int eventCount = data[0];
+	int sampleCount = SRE3021HeaderCodec::ReadBigEndian16(&data[1]);
+	long long eventLength = SRE3021_MULTI_PULSE_HEIGHT_EVENT_LENGTH + static_cast<long long>(sampleCount) * SRE3021_MULTI_PULSE_HEIGHT_SAMPLE_LENGTH;
+	if (eventCount == 0 || sampleCount == 0 || SRE3021_MULTI_PULSE_HEIGHT_FIELDS_LENGTH + eventCount * eventLength > dataLength)
+	{
+		return SRE3021PacketDecodeStatus::ERROR_DATA_LENGTH;
+	}
+	outData.EventCount = eventCount;
+	outData.SampleCount = sampleCount;
+	return SRE3021PacketDecodeStatus::SUCCESS;
+}
+
+SRE3021PacketDecodeStatus hurel::sre3021::SRE3021PulseHeightDecoder::DecodeMultiPulseHeight(const unsigned __int8* data, int dataLength, SRE3021MultiPulseHeightData& outData,
+	SRE3021PulseHeightEvent* events, size_t eventCapacity, SRE3021PulseHeightSample* samples, size_t sampleCapacity)
+{
+	SRE3021PacketDecodeStatus status = ReadMultiPulseHeightFields(data, dataLength, outData);
+	if (status != SRE3021PacketDecodeStatus::SUCCESS)
+	{
+		return status;
+	}
+	size_t eventCount = outData.EventCount;
+	size_t sampleCount = outData.SampleCount;
+	if (eventCount > eventCapacity || eventCount * sampleCount > sampleCapacity)
+	{
+		return SRE3021PacketDecodeStatus::ERROR_CAPACITY;
+	}
+	const unsigned __int8* eventData = data + SRE3021_MULTI_PULSE_HEIGHT_FIELDS_LENGTH;
+	for (size_t i = 0; i < eventCount; ++i)
+	{
+		SRE3021PulseHeightSample* eventSamples = samples + i * sampleCount;
+		events[i].Timestamp = SRE3021HeaderCodec::ReadBigEndian32(eventData);
+		events[i].Samples = eventSamples;
+		const unsigned __int8* sampleData = eventData + SRE3021_MULTI_PULSE_HEIGHT_EVENT_LENGTH;
+		for (size_t j = 0; j < sampleCount; ++j)
+		{
+			eventSamples[j].TriggerType = static_cast<SRE3021TriggerType>(sampleData[0]);
+			eventSamples[j].SourceId = sampleData[1];
+			eventSamples[j].ChannelId = static_cast<unsigned __int16>(SRE3021HeaderCodec::ReadBigEndian16(&sampleData[2]));
+			eventSamples[j].Sample = static_cast<unsigned __int16>(SRE3021HeaderCodec::ReadBigEndian16(&sampleData[4]));
+			sampleData += SRE3021_MULTI_PULSE_HEIGHT_SAMPLE_LENGTH;
+		}
+		eventData = sampleData;
+	}
+	outData.Events = events;
+	return SRE3021PacketDecodeStatus::SUCCESS;
+}
+
+SRE3021PacketDecodeStatus hurel::sre3021::SRE3021PulseHeightDecoder::DecodeMultiPulseHeight(const unsigned __int8* data, int dataLength, SRE3021MultiPulseHeightData& outData,
+	SRE3021DecodeArena& arena)
+{
+	SRE3021PacketDecodeStatus status = ReadMultiPulseHeightFields(data, dataLength, outData);
+	if (status != SRE3021PacketDecodeStatus::SUCCESS)
+	{
+		return status;
+	}
+	size_t eventCount = outData.EventCount;
+	size_t sampleCount = eventCount * outData.SampleCount;
+	size_t used = arena.GetUsed();
+	SRE3021PulseHeightEvent* events = arena.Take<SRE3021PulseHeightEvent>(eventCount);
+	SRE3021PulseHeightSample* samples = arena.Take<SRE3021PulseHeightSample>(sampleCount);
+	if (events == nullptr || samples == nullptr)
+	{
+		arena.Rewind(used);
+		return SRE3021PacketDecodeStatus::ERROR_CAPACITY;
+	}
+	return DecodeMultiPulseHeight(data, dataLength, outData, events, eventCount, samples, sampleCount);
+}
+
+SRE3021PacketDecodeStatus hurel::sre3021::SRE3021PulseHeightDecoder::ReadTriggerTimeFields(int dataLength, SRE3021TriggerTimeData& outData)
+{
+	outData.EventCount = 0;
+	outData.Events = nullptr;
+	if (dataLength < SRE3021_TRIGGER_TIME_EVENT_LENGTH || dataLength % SRE3021_TRIGGER_TIME_EVENT_LENGTH != 0)
+	{
+		return SRE3021PacketDecodeStatus::ERROR_DATA_LENGTH;
+	}
+	outData.EventCount = dataLength / SRE3021_TRIGGER_TIME_EVENT_LENGTH;
+	return SRE3021PacketDecodeStatus::SUCCESS;
+}
+
+SRE3021PacketDecodeStatus hurel::sre3021::SRE3021PulseHeightDecoder::DecodeTriggerTime(const unsigned __int8* data, int dataLength, SRE3021TriggerTimeData& outData,
+	SRE3021TriggerTimeEvent* events, size_t eventCapacity)
+{
+	SRE3021PacketDecodeStatus status = ReadTriggerTimeFields(dataLength, outData);
+	if (status != SRE3021PacketDecodeStatus::SUCCESS)
+	{
+		return status;
+	}
+	if (static_cast<size_t>(outData.EventCount) > eventCapacity)
+	{
+		return SRE3021PacketDecodeStatus::ERROR_CAPACITY;
+	}
+	for (int i = 0; i < outData.EventCount; ++i)
+	{
+		const unsigned __int8* eventData = data + i * SRE3021_TRIGGER_TIME_EVENT_LENGTH;
+		events[i].Timestamp = SRE3021HeaderCodec::ReadBigEndian32(eventData);
+		events[i].SourceId = eventData[4];
+		events[i].ChannelId = eventData[5];
+	}
+	outData.Events = events;
+	return SRE3021PacketDecodeStatus::SUCCESS;
+}
+
+SRE3021PacketDecodeStatus hurel::sre3021::SRE3021PulseHeightDecoder::DecodeTriggerTime(const unsigned __int8* data, int dataLength, SRE3021TriggerTimeData& outData,
+	SRE3021DecodeArena& arena)
+{
+	SRE3021PacketDecodeStatus status = ReadTriggerTimeFields(dataLength, outData);
+	if (status != SRE3021PacketDecodeStatus::SUCCESS)
+	{
+		return status;
+	}
+	SRE3021TriggerTimeEvent* events = arena.Take<SRE3021TriggerTimeEvent>(outData.EventCount);
+	if (events == nullptr)
+	{
+		return SRE3021PacketDecodeStatus::ERROR_CAPACITY;
+	}
+	return DecodeTriggerTime(data, dataLength, outData, events, outData.EventCount);
+}
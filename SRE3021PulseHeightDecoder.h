@@ -0,0 +1,127 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include "SRE3021Types.h"
+#include "SRE3021DecodeArena.h"
+
+// Packet Data layouts, multi-byte fields big endian like the header.
+// Pulse-height data: SourceId, TriggerType, ChannelId (1 byte each), HoldDelay, SampleCount (2 bytes each), then SampleCount 2 byte samples.
+#define SRE3021_PULSE_HEIGHT_FIELDS_LENGTH (7)
+#define SRE3021_PULSE_HEIGHT_MIN_LENGTH (9)
+// Multi-event pulse-height data: EventCount (1 byte), SampleCount per event (2 bytes), then per event a 4 byte time stamp
+// followed by SampleCount samples of TriggerType, SourceId (1 byte each), ChannelId, Sample (2 bytes each).
+#define SRE3021_MULTI_PULSE_HEIGHT_FIELDS_LENGTH (3)
+#define SRE3021_MULTI_PULSE_HEIGHT_EVENT_LENGTH (4)
+#define SRE3021_MULTI_PULSE_HEIGHT_SAMPLE_LENGTH (6)
+#define SRE3021_MULTI_PULSE_HEIGHT_MIN_LENGTH (13)
+// Trigger time data: records of a 4 byte time stamp, SourceId and ChannelId (1 byte each), filling the whole Packet Data field
+#define SRE3021_TRIGGER_TIME_EVENT_LENGTH (6)
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Single-event pulse-height data. Samples points into storage given to the decoder.
+        /// </summary>
+        struct SRE3021PulseHeightData {
+            int SourceId; SRE3021TriggerType TriggerType; int ChannelId; int HoldDelay; int SampleCount; const unsigned __int16* Samples;
+        };
+
+        struct SRE3021PulseHeightSample {
+            SRE3021TriggerType TriggerType; unsigned __int8 SourceId; unsigned __int16 ChannelId; unsigned __int16 Sample;
+        };
+
+        /// <summary>
+        /// One event of multi-event pulse-height data, Samples holds SRE3021MultiPulseHeightData::SampleCount samples
+        /// </summary>
+        struct SRE3021PulseHeightEvent {
+            unsigned __int32 Timestamp; const SRE3021PulseHeightSample* Samples;
+        };
+
+        /// <summary>
+        /// Multi-event pulse-height data. Events points into storage given to the decoder.
+        /// </summary>
+        struct SRE3021MultiPulseHeightData {
+            int EventCount; int SampleCount; const SRE3021PulseHeightEvent* Events;
+        };
+
+        struct SRE3021TriggerTimeEvent {
+            unsigned __int32 Timestamp; unsigned __int8 SourceId; unsigned __int8 ChannelId;
+        };
+
+        /// <summary>
+        /// Trigger time data. Events points into storage given to the decoder.
+        /// </summary>
+        struct SRE3021TriggerTimeData {
+            int EventCount; const SRE3021TriggerTimeEvent* Events;
+        };
+
+        /// <summary>
+        /// Decodes the Packet Data field of pulse-height and trigger time packets without allocating.
+        /// The decoded arrays go either to storage given by the caller or to an SRE3021DecodeArena.
+        /// On ERROR_CAPACITY the counts of the output are set, so the caller can size the storage and decode again.
+        /// </summary>
+        class SRE3021PulseHeightDecoder
+        {
+        public:
+            /// <summary>
+            /// Decode single-event pulse-height data
+            /// </summary>
+            /// <param name="data">Packet Data field, right after the header</param>
+            /// <param name="dataLength">DataLength of the header</param>
+            /// <param name="samples">room for the samples in host byte order</param>
+            /// <param name="sampleCapacity">number of samples that fit in samples</param>
+            static SRE3021PacketDecodeStatus DecodePulseHeight(const unsigned __int8* data, int dataLength, SRE3021PulseHeightData& outData,
+                unsigned __int16* samples, size_t sampleCapacity);
+
+            static SRE3021PacketDecodeStatus DecodePulseHeight(const unsigned __int8* data, int dataLength, SRE3021PulseHeightData& outData,
+                SRE3021DecodeArena& arena);
+
+            /// <summary>
+            /// Decode multi-event pulse-height data. Needs EventCount events and EventCount * SampleCount samples.
+            /// </summary>
+            static SRE3021PacketDecodeStatus DecodeMultiPulseHeight(const unsigned __int8* data, int dataLength, SRE3021MultiPulseHeightData& outData,
+                SRE3021PulseHeightEvent* events, size_t eventCapacity, SRE3021PulseHeightSample* samples, size_t sampleCapacity);
+
+            static SRE3021PacketDecodeStatus DecodeMultiPulseHeight(const unsigned __int8* data, int dataLength, SRE3021MultiPulseHeightData& outData,
+                SRE3021DecodeArena& arena);
+
+            /// <summary>
+            /// Decode trigger time data. The event count follows from dataLength, which must be a multiple of the record length.
+            /// </summary>
+            static SRE3021PacketDecodeStatus DecodeTriggerTime(const unsigned __int8* data, int dataLength, SRE3021TriggerTimeData& outData,
+                SRE3021TriggerTimeEvent* events, size_t eventCapacity);
+
+            static SRE3021PacketDecodeStatus DecodeTriggerTime(const unsigned __int8* data, int dataLength, SRE3021TriggerTimeData& outData,
+                SRE3021DecodeArena& arena);
+
+        private:
+            static SRE3021PacketDecodeStatus ReadPulseHeightFields(const unsigned __int8* data, int dataLength, SRE3021PulseHeightData& outData);
+            static SRE3021PacketDecodeStatus ReadMultiPulseHeightFields(const unsigned __int8* data, int dataLength, SRE3021MultiPulseHeightData& outData);
+            static SRE3021PacketDecodeStatus ReadTriggerTimeFields(int dataLength, SRE3021TriggerTimeData& outData);
+        };
+    };
+};
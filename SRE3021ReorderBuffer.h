@@ -0,0 +1,168 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Puts results that several threads finish out of order back into ticket order.
+        /// A thread fills Slot(ticket), publishes it and calls Drain. Whichever thread gets the delivery role hands
+        /// published results to the deliver function in ticket order, so that function never runs concurrently.
+        /// Tickets must be dense from 0, a ticket may only be written while InWindow(ticket).
+        /// </summary>
+        template <typename T>
+        class SRE3021ReorderBuffer
+        {
+        public:
+            SRE3021ReorderBuffer()
+            {
+                Resize(1);
+            };
+
+            /// <summary>
+            /// Reallocate and restart at ticket 0. Not thread safe. Capacity is rounded up to a power of two.
+            /// </summary>
+            void Resize(size_t capacity)
+            {
+                size_t roundedCapacity = 1;
+                while (roundedCapacity < capacity)
+                {
+                    roundedCapacity <<= 1;
+                }
+                slots = std::vector<T>(roundedCapacity);
+                states.reset(new std::atomic<size_t>[roundedCapacity]);
+                for (size_t i = 0; i < roundedCapacity; ++i)
+                {
+                    states[i].store(0, std::memory_order_relaxed);
+                }
+                mask = roundedCapacity - 1;
+                nextTicket.store(0, std::memory_order_relaxed);
+                isDelivering.store(false, std::memory_order_relaxed);
+            };
+
+            /// <summary>
+            /// First ticket at or beyond the window, tickets below it may be written
+            /// </summary>
+            size_t WindowEnd() const
+            {
+                return nextTicket.load(std::memory_order_acquire) + mask + 1;
+            };
+
+            bool InWindow(size_t ticket) const
+            {
+                return ticket < WindowEnd();
+            };
+
+            T& Slot(size_t ticket)
+            {
+                return slots[ticket & mask];
+            };
+
+            /// <summary>
+            /// Index of the slot of a ticket, below Capacity. Lets a caller keep more data per ticket in arrays of its own.
+            /// </summary>
+            size_t SlotIndex(size_t ticket) const
+            {
+                return ticket & mask;
+            };
+
+            size_t Capacity() const
+            {
+                return mask + 1;
+            };
+
+            /// <summary>
+            /// Mark the ticket done. A skipped ticket is passed over without calling the deliver function and its slot is not read.
+            /// </summary>
+            void Publish(size_t ticket, bool isSkipped = false)
+            {
+                states[ticket & mask].store(((ticket + 1) << 1) | (isSkipped ? 1 : 0), std::memory_order_seq_cst);
+            };
+
+            /// <summary>
+            /// Deliver published results in order, unless another thread is already delivering. Returns the number delivered.
+            /// </summary>
+            template <typename Deliver>
+            size_t Drain(Deliver deliver)
+            {
+                return Drain(deliver, [] {});
+            };
+
+            /// <summary>
+            /// Drain that calls flush before giving up the delivery role whenever it delivered anything,
+            /// e.g. to pass on what deliver collected while flush still cannot run concurrently with it.
+            /// </summary>
+            template <typename Deliver, typename Flush>
+            size_t Drain(Deliver deliver, Flush flush)
+            {
+                size_t deliveredCount = 0;
+                while (!isDelivering.exchange(true, std::memory_order_seq_cst))
+                {
+                    const size_t roundStartCount = deliveredCount;
+                    size_t ticket = nextTicket.load(std::memory_order_relaxed);
+                    while (true)
+                    {
+                        const size_t state = states[ticket & mask].load(std::memory_order_acquire);
+                        if ((state >> 1) != ticket + 1)
+                        {
+                            break;
+                        }
+                        if ((state & 1) == 0)
+                        {
+                            deliver(slots[ticket & mask]);
+                            ++deliveredCount;
+                        }
+                        ++ticket;
+                        nextTicket.store(ticket, std::memory_order_release);
+                    }
+                    if (deliveredCount != roundStartCount)
+                    {
+                        flush();
+                    }
+                    isDelivering.store(false, std::memory_order_seq_cst);
+
+                    // A result published while this thread held the role would otherwise wait for the next Drain
+                    if ((states[ticket & mask].load(std::memory_order_seq_cst) >> 1) != ticket + 1)
+                    {
+                        break;
+                    }
+                }
+                return deliveredCount;
+            };
+
+        private:
+            std::vector<T> slots;
+            std::unique_ptr<std::atomic<size_t>[]> states;
+            size_t mask = 0;
+            std::atomic<size_t> nextTicket{ 0 };
+            std::atomic<bool> isDelivering{ false };
+        };
+    };
+};
@@ -0,0 +1,213 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include <utility>
+
+#define SRE3021_CACHE_LINE_SIZE (64)
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Bounded lock-free ring buffer for exactly one producer thread and one consumer thread.
+        /// Capacity is rounded up to a power of two. See SRE3021MPMCRingBuffer for more threads on either side.
+        /// </summary>
+        template <typename T>
+        class SRE3021RingBuffer
+        {
+        public:
+            SRE3021RingBuffer()
+            {
+                Resize(1);
+            };
+            SRE3021RingBuffer(size_t capacity)
+            {
+                Resize(capacity);
+            };
+
+            /// <summary>
+            /// Reallocate the ring and clear all counters. Not thread safe, call only while no thread uses the ring.
+            /// </summary>
+            void Resize(size_t capacity)
+            {
+                size_t roundedCapacity = 1;
+                while (roundedCapacity < capacity)
+                {
+                    roundedCapacity <<= 1;
+                }
+                buffer = std::vector<T>(roundedCapacity);
+                mask = roundedCapacity - 1;
+                head.store(0, std::memory_order_relaxed);
+                tail.store(0, std::memory_order_relaxed);
+                producerCachedHead = 0;
+                consumerCachedTail = 0;
+                highWaterMark.store(0, std::memory_order_relaxed);
+                pushFailCount.store(0, std::memory_order_relaxed);
+            };
+
+            /// <summary>
+            /// Producer side. Returns false when the ring is full.
+            /// </summary>
+            bool TryPush(T&& item)
+            {
+                const size_t currentTail = tail.load(std::memory_order_relaxed);
+                if (!HasSpace(currentTail))
+                {
+                    return false;
+                }
+                buffer[currentTail & mask] = std::move(item);
+                tail.store(currentTail + 1, std::memory_order_release);
+                UpdateHighWaterMark(currentTail + 1);
+                return true;
+            };
+
+            /// <summary>
+            /// Producer side. Returns false when the ring is full.
+            /// </summary>
+            bool TryPush(const T& item)
+            {
+                const size_t currentTail = tail.load(std::memory_order_relaxed);
+                if (!HasSpace(currentTail))
+                {
+                    return false;
+                }
+                buffer[currentTail & mask] = item;
+                tail.store(currentTail + 1, std::memory_order_release);
+                UpdateHighWaterMark(currentTail + 1);
+                return true;
+            };
+
+            /// <summary>
+            /// Consumer side. Returns false when the ring is empty.
+            /// </summary>
+            bool TryPop(T& outItem)
+            {
+                const size_t currentHead = head.load(std::memory_order_relaxed);
+                if (currentHead == consumerCachedTail)
+                {
+                    consumerCachedTail = tail.load(std::memory_order_acquire);
+                    if (currentHead == consumerCachedTail)
+                    {
+                        return false;
+                    }
+                }
+                outItem = std::move(buffer[currentHead & mask]);
+                head.store(currentHead + 1, std::memory_order_release);
+                return true;
+            };
+
+            bool Full() const
+            {
+                return Size() > mask;
+            };
+
+            /// <summary>
+            /// Number of items currently queued. Approximate while both threads are running.
+            /// </summary>
+            size_t Size() const
+            {
+                const size_t currentHead = head.load(std::memory_order_acquire);
+                const size_t currentTail = tail.load(std::memory_order_acquire);
+                return currentTail - currentHead;
+            };
+
+            bool Empty() const
+            {
+                return Size() == 0;
+            };
+
+            size_t Capacity() const
+            {
+                return buffer.size();
+            };
+
+            /// <summary>
+            /// Largest occupancy seen since the last Resize or ResetHighWaterMark.
+            /// Measured against the producer's cached head, so it is an upper bound of the real peak.
+            /// </summary>
+            size_t HighWaterMark() const
+            {
+                return highWaterMark.load(std::memory_order_relaxed);
+            };
+
+            void ResetHighWaterMark()
+            {
+                highWaterMark.store(Size(), std::memory_order_relaxed);
+            };
+
+            /// <summary>
+            /// Number of TryPush calls rejected because the ring was full.
+            /// </summary>
+            size_t PushFailCount() const
+            {
+                return pushFailCount.load(std::memory_order_relaxed);
+            };
+
+        private:
+            bool HasSpace(size_t currentTail)
+            {
+                if (currentTail - producerCachedHead <= mask)
+                {
+                    return true;
+                }
+                producerCachedHead = head.load(std::memory_order_acquire);
+                if (currentTail - producerCachedHead <= mask)
+                {
+                    return true;
+                }
+                pushFailCount.store(pushFailCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            };
+
+            void UpdateHighWaterMark(size_t newTail)
+            {
+                const size_t occupancy = newTail - producerCachedHead;
+                if (occupancy > highWaterMark.load(std::memory_order_relaxed))
+                {
+                    highWaterMark.store(occupancy, std::memory_order_relaxed);
+                }
+            };
+
+            // Consumer owned line
+            std::atomic<size_t> head{ 0 };
+            size_t consumerCachedTail = 0;
+            char consumerPadding[SRE3021_CACHE_LINE_SIZE];
+
+            // Producer owned line
+            std::atomic<size_t> tail{ 0 };
+            size_t producerCachedHead = 0;
+            std::atomic<size_t> highWaterMark{ 0 };
+            std::atomic<size_t> pushFailCount{ 0 };
+            char producerPadding[SRE3021_CACHE_LINE_SIZE];
+
+            std::vector<T> buffer;
+            size_t mask = 0;
+        };
+    };
+};
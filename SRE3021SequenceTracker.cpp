@@ -0,0 +1,178 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021SequenceTracker.h"
+
+#include <bitset>
+
+using namespace hurel::sre3021;
+
+static size_t CountMissing(unsigned long long receivedMask, unsigned long long validMask)
+{
+	return std::bitset<64>(validMask & ~receivedMask).count();
+}
+
+// Only Track writes the counters
+static void AddCount(std::atomic<size_t>& counter, size_t count)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+}
+
+hurel::sre3021::SRE3021SequenceTracker::SRE3021SequenceTracker()
+{
+	Reset();
+}
+
+void hurel::sre3021::SRE3021SequenceTracker::Reset()
+{
+	for (int i = 0; i < SRE3021_SYSTEM_NUMBER_COUNT; ++i)
+	{
+		SystemState& state = States[i];
+		state.Started = false;
+		state.HighestPacketCount = 0;
+		state.ReceivedMask = 0;
+		state.ValidMask = 0;
+		state.Received.store(0, std::memory_order_relaxed);
+		state.Lost.store(0, std::memory_order_relaxed);
+		state.Duplicate.store(0, std::memory_order_relaxed);
+		state.Reordered.store(0, std::memory_order_relaxed);
+		state.OutOfWindow.store(0, std::memory_order_relaxed);
+	}
+	StartTime = std::chrono::steady_clock::now();
+
+	std::lock_guard<std::mutex> lock(mutexLossEvents);
+	LossEvents = std::vector<SRE3021SequenceLossEvent>(SRE3021_SEQUENCE_LOSS_EVENT_CAPACITY);
+	LossEventCount = 0;
+}
+
+void hurel::sre3021::SRE3021SequenceTracker::Track(int systemNumber, int packetCount)
+{
+	SystemState& state = States[systemNumber & (SRE3021_SYSTEM_NUMBER_COUNT - 1)];
+	AddCount(state.Received, 1);
+	if (!state.Started)
+	{
+		state.Started = true;
+		state.HighestPacketCount = packetCount;
+		state.ReceivedMask = 1;
+		state.ValidMask = 1;
+		return;
+	}
+
+	// Distance from the highest count seen so far, in [-MODULO/2, MODULO/2) to handle the 14 bit wraparound
+	int diff = (packetCount - state.HighestPacketCount) & (SRE3021_PACKET_COUNT_MODULO - 1);
+	if (diff >= SRE3021_PACKET_COUNT_MODULO / 2)
+	{
+		diff -= SRE3021_PACKET_COUNT_MODULO;
+	}
+
+	if (diff > 0)
+	{
+		if (diff > 1)
+		{
+			AddLossEvent(systemNumber, (state.HighestPacketCount + 1) & (SRE3021_PACKET_COUNT_MODULO - 1), packetCount, diff - 1);
+		}
+		if (diff >= SRE3021_SEQUENCE_REORDER_WINDOW)
+		{
+			// Everything still missing in the window and the part of the gap that never enters it is lost
+			AddCount(state.Lost, CountMissing(state.ReceivedMask, state.ValidMask) + (diff - SRE3021_SEQUENCE_REORDER_WINDOW));
+			state.ReceivedMask = 1;
+			state.ValidMask = ~0ULL;
+		}
+		else
+		{
+			const unsigned long long leavingMask = ~0ULL << (SRE3021_SEQUENCE_REORDER_WINDOW - diff);
+			AddCount(state.Lost, CountMissing(state.ReceivedMask & leavingMask, state.ValidMask & leavingMask));
+			state.ReceivedMask = (state.ReceivedMask << diff) | 1;
+			state.ValidMask = (state.ValidMask << diff) | ((1ULL << diff) - 1);
+		}
+		state.HighestPacketCount = packetCount;
+	}
+	else if (diff == 0)
+	{
+		AddCount(state.Duplicate, 1);
+	}
+	else if (-diff < SRE3021_SEQUENCE_REORDER_WINDOW && (state.ValidMask >> -diff & 1))
+	{
+		const unsigned long long bit = 1ULL << -diff;
+		if (state.ReceivedMask & bit)
+		{
+			AddCount(state.Duplicate, 1);
+		}
+		else
+		{
+			AddCount(state.Reordered, 1);
+			state.ReceivedMask |= bit;
+		}
+	}
+	else
+	{
+		AddCount(state.OutOfWindow, 1);
+	}
+}
+
+SRE3021SequenceStats hurel::sre3021::SRE3021SequenceTracker::GetStats(int systemNumber) const
+{
+	const SystemState& state = States[systemNumber & (SRE3021_SYSTEM_NUMBER_COUNT - 1)];
+	return SRE3021SequenceStats{ state.Received.load(std::memory_order_relaxed), state.Lost.load(std::memory_order_relaxed),
+		state.Duplicate.load(std::memory_order_relaxed), state.Reordered.load(std::memory_order_relaxed), state.OutOfWindow.load(std::memory_order_relaxed) };
+}
+
+SRE3021SequenceStats hurel::sre3021::SRE3021SequenceTracker::GetTotalStats() const
+{
+	SRE3021SequenceStats total{ 0, 0, 0, 0, 0 };
+	for (int i = 0; i < SRE3021_SYSTEM_NUMBER_COUNT; ++i)
+	{
+		const SRE3021SequenceStats stats = GetStats(i);
+		total.Received += stats.Received;
+		total.Lost += stats.Lost;
+		total.Duplicate += stats.Duplicate;
+		total.Reordered += stats.Reordered;
+		total.OutOfWindow += stats.OutOfWindow;
+	}
+	return total;
+}
+
+std::vector<SRE3021SequenceLossEvent> hurel::sre3021::SRE3021SequenceTracker::GetLossEvents()
+{
+	std::lock_guard<std::mutex> lock(mutexLossEvents);
+	std::vector<SRE3021SequenceLossEvent> events;
+	const size_t capacity = LossEvents.size();
+	const size_t first = LossEventCount > capacity ? LossEventCount - capacity : 0;
+	events.reserve(LossEventCount - first);
+	for (size_t i = first; i < LossEventCount; ++i)
+	{
+		events.push_back(LossEvents[i % capacity]);
+	}
+	return events;
+}
+
+void hurel::sre3021::SRE3021SequenceTracker::AddLossEvent(int systemNumber, int expectedPacketCount, int receivedPacketCount, int gapLength)
+{
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+	std::lock_guard<std::mutex> lock(mutexLossEvents);
+	LossEvents[LossEventCount % LossEvents.size()] = SRE3021SequenceLossEvent{ seconds, systemNumber, expectedPacketCount, receivedPacketCount, gapLength };
+	++LossEventCount;
+}
@@ -0,0 +1,101 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+#include "SRE3021Types.h"
+
+#define SRE3021_SYSTEM_NUMBER_COUNT (32)
+#define SRE3021_PACKET_COUNT_MODULO (0x4000)
+#define SRE3021_SEQUENCE_REORDER_WINDOW (64)
+#define SRE3021_SEQUENCE_LOSS_EVENT_CAPACITY (1024)
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Packet counter statistics of one SystemNumber.
+        /// Lost packets are only counted once they fall out of the reorder window without arriving.
+        /// OutOfWindow counts packets that arrived after they had already been counted as lost.
+        /// </summary>
+        struct SRE3021SequenceStats {
+            size_t Received; size_t Lost; size_t Duplicate; size_t Reordered; size_t OutOfWindow;
+        };
+
+        /// <summary>
+        /// A gap in the packet counter. Seconds is measured from the last Reset.
+        /// Packets of the gap may still arrive reordered, the confirmed loss is in SRE3021SequenceStats::Lost.
+        /// </summary>
+        struct SRE3021SequenceLossEvent {
+            double Seconds; int SystemNumber; int ExpectedPacketCount; int ReceivedPacketCount; int GapLength;
+        };
+
+        /// <summary>
+        /// Tracks the 14 bit header PacketCount of every SystemNumber and detects lost, duplicate and reordered packets.
+        /// Track is called by one thread, the getters may be called from any thread.
+        /// </summary>
+        class SRE3021SequenceTracker
+        {
+        public:
+            SRE3021SequenceTracker();
+
+            /// <summary>
+            /// Clear all counters and events and restart the event clock. Not thread safe against Track.
+            /// </summary>
+            void Reset();
+
+            void Track(int systemNumber, int packetCount);
+
+            SRE3021SequenceStats GetStats(int systemNumber) const;
+            SRE3021SequenceStats GetTotalStats() const;
+
+            /// <summary>
+            /// The most recent gap events, oldest first.
+            /// </summary>
+            std::vector<SRE3021SequenceLossEvent> GetLossEvents();
+
+        private:
+            // The window is only touched by Track. The counters are written by Track and read by the getters,
+            // relaxed load and store of a single writer like SRE3021CountingAccumulator.
+            struct SystemState {
+                bool Started; int HighestPacketCount; unsigned long long ReceivedMask; unsigned long long ValidMask;
+                std::atomic<size_t> Received; std::atomic<size_t> Lost; std::atomic<size_t> Duplicate; std::atomic<size_t> Reordered; std::atomic<size_t> OutOfWindow;
+            };
+
+            void AddLossEvent(int systemNumber, int expectedPacketCount, int receivedPacketCount, int gapLength);
+
+            SystemState States[SRE3021_SYSTEM_NUMBER_COUNT];
+            std::chrono::steady_clock::time_point StartTime;
+
+            std::mutex mutexLossEvents;
+            std::vector<SRE3021SequenceLossEvent> LossEvents;
+            size_t LossEventCount = 0;
+        };
+    };
+};
@@ -0,0 +1,168 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+#include "SRE3021Test.h"
+
+#include <vector>
+
+#include "../SRE3021CoincidenceFinder.h"
+#include "../SRE3021ReorderBuffer.h"
+
+using namespace hurel::sre3021;
+
+static SRE3021CoincidenceFinder MakeTestFinder(unsigned long long windowTicks, unsigned long long holdTicks)
+{
+	SRE3021CoincidenceFinder finder;
+	finder.SetSettings(SRE3021CoincidenceSettings{ windowTicks, holdTicks, 2 });
+	return finder;
+}
+
+static void AddRecords(SRE3021CoincidenceFinder& finder, const std::vector<SRE3021TriggerRecord>& records)
+{
+	for (const SRE3021TriggerRecord& record : records)
+	{
+		finder.Add(record);
+	}
+}
+
+SRE3021_TEST(CoincidenceFinderWindowGrouping)
+{
+	SRE3021CoincidenceFinder finder = MakeTestFinder(10, 100);
+	// Out of order within a source, the finder sorts them in
+	AddRecords(finder, { { 1005, 1, 7 }, { 1000, 0, 3 }, { 1012, 2, 5 }, { 1015, 0, 4 }, { 1025, 1, 8 }, { 1040, 2, 9 }, { 1041, 0, 1 }, { 1050, 1, 2 } });
+	std::vector<SRE3021Coincidence> coincidences;
+	SRE3021_CHECK(finder.FindCoincidences(coincidences, true) == 3);
+	SRE3021_CHECK(coincidences.size() == 3);
+	// The window runs from the first trigger of a group: 1012 is more than 10 ticks after 1000 and starts the next group
+	SRE3021_CHECK(coincidences[0].Timestamp == 1000 && coincidences[0].Duration == 5 && coincidences[0].Multiplicity == 2);
+	SRE3021_CHECK(coincidences[0].Records[0].SourceId == 0 && coincidences[0].Records[0].ChannelId == 3);
+	SRE3021_CHECK(coincidences[0].Records[1].SourceId == 1 && coincidences[0].Records[1].ChannelId == 7);
+	SRE3021_CHECK(coincidences[1].Timestamp == 1012 && coincidences[1].Duration == 3 && coincidences[1].Multiplicity == 2);
+	// 1050 is exactly WindowTicks after 1040 and still in the group
+	SRE3021_CHECK(coincidences[2].Timestamp == 1040 && coincidences[2].Duration == 10 && coincidences[2].Multiplicity == 3);
+	const std::vector<size_t> histogram = finder.GetMultiplicityHistogram();
+	SRE3021_CHECK(histogram.size() == SRE3021_COINCIDENCE_MAX_MULTIPLICITY + 1);
+	// 1025 is a single, counted but not reported
+	SRE3021_CHECK(histogram[1] == 1 && histogram[2] == 2 && histogram[3] == 1);
+	SRE3021_CHECK(finder.GetLateRecordCount() == 0);
+}
+
+SRE3021_TEST(CoincidenceFinderHoldsForQuietSource)
+{
+	SRE3021CoincidenceFinder finder = MakeTestFinder(10, 100);
+	std::vector<SRE3021Coincidence> coincidences;
+	AddRecords(finder, { { 0, 0, 0 }, { 5, 1, 0 }, { 50, 0, 0 } });
+	// Nothing is merged before HoldTicks have passed since the first record, the sources are not known yet
+	SRE3021_CHECK(finder.FindCoincidences(coincidences) == 0);
+
+	// Source 1 stays quiet: it holds the merge back to HoldTicks behind the newest record, 200 - 100
+	finder.Add(SRE3021TriggerRecord{ 200, 0, 0 });
+	SRE3021_CHECK(finder.FindCoincidences(coincidences) == 1);
+	SRE3021_CHECK(coincidences.size() == 1 && coincidences[0].Timestamp == 0 && coincidences[0].Multiplicity == 2);
+	// 50 was merged and grouped as a single, 200 is still queued
+	SRE3021_CHECK(finder.GetMultiplicityHistogram()[1] == 1);
+
+	// Source 1 catches up behind 200 but after the merged 50, nothing is late
+	coincidences.clear();
+	finder.Add(SRE3021TriggerRecord{ 195, 1, 0 });
+	finder.Add(SRE3021TriggerRecord{ 205, 1, 0 });
+	SRE3021_CHECK(finder.GetLateRecordCount() == 0);
+	SRE3021_CHECK(finder.FindCoincidences(coincidences) == 0);
+	SRE3021_CHECK(finder.FindCoincidences(coincidences, true) == 1);
+	SRE3021_CHECK(coincidences.size() == 1 && coincidences[0].Timestamp == 195 && coincidences[0].Multiplicity == 3 && coincidences[0].Duration == 10);
+}
+
+SRE3021_TEST(CoincidenceFinderCountsLateRecords)
+{
+	SRE3021CoincidenceFinder finder = MakeTestFinder(10, 100);
+	std::vector<SRE3021Coincidence> coincidences;
+	AddRecords(finder, { { 0, 0, 0 }, { 2, 1, 0 }, { 150, 0, 0 }, { 152, 1, 0 } });
+	// Both sources were heard up to 150, everything up to there is merged
+	SRE3021_CHECK(finder.FindCoincidences(coincidences) == 1);
+	finder.Add(SRE3021TriggerRecord{ 100, 1, 0 });
+	finder.Add(SRE3021TriggerRecord{ 149, 0, 0 });
+	SRE3021_CHECK(finder.GetLateRecordCount() == 2);
+	finder.Add(SRE3021TriggerRecord{ 151, 0, 0 });
+	SRE3021_CHECK(finder.GetLateRecordCount() == 2);
+	coincidences.clear();
+	SRE3021_CHECK(finder.FindCoincidences(coincidences, true) == 1);
+	SRE3021_CHECK(coincidences[0].Timestamp == 150 && coincidences[0].Multiplicity == 3);
+
+	finder.Reset();
+	SRE3021_CHECK(finder.GetLateRecordCount() == 0);
+	SRE3021_CHECK(finder.GetMultiplicityHistogram()[2] == 0);
+}
+
+SRE3021_TEST(CoincidenceFinderFlush)
+{
+	SRE3021CoincidenceFinder finder = MakeTestFinder(10, 100);
+	std::vector<SRE3021Coincidence> coincidences;
+	SRE3021_CHECK(finder.FindCoincidences(coincidences, true) == 0);
+	AddRecords(finder, { { 0, 0, 0 }, { 3, 1, 0 }, { 50, 2, 0 } });
+	SRE3021_CHECK(finder.FindCoincidences(coincidences) == 0);
+	// Flush merges and groups every queued record, started or not
+	SRE3021_CHECK(finder.FindCoincidences(coincidences, true) == 1);
+	SRE3021_CHECK(coincidences.size() == 1 && coincidences[0].Timestamp == 0 && coincidences[0].Duration == 3);
+	SRE3021_CHECK(finder.GetMultiplicityHistogram()[1] == 1 && finder.GetMultiplicityHistogram()[2] == 1);
+	SRE3021_CHECK(finder.FindCoincidences(coincidences, true) == 0);
+}
+
+// Two trigger time packets finished by decode workers in reverse order, as SRE3021API hands them over
+SRE3021_TEST(CoincidenceFinderPacketsInTicketOrder)
+{
+	// The second packet carries every source and spans more than HoldTicks, on its own it lets the merge pass the first
+	const std::vector<SRE3021TriggerRecord> packets[2] = {
+		{ { 100, 0, 0 }, { 102, 1, 0 } },
+		{ { 300, 0, 0 }, { 302, 1, 0 }, { 400, 0, 0 }, { 402, 1, 0 } } };
+
+	SRE3021CoincidenceFinder reversedFinder = MakeTestFinder(10, 100);
+	std::vector<SRE3021Coincidence> coincidences;
+	for (int packet = 1; packet >= 0; --packet)
+	{
+		AddRecords(reversedFinder, packets[packet]);
+		reversedFinder.FindCoincidences(coincidences);
+	}
+	SRE3021_CHECK(reversedFinder.GetLateRecordCount() == 2);
+
+	// Published in reverse through the reorder buffer, delivered in ticket order
+	SRE3021CoincidenceFinder finder = MakeTestFinder(10, 100);
+	SRE3021ReorderBuffer<int> decodedPackets;
+	decodedPackets.Resize(4);
+	coincidences.clear();
+	auto deliver = [&](int packet)
+	{
+		AddRecords(finder, packets[packet]);
+		finder.FindCoincidences(coincidences);
+	};
+	decodedPackets.Slot(1) = 1;
+	decodedPackets.Publish(1);
+	SRE3021_CHECK(decodedPackets.Drain(deliver) == 0);
+	decodedPackets.Slot(0) = 0;
+	decodedPackets.Publish(0);
+	SRE3021_CHECK(decodedPackets.Drain(deliver) == 2);
+	SRE3021_CHECK(finder.GetLateRecordCount() == 0);
+	finder.FindCoincidences(coincidences, true);
+	SRE3021_CHECK(coincidences.size() == 3);
+	SRE3021_CHECK(finder.GetMultiplicityHistogram()[2] == 3);
+}
@@ -0,0 +1,97 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+#include "SRE3021Test.h"
+
+#include <vector>
+
+#include "../SRE3021CountingAccumulator.h"
+
+using namespace hurel::sre3021;
+
+// Counting frame Packet Data with counter i set to i, overflow flags from the list of counters
+static std::vector<unsigned __int8> MakeCountingFrame(unsigned __int8 dataGroup, const std::vector<int>& overflowCounters)
+{
+	std::vector<unsigned __int8> data(SRE3021_COUNTING_FRAME_DATA_LENGTH, 0);
+	data[0] = dataGroup;
+	for (int counter = 0; counter < SRE3021_COUNTING_FRAME_COUNTER_COUNT; ++counter)
+	{
+		const int asic = counter / SRE3021_COUNTING_FRAME_COUNTERS_PER_ASIC;
+		const int i = counter % SRE3021_COUNTING_FRAME_COUNTERS_PER_ASIC;
+		unsigned __int8* group = &data[1 + asic * (SRE3021_COUNTING_FRAME_COUNTERS_PER_ASIC * 2 + SRE3021_COUNTING_FRAME_FLAG_BYTES_PER_ASIC)];
+		group[i * 2] = static_cast<unsigned __int8>(counter >> 8);
+		group[i * 2 + 1] = static_cast<unsigned __int8>(counter & 0xFF);
+	}
+	for (int counter : overflowCounters)
+	{
+		const int asic = counter / SRE3021_COUNTING_FRAME_COUNTERS_PER_ASIC;
+		const int i = counter % SRE3021_COUNTING_FRAME_COUNTERS_PER_ASIC;
+		unsigned __int8* flags = &data[1 + asic * (SRE3021_COUNTING_FRAME_COUNTERS_PER_ASIC * 2 + SRE3021_COUNTING_FRAME_FLAG_BYTES_PER_ASIC)
+			+ SRE3021_COUNTING_FRAME_COUNTERS_PER_ASIC * 2];
+		flags[i / 8] |= static_cast<unsigned __int8>(1 << (i % 8));
+	}
+	return data;
+}
+
+SRE3021_TEST(CountingAccumulatorFrame)
+{
+	SRE3021_CHECK(SRE3021_COUNTING_FRAME_DATA_LENGTH == 953);
+	// Bit 1 of the second flag byte of ASIC 0, the last bit of ASIC 6 and a counter in the middle
+	const std::vector<int> overflowCounters = { 9, 200, SRE3021_COUNTING_FRAME_COUNTER_COUNT - 1 };
+	const std::vector<unsigned __int8> frame = MakeCountingFrame(0, overflowCounters);
+	SRE3021CountingAccumulator accumulator;
+	SRE3021_CHECK(accumulator.Accumulate(frame.data(), static_cast<int>(frame.size())) == SRE3021PacketDecodeStatus::SUCCESS);
+	SRE3021_CHECK(accumulator.Accumulate(frame.data(), static_cast<int>(frame.size())) == SRE3021PacketDecodeStatus::SUCCESS);
+	SRE3021_CHECK(accumulator.GetFrameCount() == 2);
+
+	size_t wrongCount = 0;
+	for (int counter = 0; counter < SRE3021_COUNTING_FRAME_COUNTER_COUNT; ++counter)
+	{
+		const bool isOverflow = counter == 9 || counter == 200 || counter == SRE3021_COUNTING_FRAME_COUNTER_COUNT - 1;
+		const unsigned long long expected = 2ULL * (counter + (isOverflow ? SRE3021_COUNTING_FRAME_OVERFLOW_COUNTS : 0));
+		wrongCount += accumulator.GetCount(counter) != expected;
+		wrongCount += accumulator.GetOverflowCount(counter) != (isOverflow ? 2ULL : 0ULL);
+	}
+	SRE3021_CHECK(wrongCount == 0);
+	const std::vector<unsigned long long> counts = accumulator.GetCounts();
+	SRE3021_CHECK(counts.size() == SRE3021_COUNTING_FRAME_COUNTER_COUNT && counts[9] == 2ULL * (9 + 0x10000) && counts[10] == 20);
+}
+
+SRE3021_TEST(CountingAccumulatorSkipsOtherDataGroups)
+{
+	SRE3021CountingAccumulator accumulator;
+	const std::vector<unsigned __int8> frame = MakeCountingFrame(1, { 0 });
+	SRE3021_CHECK(accumulator.Accumulate(frame.data(), static_cast<int>(frame.size())) == SRE3021PacketDecodeStatus::SUCCESS);
+	SRE3021_CHECK(accumulator.GetFrameCount() == 0);
+	SRE3021_CHECK(accumulator.GetCount(1) == 0 && accumulator.GetCount(0) == 0 && accumulator.GetOverflowCount(0) == 0);
+
+	const std::vector<unsigned __int8> groupZero = MakeCountingFrame(0, {});
+	SRE3021_CHECK(accumulator.Accumulate(groupZero.data(), SRE3021_COUNTING_FRAME_DATA_LENGTH - 1) == SRE3021PacketDecodeStatus::ERROR_DATA_LENGTH);
+	SRE3021_CHECK(accumulator.GetFrameCount() == 0);
+	SRE3021_CHECK(accumulator.Accumulate(groupZero.data(), static_cast<int>(groupZero.size())) == SRE3021PacketDecodeStatus::SUCCESS);
+	SRE3021_CHECK(accumulator.GetFrameCount() == 1 && accumulator.GetCount(100) == 100);
+
+	accumulator.Reset();
+	SRE3021_CHECK(accumulator.GetFrameCount() == 0 && accumulator.GetCount(100) == 0);
+}
@@ -0,0 +1,130 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+#include "SRE3021Test.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "../SRE3021EventBus.h"
+
+using namespace hurel::sre3021;
+
+#define SRE3021_TEST_EVENT_BUS_THREAD_COUNT (2)
+#define SRE3021_TEST_EVENT_BUS_EVENT_COUNT (8000)
+#define SRE3021_TEST_EVENT_BUS_BATCH_SIZE (8)
+
+typedef SRE3021EventBus<int> TestEventBus;
+
+// Blocks in its first batch until released, so its queue fills while the publishers run
+struct TestSlowConsumer {
+	std::atomic<bool> IsReleased{ false };
+	std::atomic<size_t> BatchCount{ 0 };
+	std::atomic<size_t> EventCount{ 0 };
+
+	void operator()(const TestEventBus::Batch& batch)
+	{
+		while (!IsReleased.load(std::memory_order_acquire))
+		{
+			std::this_thread::yield();
+		}
+		BatchCount.fetch_add(1, std::memory_order_relaxed);
+		EventCount.fetch_add(batch.size(), std::memory_order_relaxed);
+	}
+};
+
+SRE3021_TEST(EventBusSlowConsumerDropsOwnBatches)
+{
+	TestEventBus bus;
+	TestSlowConsumer slow;
+	std::atomic<size_t> fastEventCount{ 0 };
+	const int slowId = bus.Subscribe([&slow](const TestEventBus::Batch& batch) { slow(batch); }, 4);
+	const int fastId = bus.Subscribe([&fastEventCount](const TestEventBus::Batch& batch)
+	{
+		fastEventCount.fetch_add(batch.size(), std::memory_order_relaxed);
+	}, SRE3021_TEST_EVENT_BUS_EVENT_COUNT);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < SRE3021_TEST_EVENT_BUS_THREAD_COUNT; ++t)
+	{
+		threads.push_back(std::thread([&bus]()
+		{
+			TestEventBus::Publisher publisher(&bus, SRE3021_TEST_EVENT_BUS_BATCH_SIZE);
+			for (int i = 0; i < SRE3021_TEST_EVENT_BUS_EVENT_COUNT / SRE3021_TEST_EVENT_BUS_THREAD_COUNT; ++i)
+			{
+				publisher.Add(i);
+			}
+		}));
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	slow.IsReleased.store(true, std::memory_order_release);
+
+	const size_t publishedBatchCount = SRE3021_TEST_EVENT_BUS_EVENT_COUNT / SRE3021_TEST_EVENT_BUS_BATCH_SIZE;
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	SRE3021EventBusStats slowStats = bus.GetStats(slowId);
+	SRE3021EventBusStats fastStats = bus.GetStats(fastId);
+	while ((slowStats.DeliveredBatchCount + slowStats.DroppedBatchCount < publishedBatchCount
+		|| fastStats.DeliveredBatchCount < publishedBatchCount) && test::SecondsSince(start) < 10)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		slowStats = bus.GetStats(slowId);
+		fastStats = bus.GetStats(fastId);
+	}
+
+	SRE3021_CHECK(slowStats.DeliveredBatchCount + slowStats.DroppedBatchCount == publishedBatchCount);
+	SRE3021_CHECK(slowStats.DeliveredEventCount + slowStats.DroppedEventCount == SRE3021_TEST_EVENT_BUS_EVENT_COUNT);
+	SRE3021_CHECK(slowStats.DroppedBatchCount > 0 && slowStats.QueueHighWaterMark == 4);
+	SRE3021_CHECK(slow.BatchCount.load() == slowStats.DeliveredBatchCount && slow.EventCount.load() == slowStats.DeliveredEventCount);
+	// The slow subscriber does not hold up the other one
+	SRE3021_CHECK(fastStats.DeliveredBatchCount == publishedBatchCount && fastStats.DroppedBatchCount == 0);
+	SRE3021_CHECK(fastEventCount.load() == SRE3021_TEST_EVENT_BUS_EVENT_COUNT);
+}
+
+SRE3021_TEST(EventBusUnsubscribeDrainsQueue)
+{
+	TestEventBus bus;
+	TestSlowConsumer slow;
+	const int id = bus.Subscribe([&slow](const TestEventBus::Batch& batch) { slow(batch); }, 16);
+	for (int i = 0; i < 10; ++i)
+	{
+		bus.Publish(std::make_shared<const TestEventBus::Batch>(TestEventBus::Batch{ i, i + 1, i + 2 }));
+	}
+	SRE3021_CHECK(bus.GetStats(id).DroppedBatchCount == 0);
+
+	// Stop while the consumer still holds the first batch, the rest waits in the queue
+	bool isUnsubscribed = false;
+	std::thread unsubscribing([&bus, &isUnsubscribed, id]() { isUnsubscribed = bus.Unsubscribe(id); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	slow.IsReleased.store(true, std::memory_order_release);
+	unsubscribing.join();
+
+	SRE3021_CHECK(isUnsubscribed);
+	SRE3021_CHECK(slow.BatchCount.load() == 10 && slow.EventCount.load() == 30);
+	SRE3021_CHECK(!bus.HasSubscribers() && !bus.Unsubscribe(id));
+}
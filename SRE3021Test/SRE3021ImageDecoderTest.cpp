@@ -0,0 +1,413 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021Test.h"
+#include "SRE3021TestPackets.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace hurel::sre3021;
+using namespace hurel::sre3021::test;
+
+static const SRE3021SimdLevel SimdLevels[] = { SRE3021SimdLevel::SCALAR, SRE3021SimdLevel::SSE2, SRE3021SimdLevel::AVX2 };
+static const char* SimdLevelNames[] = { "SCALAR", "SSE2", "AVX2" };
+
+// Words of the packet as DecodeWords returns them, see DecodeWordsScalar
+static void DecodeWordsReference(const unsigned __int8* packet, const TestBaseline& baseline, __int32* outWords)
+{
+	const unsigned __int8* words = packet + SRE3021_IMAGE_WORD_OFFSET;
+	for (int i = 0; i < SRE3021_IMAGE_WORD_COUNT; ++i)
+	{
+		const int pixel = i % SRE3021_IMAGE_PIXEL_COUNT;
+		const size_t wordBaseline = i < SRE3021_IMAGE_PIXEL_COUNT ? baseline.AnodeValue[pixel % 11][pixel / 11] : baseline.AnodeTiming[pixel % 11][pixel / 11];
+		outWords[i] = static_cast<__int32>(words[2 * i] << 8 | words[2 * i + 1]) - static_cast<__int32>(wordBaseline);
+	}
+}
+
+// Random packets, plus packets of all zero and all one bits to reach both ends of the 16 bit range
+static std::vector<unsigned __int8> MakeDecoderTestPackets(std::mt19937& random, size_t packetCount)
+{
+	std::vector<unsigned __int8> packets = MakeRandomImagePackets(random, packetCount);
+	memset(&packets[SRE3021_PACKET_HEADER_LENGTH], 0x00, SRE3021_IMAGE_PACKET_LENGTH - SRE3021_PACKET_HEADER_LENGTH);
+	memset(&packets[SRE3021_IMAGE_PACKET_LENGTH + SRE3021_PACKET_HEADER_LENGTH], 0xFF, SRE3021_IMAGE_PACKET_LENGTH - SRE3021_PACKET_HEADER_LENGTH);
+	return packets;
+}
+
+SRE3021_TEST(ImageDecoderSimdLevelsMatchScalar)
+{
+	std::mt19937 random(12);
+	const size_t packetCount = 256;
+	const std::vector<unsigned __int8> packets = MakeDecoderTestPackets(random, packetCount);
+	// Baselines above the 16 bit range make the compact planes saturate
+	const unsigned int maxBaselines[] = { 0, 4095, 100000 };
+	for (unsigned int maxBaseline : maxBaselines)
+	{
+		TestBaseline baseline;
+		baseline.Randomize(random, maxBaseline);
+		for (int level = 0; level < 3; ++level)
+		{
+			SRE3021ImageDecoder decoder;
+			decoder.SetSimdLevel(SimdLevels[level]);
+			if (decoder.GetSimdLevel() != SimdLevels[level])
+			{
+				printf("  %s not supported by this CPU, skipped\n", SimdLevelNames[level]);
+				continue;
+			}
+			baseline.Apply(decoder);
+			for (size_t i = 0; i < packetCount; ++i)
+			{
+				const unsigned __int8* packet = &packets[i * SRE3021_IMAGE_PACKET_LENGTH];
+				__int32 expectedWords[SRE3021_IMAGE_WORD_COUNT];
+				__int32 words[SRE3021_IMAGE_WORD_COUNT];
+				DecodeWordsReference(packet, baseline, expectedWords);
+				decoder.DecodeWords(packet, words);
+				SRE3021_CHECK(memcmp(words, expectedWords, sizeof(words)) == 0);
+
+				SRE3021ImageData expected;
+				SRE3021ImageData imageData;
+				DecodeImagePacketReference(packet, baseline, expected);
+				decoder.Decode(packet, imageData);
+				SRE3021_CHECK(IsSameImageData(imageData, expected));
+
+				SRE3021CompactImageData expectedCompact = SRE3021CompactImageData::FromImageData(expected);
+				SRE3021CompactImageData compact;
+				decoder.DecodeCompact(packet, compact);
+				SRE3021_CHECK(memcmp(compact.AnodeValue, expectedCompact.AnodeValue, sizeof(compact.AnodeValue)) == 0);
+				SRE3021_CHECK(memcmp(compact.AnodeTiming, expectedCompact.AnodeTiming, sizeof(compact.AnodeTiming)) == 0);
+				SRE3021_CHECK(compact.CathodeValue == expectedCompact.CathodeValue && compact.CathodeTiming == expectedCompact.CathodeTiming);
+				SRE3021_CHECK(compact.Timestamp == expected.Timestamp);
+			}
+		}
+	}
+}
+
+SRE3021_TEST(ImageDecoderSetBaselineWhileDecoding)
+{
+	std::mt19937 random(12);
+	const size_t packetCount = 64;
+	const std::vector<unsigned __int8> packets = MakeDecoderTestPackets(random, packetCount);
+	TestBaseline baselines[2];
+	baselines[0].Randomize(random, 4095);
+	baselines[1].Randomize(random, 4095);
+	std::vector<SRE3021ImageData> expected[2];
+	for (int b = 0; b < 2; ++b)
+	{
+		expected[b].resize(packetCount);
+		for (size_t i = 0; i < packetCount; ++i)
+		{
+			DecodeImagePacketReference(&packets[i * SRE3021_IMAGE_PACKET_LENGTH], baselines[b], expected[b][i]);
+		}
+	}
+
+	SRE3021ImageDecoder decoder;
+	baselines[0].Apply(decoder);
+	std::atomic<bool> isDone(false);
+	size_t mixedCount = 0;
+	std::thread decodeThread([&]()
+	{
+		SRE3021ImageData imageData;
+		for (int round = 0; round < 1000; ++round)
+		{
+			for (size_t i = 0; i < packetCount; ++i)
+			{
+				decoder.Decode(&packets[i * SRE3021_IMAGE_PACKET_LENGTH], imageData);
+				// Every event is decoded against one of the two baselines, never a mix of both
+				mixedCount += !IsSameImageData(imageData, expected[0][i]) && !IsSameImageData(imageData, expected[1][i]);
+			}
+		}
+		isDone.store(true);
+	});
+	// Keeps every table, so swap a bounded number of times
+	for (int round = 0; round < 20000 && !isDone.load(); ++round)
+	{
+		baselines[(round + 1) % 2].Apply(decoder);
+	}
+	decodeThread.join();
+	SRE3021_CHECK(mixedCount == 0);
+}
+
+SRE3021_TEST(ImageDecoderClampsSimdLevelToDetected)
+{
+	SRE3021ImageDecoder decoder;
+	SRE3021_CHECK(decoder.GetSimdLevel() == SRE3021ImageDecoder::DetectSimdLevel());
+	decoder.SetSimdLevel(SRE3021SimdLevel::AVX2);
+	SRE3021_CHECK(decoder.GetSimdLevel() == SRE3021ImageDecoder::DetectSimdLevel());
+	decoder.SetSimdLevel(SRE3021SimdLevel::SCALAR);
+	SRE3021_CHECK(decoder.GetSimdLevel() == SRE3021SimdLevel::SCALAR);
+}
+
+SRE3021_BENCHMARK(ImageDecoderSimdLevels)
+{
+	std::mt19937 random(12);
+	const size_t packetCount = 4096;
+	const int roundCount = 50;
+	const std::vector<unsigned __int8> packets = MakeRandomImagePackets(random, packetCount);
+	TestBaseline baseline;
+	baseline.Randomize(random, 4095);
+	const double eventCount = static_cast<double>(packetCount) * roundCount;
+
+	// The per pixel loop the image processing thread used before the decoder
+	std::vector<SRE3021ImageData> expected(packetCount);
+	auto start = std::chrono::steady_clock::now();
+	for (int round = 0; round < roundCount; ++round)
+	{
+		for (size_t i = 0; i < packetCount; ++i)
+		{
+			DecodeImagePacketReference(&packets[i * SRE3021_IMAGE_PACKET_LENGTH], baseline, expected[i]);
+		}
+	}
+	ReportRate("per pixel loop, Decode", eventCount, "events/s", SecondsSince(start));
+
+	char name[64];
+	for (int level = 0; level < 3; ++level)
+	{
+		SRE3021ImageDecoder decoder;
+		decoder.SetSimdLevel(SimdLevels[level]);
+		if (decoder.GetSimdLevel() != SimdLevels[level])
+		{
+			printf("  %s not supported by this CPU, skipped\n", SimdLevelNames[level]);
+			continue;
+		}
+		baseline.Apply(decoder);
+
+		SRE3021ImageData imageData;
+		bool isSame = true;
+		start = std::chrono::steady_clock::now();
+		for (int round = 0; round < roundCount; ++round)
+		{
+			for (size_t i = 0; i < packetCount; ++i)
+			{
+				decoder.Decode(&packets[i * SRE3021_IMAGE_PACKET_LENGTH], imageData);
+				isSame &= imageData.AnodeValue[i % 11][5] == expected[i].AnodeValue[i % 11][5];
+			}
+		}
+		snprintf(name, sizeof(name), "%s Decode", SimdLevelNames[level]);
+		ReportRate(name, eventCount, "events/s", SecondsSince(start));
+		SRE3021_CHECK(isSame);
+
+		__int32 words[SRE3021_IMAGE_WORD_COUNT];
+		__int32 expectedWords[SRE3021_IMAGE_WORD_COUNT];
+		__int32 checksum = 0;
+		start = std::chrono::steady_clock::now();
+		for (int round = 0; round < roundCount; ++round)
+		{
+			for (size_t i = 0; i < packetCount; ++i)
+			{
+				decoder.DecodeWords(&packets[i * SRE3021_IMAGE_PACKET_LENGTH], words);
+				checksum += words[i % SRE3021_IMAGE_WORD_COUNT];
+			}
+		}
+		snprintf(name, sizeof(name), "%s DecodeWords", SimdLevelNames[level]);
+		ReportRate(name, eventCount, "events/s", SecondsSince(start));
+		__int32 expectedChecksum = 0;
+		for (size_t i = 0; i < packetCount; ++i)
+		{
+			DecodeWordsReference(&packets[i * SRE3021_IMAGE_PACKET_LENGTH], baseline, expectedWords);
+			expectedChecksum += expectedWords[i % SRE3021_IMAGE_WORD_COUNT];
+		}
+		SRE3021_CHECK(checksum == expectedChecksum * roundCount);
+
+		SRE3021CompactImageData compact;
+		isSame = true;
+		start = std::chrono::steady_clock::now();
+		for (int round = 0; round < roundCount; ++round)
+		{
+			for (size_t i = 0; i < packetCount; ++i)
+			{
+				decoder.DecodeCompact(&packets[i * SRE3021_IMAGE_PACKET_LENGTH], compact);
+				isSame &= compact.AnodeTiming[5][i % 11] == SRE3021CompactImageData::Saturate(expected[i].AnodeTiming[i % 11][5]);
+			}
+		}
+		snprintf(name, sizeof(name), "%s DecodeCompact", SimdLevelNames[level]);
+		ReportRate(name, eventCount, "events/s", SecondsSince(start));
+		SRE3021_CHECK(isSame);
+	}
+}
+
+// Column entries of one event against the event Decode returns for its packet
+static bool IsSameColumnEvent(const SRE3021ImageColumns& columns, size_t eventIndex, const SRE3021ImageData& expected)
+{
+	if (columns.Timestamp[eventIndex] != expected.Timestamp || columns.CathodeValue[eventIndex] != expected.CathodeValue
+		|| columns.CathodeTiming[eventIndex] != expected.CathodeTiming)
+	{
+		return false;
+	}
+	for (int X = 0; X < 11; ++X)
+	{
+		for (int Y = 0; Y < 11; ++Y)
+		{
+			if (columns.GetAnodeValue(eventIndex, X, Y) != expected.AnodeValue[X][Y] || columns.GetAnodeTiming(eventIndex, X, Y) != expected.AnodeTiming[X][Y])
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+SRE3021_TEST(ImageDecoderBatchMatchesDecode)
+{
+	std::mt19937 random(15);
+	// Around the 8 event kernels and the 256 packet blocks
+	const size_t packetCounts[] = { 1, 7, 8, 255, 256, 257 };
+	// Packets next to each other, and a cache line aligned stride as in a packet pool
+	const size_t packetStrides[] = { SRE3021_IMAGE_PACKET_LENGTH, 576 };
+	TestBaseline baseline;
+	baseline.Randomize(random, 4095);
+	for (size_t packetStride : packetStrides)
+	{
+		const std::vector<unsigned __int8> packets = MakeRandomImagePackets(random, 257, packetStride);
+		for (int level = 0; level < 3; ++level)
+		{
+			SRE3021ImageDecoder decoder;
+			decoder.SetSimdLevel(SimdLevels[level]);
+			if (decoder.GetSimdLevel() != SimdLevels[level])
+			{
+				printf("  %s not supported by this CPU, skipped\n", SimdLevelNames[level]);
+				continue;
+			}
+			baseline.Apply(decoder);
+			for (size_t packetCount : packetCounts)
+			{
+				SRE3021ImageColumns columns;
+				decoder.DecodeBatch(&packets[0], packetCount, columns, packetStride);
+				SRE3021_CHECK(columns.EventCount == packetCount);
+				SRE3021_CHECK(columns.AnodeValue.size() == packetCount * SRE3021_IMAGE_PIXEL_COUNT);
+				size_t wrongCount = 0;
+				for (size_t i = 0; i < packetCount; ++i)
+				{
+					SRE3021ImageData expected;
+					decoder.Decode(&packets[i * packetStride], expected);
+					wrongCount += !IsSameColumnEvent(columns, i, expected);
+				}
+				SRE3021_CHECK(wrongCount == 0);
+			}
+		}
+	}
+}
+
+SRE3021_BENCHMARK(ImageDecoderBatch)
+{
+	std::mt19937 random(15);
+	const size_t packetCount = 4096;
+	const int roundCount = 50;
+	const std::vector<unsigned __int8> packets = MakeRandomImagePackets(random, packetCount);
+	TestBaseline baseline;
+	baseline.Randomize(random, 4095);
+	const double eventCount = static_cast<double>(packetCount) * roundCount;
+
+	char name[64];
+	for (int level = 0; level < 3; ++level)
+	{
+		SRE3021ImageDecoder decoder;
+		decoder.SetSimdLevel(SimdLevels[level]);
+		if (decoder.GetSimdLevel() != SimdLevels[level])
+		{
+			printf("  %s not supported by this CPU, skipped\n", SimdLevelNames[level]);
+			continue;
+		}
+		baseline.Apply(decoder);
+
+		// One SRE3021ImageData per event, as the image processing thread keeps them
+		std::vector<SRE3021ImageData> events(packetCount);
+		auto start = std::chrono::steady_clock::now();
+		for (int round = 0; round < roundCount; ++round)
+		{
+			for (size_t i = 0; i < packetCount; ++i)
+			{
+				decoder.Decode(&packets[i * SRE3021_IMAGE_PACKET_LENGTH], events[i]);
+			}
+		}
+		snprintf(name, sizeof(name), "%s Decode per packet", SimdLevelNames[level]);
+		ReportRate(name, eventCount, "events/s", SecondsSince(start));
+
+		SRE3021ImageColumns columns;
+		start = std::chrono::steady_clock::now();
+		for (int round = 0; round < roundCount; ++round)
+		{
+			decoder.DecodeBatch(&packets[0], packetCount, columns);
+		}
+		snprintf(name, sizeof(name), "%s DecodeBatch", SimdLevelNames[level]);
+		ReportRate(name, eventCount, "events/s", SecondsSince(start));
+
+		size_t wrongCount = 0;
+		for (size_t i = 0; i < packetCount; i += 97)
+		{
+			wrongCount += !IsSameColumnEvent(columns, i, events[i]);
+		}
+		SRE3021_CHECK(wrongCount == 0);
+	}
+}
+
+SRE3021_TEST(ImageDecoderPulseHeightEventTriggerFlags)
+{
+	std::mt19937 random(19);
+	TestBaseline baseline;
+	baseline.Randomize(random, 100);
+	SRE3021ImageDecoder decoder;
+	baseline.Apply(decoder);
+
+	// First two channels with an anode pixel, one triggered by the ASIC and one forced
+	int channels[2];
+	int channelCount = 0;
+	for (int channel = 0; channel < SRE3021_ASIC_CHANNEL_COUNT && channelCount < 2; ++channel)
+	{
+		if (decoder.GetPixelOfASICChannel(channel) >= 0)
+		{
+			channels[channelCount++] = channel;
+		}
+	}
+	SRE3021_CHECK(channelCount == 2);
+	const SRE3021PulseHeightSample samples[2] = {
+		{ SRE3021TriggerType::ASIC_TRIGGER, 0, static_cast<unsigned __int16>(channels[0]), 3000 },
+		{ SRE3021TriggerType::SYSTEM_AUTO_FORCED_READOUT, 0, static_cast<unsigned __int16>(channels[1]), 2000 } };
+	const SRE3021PulseHeightEvent event{ 1234, samples };
+	const int triggeredPixel = decoder.GetPixelOfASICChannel(channels[0]);
+	const int forcedPixel = decoder.GetPixelOfASICChannel(channels[1]);
+
+	SRE3021ImageData imageData;
+	decoder.DecodePulseHeightEvent(event, 2, imageData);
+	SRE3021_CHECK(imageData.AnodeTimingMode == SRE3021AnodeTimingMode::TRIGGER_FLAG);
+	SRE3021_CHECK(imageData.Timestamp == 1234);
+	SRE3021_CHECK(imageData.AnodeTiming[triggeredPixel % 11][triggeredPixel / 11] == 1);
+	SRE3021_CHECK(imageData.AnodeTiming[forcedPixel % 11][forcedPixel / 11] == 0);
+	SRE3021_CHECK(imageData.AnodeValue[triggeredPixel % 11][triggeredPixel / 11]
+		== 3000 - static_cast<long long>(baseline.AnodeValue[triggeredPixel % 11][triggeredPixel / 11]));
+
+	SRE3021CompactImageData compact;
+	decoder.DecodePulseHeightEventCompact(event, 2, compact);
+	SRE3021_CHECK(compact.AnodeTimingMode == SRE3021AnodeTimingMode::TRIGGER_FLAG);
+	SRE3021_CHECK(compact.GetAnodeTiming(triggeredPixel % 11, triggeredPixel / 11) == 1);
+	SRE3021_CHECK(compact.GetAnodeTiming(forcedPixel % 11, forcedPixel / 11) == 0);
+	SRE3021_CHECK(compact.ToImageData().AnodeTimingMode == SRE3021AnodeTimingMode::TRIGGER_FLAG);
+
+	// An image packet decoded into the same event has timing words again
+	const std::vector<unsigned __int8> packets = MakeRandomImagePackets(random, 1);
+	decoder.Decode(&packets[0], imageData);
+	SRE3021_CHECK(imageData.AnodeTimingMode == SRE3021AnodeTimingMode::PULSE_TIMING);
+	decoder.DecodeCompact(&packets[0], compact);
+	SRE3021_CHECK(compact.AnodeTimingMode == SRE3021AnodeTimingMode::PULSE_TIMING);
+}
@@ -0,0 +1,171 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+#include "SRE3021Test.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "../SRE3021ImageFrameReassembler.h"
+
+using namespace hurel::sre3021;
+
+#define TEST_FRAGMENT_CAPACITY (100)
+
+// Image data packet of one fragment, payload bytes count up from the frame number plus the position times 50
+static std::vector<unsigned __int8> MakeFragment(int systemNumber, int frameNumber, int dataPacketCount, int dataSequence, int payloadLength)
+{
+	std::vector<unsigned __int8> packet(SRE3021_IMAGE_DATA_OFFSET + payloadLength, 0);
+	const SRE3021HeaderBytes header = SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 0, systemNumber, SRE3021PacketType::IMG_DATA,
+		SRE3021PacketSequence::STAND_ALONE, 0, 1000, static_cast<int>(packet.size()) - SRE3021_PACKET_HEADER_LENGTH });
+	std::memcpy(packet.data(), header.Bytes, SRE3021_PACKET_HEADER_LENGTH);
+	unsigned __int8* fields = &packet[SRE3021_IMAGE_FIELDS_OFFSET];
+	fields[0] = static_cast<unsigned __int8>(frameNumber >> 8);
+	fields[1] = static_cast<unsigned __int8>(frameNumber);
+	fields[3] = 16;
+	fields[5] = 12;
+	fields[7] = 1;
+	fields[9] = 2;
+	fields[13] = 0x5A;
+	fields[15] = static_cast<unsigned __int8>(dataPacketCount);
+	fields[17] = static_cast<unsigned __int8>(dataSequence);
+	for (int i = 0; i < payloadLength; ++i)
+	{
+		packet[SRE3021_IMAGE_DATA_OFFSET + i] = static_cast<unsigned __int8>(frameNumber + dataSequence * 50 + i);
+	}
+	return packet;
+}
+
+static SRE3021ImageFrameStatus AddFragment(SRE3021ImageFrameReassembler& reassembler, const std::vector<unsigned __int8>& packet, long long receiveTime,
+	unsigned __int32& outFrameIndex, unsigned __int32& outFrameLength)
+{
+	return reassembler.Add(packet.data(), static_cast<int>(packet.size()), receiveTime, outFrameIndex, outFrameLength);
+}
+
+static SRE3021ImageFrameStatus AddFragment(SRE3021ImageFrameReassembler& reassembler, const std::vector<unsigned __int8>& packet, long long receiveTime)
+{
+	unsigned __int32 frameIndex = 0;
+	unsigned __int32 frameLength = 0;
+	return AddFragment(reassembler, packet, receiveTime, frameIndex, frameLength);
+}
+
+SRE3021_TEST(ImageFrameReassemblerOutOfOrder)
+{
+	SRE3021ImageFrameReassembler reassembler;
+	reassembler.Allocate(4, TEST_FRAGMENT_CAPACITY);
+	// The short fragment in the middle leaves a gap the completed frame has to close
+	const int payloadLengths[4] = { 100, 60, 100, 30 };
+	std::vector<std::vector<unsigned __int8>> fragments;
+	std::vector<unsigned __int8> expectedData;
+	for (int i = 0; i < 4; ++i)
+	{
+		fragments.push_back(MakeFragment(1, 7, 4, i, payloadLengths[i]));
+		expectedData.insert(expectedData.end(), fragments.back().begin() + SRE3021_IMAGE_DATA_OFFSET, fragments.back().end());
+	}
+
+	unsigned __int32 frameIndex = 0;
+	unsigned __int32 frameLength = 0;
+	SRE3021_CHECK(AddFragment(reassembler, fragments[2], 0) == SRE3021ImageFrameStatus::INCOMPLETE);
+	SRE3021_CHECK(AddFragment(reassembler, fragments[0], 1) == SRE3021ImageFrameStatus::INCOMPLETE);
+	SRE3021_CHECK(AddFragment(reassembler, fragments[3], 2) == SRE3021ImageFrameStatus::INCOMPLETE);
+	SRE3021_CHECK(AddFragment(reassembler, fragments[1], 3, frameIndex, frameLength) == SRE3021ImageFrameStatus::COMPLETE);
+	SRE3021_CHECK(frameLength == SRE3021_IMAGE_DATA_OFFSET + expectedData.size());
+
+	const unsigned __int8* data = reassembler.Data(frameIndex);
+	SRE3021ImageFrame frame;
+	SRE3021_CHECK(SRE3021ImageFrameReassembler::DecodeImageFrame(data, static_cast<int>(frameLength), frame) == SRE3021PacketDecodeStatus::SUCCESS);
+	SRE3021_CHECK(frame.SystemNumber == 1 && frame.FrameNumber == 7 && frame.Width == 16 && frame.Height == 12);
+	SRE3021_CHECK(frame.SpectralChannels == 1 && frame.DataWidth == 2 && frame.UserDefined == 0x5A);
+	SRE3021_CHECK(frame.DataLength == expectedData.size() && std::equal(expectedData.begin(), expectedData.end(), frame.Data));
+	// Laid out as a single packet image
+	SRE3021_CHECK(SRE3021ImageFrameReassembler::DecodeDataPacketCount(data) == 1);
+	SRE3021_CHECK(SRE3021HeaderCodec::ReadBigEndian16(data + 8) == frameLength - SRE3021_PACKET_HEADER_LENGTH);
+
+	const SRE3021ImageFrameStats stats = reassembler.GetStats();
+	SRE3021_CHECK(stats.Completed == 1 && stats.Duplicate == 0 && stats.TimedOut == 0 && stats.Invalid == 0);
+}
+
+SRE3021_TEST(ImageFrameReassemblerDuplicate)
+{
+	SRE3021ImageFrameReassembler reassembler;
+	reassembler.Allocate(4, TEST_FRAGMENT_CAPACITY);
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 3, 2, 0, 100), 0) == SRE3021ImageFrameStatus::INCOMPLETE);
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 3, 2, 0, 100), 1) == SRE3021ImageFrameStatus::DUPLICATE);
+	// Same frame number from another system is a frame of its own
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(2, 3, 2, 0, 100), 2) == SRE3021ImageFrameStatus::INCOMPLETE);
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 3, 2, 1, 100), 3) == SRE3021ImageFrameStatus::COMPLETE);
+
+	const SRE3021ImageFrameStats stats = reassembler.GetStats();
+	SRE3021_CHECK(stats.Completed == 1 && stats.Duplicate == 1);
+}
+
+SRE3021_TEST(ImageFrameReassemblerMissingFragmentTimesOut)
+{
+	SRE3021ImageFrameReassembler reassembler;
+	reassembler.Allocate(1, TEST_FRAGMENT_CAPACITY);
+	reassembler.SetTimeout(1000);
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 1, 3, 0, 100), 0) == SRE3021ImageFrameStatus::INCOMPLETE);
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 1, 3, 2, 100), 10) == SRE3021ImageFrameStatus::INCOMPLETE);
+	// Fragment 1 never comes, the only buffer stays taken until the timeout
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 2, 1, 0, 100), 1000) == SRE3021ImageFrameStatus::NO_FREE_FRAME);
+	SRE3021_CHECK(reassembler.GetStats().TimedOut == 0);
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 2, 1, 0, 100), 1001) == SRE3021ImageFrameStatus::COMPLETE);
+
+	const SRE3021ImageFrameStats stats = reassembler.GetStats();
+	SRE3021_CHECK(stats.TimedOut == 1 && stats.Completed == 1 && stats.NoFreeFrame == 1);
+}
+
+SRE3021_TEST(ImageFrameReassemblerPoolExhaustion)
+{
+	SRE3021ImageFrameReassembler reassembler;
+	reassembler.Allocate(2, TEST_FRAGMENT_CAPACITY);
+	unsigned __int32 frameIndex = 0;
+	unsigned __int32 frameLength = 0;
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 1, 1, 0, 100), 0, frameIndex, frameLength) == SRE3021ImageFrameStatus::COMPLETE);
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 2, 2, 0, 100), 1) == SRE3021ImageFrameStatus::INCOMPLETE);
+	// One frame held by the consumer, one being put together
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 3, 2, 0, 100), 2) == SRE3021ImageFrameStatus::NO_FREE_FRAME);
+	// Fragments of the pending frame still find their buffer
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 2, 2, 1, 100), 3) == SRE3021ImageFrameStatus::COMPLETE);
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 3, 2, 0, 100), 4) == SRE3021ImageFrameStatus::NO_FREE_FRAME);
+	reassembler.Release(frameIndex);
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 3, 2, 0, 100), 5) == SRE3021ImageFrameStatus::INCOMPLETE);
+
+	const SRE3021ImageFrameStats stats = reassembler.GetStats();
+	SRE3021_CHECK(stats.NoFreeFrame == 2 && stats.Completed == 2 && stats.TimedOut == 0);
+}
+
+SRE3021_TEST(ImageFrameReassemblerInvalid)
+{
+	SRE3021ImageFrameReassembler reassembler;
+	reassembler.Allocate(2, TEST_FRAGMENT_CAPACITY);
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 1, 2, 2, 100), 0) == SRE3021ImageFrameStatus::INVALID);
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 1, 0, 0, 100), 0) == SRE3021ImageFrameStatus::INVALID);
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 1, 2, 0, TEST_FRAGMENT_CAPACITY + 1), 0) == SRE3021ImageFrameStatus::INVALID);
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 1, 2, 0, 100), 0) == SRE3021ImageFrameStatus::INCOMPLETE);
+	// Packet count not matching the frame
+	SRE3021_CHECK(AddFragment(reassembler, MakeFragment(1, 1, 3, 1, 100), 0) == SRE3021ImageFrameStatus::INVALID);
+	SRE3021_CHECK(reassembler.GetStats().Invalid == 4);
+}
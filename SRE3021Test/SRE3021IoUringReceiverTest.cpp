@@ -0,0 +1,128 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021Test.h"
+
+#include <cstring>
+
+#include "../Network.h"
+#include "../SRE3021IoUringReceiver.h"
+
+#if SRE3021_HAS_IO_URING
+
+using namespace hurel::sre3021;
+
+#define SRE3021_TEST_IO_URING_PORT (50211)
+
+static long long SteadyClockNanoseconds()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SRE3021_TEST(IoUringReceiverFillsSlots)
+{
+	SRE3021PacketPool pool;
+	pool.Allocate(64);
+	UDPSocket socket;
+	socket.Bind(SRE3021_TEST_IO_URING_PORT);
+	SRE3021IoUringReceiver receiver;
+	if (!receiver.Open(static_cast<int>(socket.GetHandle()), pool))
+	{
+		printf("  io_uring not available, skipped\n");
+		return;
+	}
+	// Arm the recv before anything is sent
+	SRE3021PacketSlot slots[64];
+	SRE3021_CHECK(receiver.Receive(slots, 64, 0) == 0);
+
+	const int datagramCount = 32;
+	const long long sendTime = SteadyClockNanoseconds();
+	UDPSocket sender;
+	char datagram[SRE3021_IMAGE_PACKET_LENGTH];
+	for (int i = 0; i < datagramCount; ++i)
+	{
+		memset(datagram, i, sizeof(datagram));
+		sender.SendTo("127.0.0.1", SRE3021_TEST_IO_URING_PORT, datagram, sizeof(datagram));
+	}
+
+	int receivedCount = 0;
+	for (int attempt = 0; attempt < 100 && receivedCount < datagramCount; ++attempt)
+	{
+		const int count = receiver.Receive(slots, 64, 10);
+		const long long reapTime = SteadyClockNanoseconds();
+		for (int i = 0; i < count; ++i)
+		{
+			SRE3021_CHECK(slots[i].Length == SRE3021_IMAGE_PACKET_LENGTH);
+			SRE3021_CHECK(pool.Data(slots[i].Index)[0] == receivedCount);
+			SRE3021_CHECK(pool.Data(slots[i].Index)[SRE3021_IMAGE_PACKET_LENGTH - 1] == receivedCount);
+			SRE3021_CHECK(slots[i].Timestamp == 0);
+			SRE3021_CHECK(slots[i].ReceiveTime >= sendTime && slots[i].ReceiveTime <= reapTime);
+			receiver.Recycle(slots[i].Index);
+			++receivedCount;
+		}
+	}
+	SRE3021_CHECK(receivedCount == datagramCount);
+
+	receiver.Close();
+	SRE3021_CHECK(!receiver.IsOpen());
+}
+
+SRE3021_TEST(IoUringReceiverClosesWhileRecvIsRunning)
+{
+	SRE3021PacketPool pool;
+	pool.Allocate(64);
+	UDPSocket socket;
+	socket.Bind(SRE3021_TEST_IO_URING_PORT);
+	UDPSocket sender;
+	char datagram[SRE3021_IMAGE_PACKET_LENGTH] = { 0 };
+	SRE3021PacketSlot slots[64];
+	for (int round = 0; round < 3; ++round)
+	{
+		SRE3021IoUringReceiver receiver;
+		if (!receiver.Open(static_cast<int>(socket.GetHandle()), pool))
+		{
+			printf("  io_uring not available, skipped\n");
+			return;
+		}
+		receiver.Receive(slots, 64, 0);
+		sender.SendTo("127.0.0.1", SRE3021_TEST_IO_URING_PORT, datagram, sizeof(datagram));
+		int receivedCount = 0;
+		for (int attempt = 0; attempt < 100 && receivedCount == 0; ++attempt)
+		{
+			receivedCount = receiver.Receive(slots, 64, 10);
+		}
+		SRE3021_CHECK(receivedCount == 1);
+
+		// The multishot recv is still running, Close cancels it and waits for its last completion
+		const auto start = std::chrono::steady_clock::now();
+		receiver.Close();
+		SRE3021_CHECK(test::SecondsSince(start) < 0.5);
+		SRE3021_CHECK(!receiver.IsOpen());
+		// The pool was drained into the closed ring, start the next round with all slots free
+		pool.Allocate(64);
+	}
+}
+
+#endif
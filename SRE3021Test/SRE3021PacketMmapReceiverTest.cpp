@@ -0,0 +1,169 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021Test.h"
+
+#include <cstring>
+
+#include "../Network.h"
+#include "../SRE3021PacketMmapReceiver.h"
+
+#if SRE3021_HAS_PACKET_MMAP
+#include <net/if.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+
+using namespace hurel::sre3021;
+
+#define SRE3021_TEST_PACKET_MMAP_PORT (50212)
+
+static long long SteadyClockNanoseconds()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Receive until expectedCount datagrams arrived or about a second passed, releasing every slot.
+// Payload bytes are all equal, payload[i] collects the first byte of the i-th datagram.
+static int ReceiveAll(SRE3021PacketMmapReceiver& receiver, int expectedCount, long long sendTime, unsigned __int32 expectedLength, unsigned __int8* payload)
+{
+	SRE3021PacketSlot slots[64];
+	int receivedCount = 0;
+	for (int attempt = 0; attempt < 100 && receivedCount < expectedCount; ++attempt)
+	{
+		const int count = receiver.Receive(slots, 64, 10);
+		const long long returnTime = SteadyClockNanoseconds();
+		for (int i = 0; i < count; ++i)
+		{
+			SRE3021_CHECK(slots[i].Length == expectedLength);
+			SRE3021_CHECK(slots[i].Timestamp == 0);
+			SRE3021_CHECK(slots[i].ReceiveTime >= sendTime && slots[i].ReceiveTime <= returnTime);
+			if (receivedCount < expectedCount)
+			{
+				payload[receivedCount] = receiver.Data(slots[i].Index)[0];
+				SRE3021_CHECK(receiver.Data(slots[i].Index)[expectedLength - 1] == payload[receivedCount]);
+			}
+			receiver.Release(slots[i].Index);
+			++receivedCount;
+		}
+	}
+	return receivedCount;
+}
+
+SRE3021_TEST(PacketMmapReceiverFillsSlots)
+{
+	// Bound so loopback does not answer with port unreachable, nothing reads it
+	UDPSocket socket;
+	socket.Bind(SRE3021_TEST_PACKET_MMAP_PORT);
+	SRE3021PacketMmapReceiver receiver;
+	if (!receiver.Open("lo", SRE3021_TEST_PACKET_MMAP_PORT))
+	{
+		printf("  packet socket not available (needs CAP_NET_RAW), skipped\n");
+		return;
+	}
+
+	const int datagramCount = 32;
+	const long long sendTime = SteadyClockNanoseconds();
+	UDPSocket sender;
+	char datagram[SRE3021_IMAGE_PACKET_LENGTH];
+	for (int i = 0; i < datagramCount; ++i)
+	{
+		memset(datagram, i, sizeof(datagram));
+		sender.SendTo("127.0.0.1", SRE3021_TEST_PACKET_MMAP_PORT, datagram, sizeof(datagram));
+	}
+	// Datagrams to other ports are filtered out
+	sender.SendTo("127.0.0.1", SRE3021_TEST_PACKET_MMAP_PORT + 1, datagram, sizeof(datagram));
+
+	unsigned __int8 payload[64];
+	// The outgoing copy of each datagram is skipped, each one is received once
+	SRE3021_CHECK(ReceiveAll(receiver, datagramCount + 1, sendTime, SRE3021_IMAGE_PACKET_LENGTH, payload) == datagramCount);
+	for (int i = 0; i < datagramCount; ++i)
+	{
+		SRE3021_CHECK(payload[i] == i);
+	}
+	receiver.Close();
+	SRE3021_CHECK(!receiver.IsOpen());
+}
+
+SRE3021_TEST(PacketMmapReceiverGetsVlanTaggedFramesUntagged)
+{
+	UDPSocket socket;
+	socket.Bind(SRE3021_TEST_PACKET_MMAP_PORT);
+	SRE3021PacketMmapReceiver receiver;
+	const int injector = ::socket(AF_PACKET, SOCK_RAW, 0);
+	if (injector < 0 || !receiver.Open("lo", SRE3021_TEST_PACKET_MMAP_PORT))
+	{
+		printf("  packet socket not available (needs CAP_NET_RAW), skipped\n");
+		if (injector >= 0)
+		{
+			close(injector);
+		}
+		return;
+	}
+
+	// Ethernet with an 802.1Q tag for VLAN 5, IPv4 127.0.0.1 to 127.0.0.1, UDP to the port
+	const unsigned __int32 payloadLength = SRE3021_IMAGE_PACKET_LENGTH;
+	unsigned __int8 frame[18 + 20 + 8 + SRE3021_IMAGE_PACKET_LENGTH] = { 0 };
+	unsigned __int8* ethernet = frame;
+	ethernet[12] = 0x81; ethernet[13] = 0x00;
+	ethernet[14] = 0x00; ethernet[15] = 0x05;
+	ethernet[16] = 0x08; ethernet[17] = 0x00;
+	unsigned __int8* ip = frame + 18;
+	const unsigned __int16 ipLength = static_cast<unsigned __int16>(20 + 8 + payloadLength);
+	ip[0] = 0x45;
+	ip[2] = static_cast<unsigned __int8>(ipLength >> 8); ip[3] = static_cast<unsigned __int8>(ipLength);
+	ip[6] = 0x40;
+	ip[8] = 64;
+	ip[9] = 17;
+	ip[12] = 127; ip[15] = 1;
+	ip[16] = 127; ip[19] = 1;
+	unsigned int checksum = 0;
+	for (int i = 0; i < 20; i += 2)
+	{
+		checksum += static_cast<unsigned int>(ip[i] << 8 | ip[i + 1]);
+	}
+	checksum = (checksum & 0xFFFF) + (checksum >> 16);
+	checksum = ~checksum & 0xFFFF;
+	ip[10] = static_cast<unsigned __int8>(checksum >> 8); ip[11] = static_cast<unsigned __int8>(checksum);
+	unsigned __int8* udp = ip + 20;
+	udp[0] = 0x30; udp[1] = 0x39;
+	udp[2] = static_cast<unsigned __int8>(SRE3021_TEST_PACKET_MMAP_PORT >> 8); udp[3] = static_cast<unsigned __int8>(SRE3021_TEST_PACKET_MMAP_PORT & 0xFF);
+	udp[4] = static_cast<unsigned __int8>((8 + payloadLength) >> 8); udp[5] = static_cast<unsigned __int8>(8 + payloadLength);
+	memset(udp + 8, 0x5A, payloadLength);
+
+	sockaddr_ll address;
+	memset(&address, 0, sizeof(address));
+	address.sll_family = AF_PACKET;
+	address.sll_ifindex = static_cast<int>(if_nametoindex("lo"));
+	address.sll_halen = ETH_ALEN;
+	const long long sendTime = SteadyClockNanoseconds();
+	SRE3021_CHECK(sendto(injector, frame, sizeof(frame), 0, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == static_cast<ssize_t>(sizeof(frame)));
+	close(injector);
+
+	unsigned __int8 payload[2] = { 0 };
+	SRE3021_CHECK(ReceiveAll(receiver, 2, sendTime, payloadLength, payload) == 1);
+	SRE3021_CHECK(payload[0] == 0x5A);
+}
+
+#endif
@@ -0,0 +1,286 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021Test.h"
+#include "SRE3021TestPackets.h"
+
+#include "../SRE3021PulseHeightDecoder.h"
+
+using namespace hurel::sre3021;
+using namespace hurel::sre3021::test;
+
+#define SRE3021_TEST_MAX_DATA_LENGTH (0xFFFF)
+
+static void WriteBigEndian16(unsigned __int8* data, unsigned int value)
+{
+	data[0] = static_cast<unsigned __int8>(value >> 8 & 0xFF);
+	data[1] = static_cast<unsigned __int8>(value & 0xFF);
+}
+
+static void WriteBigEndian32(unsigned __int8* data, unsigned __int32 value)
+{
+	WriteBigEndian16(data, value >> 16);
+	WriteBigEndian16(data + 2, value & 0xFFFF);
+}
+
+// Sample j of event i of MakeMultiPulseHeightPacket
+static SRE3021PulseHeightSample MultiPulseHeightTestSample(int i, int j)
+{
+	return SRE3021PulseHeightSample{ i % 2 == 0 ? SRE3021TriggerType::ASIC_TRIGGER : SRE3021TriggerType::SYSTEM_AUTO_FORCED_READOUT,
+		static_cast<unsigned __int8>(i), static_cast<unsigned __int16>(j), static_cast<unsigned __int16>(i * 256 + j) };
+}
+
+// Multi-event pulse-height packet, header included. Event i has time stamp 0x01000000 + i, and its samples start at
+// 3 + 4 * (i + 1) + 6 * sampleCount * i bytes into Packet Data. dataLength may be shorter than the events to truncate the packet.
+static std::vector<unsigned __int8> MakeMultiPulseHeightPacket(int eventCount, int sampleCount, int dataLength)
+{
+	const size_t eventLength = SRE3021_MULTI_PULSE_HEIGHT_EVENT_LENGTH + static_cast<size_t>(sampleCount) * SRE3021_MULTI_PULSE_HEIGHT_SAMPLE_LENGTH;
+	std::vector<unsigned __int8> packet(SRE3021_PACKET_HEADER_LENGTH + SRE3021_MULTI_PULSE_HEIGHT_FIELDS_LENGTH + eventCount * eventLength);
+	WriteTestHeader(&packet[0], SRE3021PacketType::MULTI_PULSE_HEIGHT_DATA, 0, dataLength);
+	unsigned __int8* data = &packet[SRE3021_PACKET_HEADER_LENGTH];
+	data[0] = static_cast<unsigned __int8>(eventCount);
+	WriteBigEndian16(data + 1, sampleCount);
+	for (int i = 0; i < eventCount; ++i)
+	{
+		unsigned __int8* eventData = data + SRE3021_MULTI_PULSE_HEIGHT_FIELDS_LENGTH + i * eventLength;
+		WriteBigEndian32(eventData, 0x01000000 + i);
+		for (int j = 0; j < sampleCount; ++j)
+		{
+			const SRE3021PulseHeightSample sample = MultiPulseHeightTestSample(i, j);
+			unsigned __int8* sampleData = eventData + SRE3021_MULTI_PULSE_HEIGHT_EVENT_LENGTH + j * SRE3021_MULTI_PULSE_HEIGHT_SAMPLE_LENGTH;
+			sampleData[0] = static_cast<unsigned __int8>(sample.TriggerType);
+			sampleData[1] = sample.SourceId;
+			WriteBigEndian16(sampleData + 2, sample.ChannelId);
+			WriteBigEndian16(sampleData + 4, sample.Sample);
+		}
+	}
+	return packet;
+}
+
+static SRE3021PacketDecodeStatus DecodeMultiPulseHeightPacket(const std::vector<unsigned __int8>& packet, SRE3021MultiPulseHeightData& outData, SRE3021DecodeArena& arena)
+{
+	arena.Reset();
+	return SRE3021PulseHeightDecoder::DecodeMultiPulseHeight(&packet[SRE3021_PACKET_HEADER_LENGTH], SRE3021HeaderCodec::DecodeDataLength(&packet[0]), outData, arena);
+}
+
+static bool IsMultiPulseHeightTestData(const SRE3021MultiPulseHeightData& data, int eventCount, int sampleCount)
+{
+	if (data.EventCount != eventCount || data.SampleCount != sampleCount || data.Events == nullptr)
+	{
+		return false;
+	}
+	for (int i = 0; i < eventCount; ++i)
+	{
+		if (data.Events[i].Timestamp != static_cast<unsigned __int32>(0x01000000 + i))
+		{
+			return false;
+		}
+		for (int j = 0; j < sampleCount; ++j)
+		{
+			const SRE3021PulseHeightSample expected = MultiPulseHeightTestSample(i, j);
+			const SRE3021PulseHeightSample& sample = data.Events[i].Samples[j];
+			if (sample.TriggerType != expected.TriggerType || sample.SourceId != expected.SourceId
+				|| sample.ChannelId != expected.ChannelId || sample.Sample != expected.Sample)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static int MultiPulseHeightDataLength(int eventCount, int sampleCount)
+{
+	return SRE3021_MULTI_PULSE_HEIGHT_FIELDS_LENGTH + eventCount * (SRE3021_MULTI_PULSE_HEIGHT_EVENT_LENGTH + sampleCount * SRE3021_MULTI_PULSE_HEIGHT_SAMPLE_LENGTH);
+}
+
+SRE3021_TEST(MultiPulseHeightEventOffsets)
+{
+	// 2 events of 2 samples written out by hand: time stamps at bytes 3 and 19, samples at 7, 13 and 23, 29
+	const unsigned __int8 data[] = {
+		0x02, 0x00, 0x02,
+		0x12, 0x34, 0x56, 0x78,
+		0x02, 0x01, 0x00, 0x05, 0x0A, 0xBC,
+		0x00, 0x01, 0x00, 0x7F, 0x00, 0x01,
+		0x89, 0xAB, 0xCD, 0xEF,
+		0x03, 0x02, 0x01, 0x00, 0xFF, 0xFF,
+		0x06, 0x02, 0x00, 0x00, 0x00, 0x00 };
+	unsigned __int8 packet[SRE3021_PACKET_HEADER_LENGTH + sizeof(data)];
+	WriteTestHeader(packet, SRE3021PacketType::MULTI_PULSE_HEIGHT_DATA, 0, static_cast<int>(sizeof(data)));
+	memcpy(packet + SRE3021_PACKET_HEADER_LENGTH, data, sizeof(data));
+	SRE3021_CHECK(MultiPulseHeightDataLength(2, 2) == static_cast<int>(sizeof(data)));
+
+	SRE3021MultiPulseHeightData decoded;
+	SRE3021PulseHeightEvent events[2];
+	SRE3021PulseHeightSample samples[4];
+	SRE3021_CHECK(SRE3021PulseHeightDecoder::DecodeMultiPulseHeight(packet + SRE3021_PACKET_HEADER_LENGTH, SRE3021HeaderCodec::DecodeDataLength(packet),
+		decoded, events, 2, samples, 4) == SRE3021PacketDecodeStatus::SUCCESS);
+	SRE3021_CHECK(decoded.EventCount == 2 && decoded.SampleCount == 2 && decoded.Events == events);
+	SRE3021_CHECK(events[0].Timestamp == 0x12345678 && events[1].Timestamp == 0x89ABCDEF);
+	SRE3021_CHECK(events[0].Samples == samples && events[1].Samples == samples + 2);
+	SRE3021_CHECK(samples[0].TriggerType == SRE3021TriggerType::ASIC_TRIGGER && samples[0].SourceId == 1 && samples[0].ChannelId == 5 && samples[0].Sample == 0x0ABC);
+	SRE3021_CHECK(samples[1].TriggerType == SRE3021TriggerType::SYSTEM_AUTO_FORCED_READOUT && samples[1].ChannelId == 0x7F && samples[1].Sample == 1);
+	SRE3021_CHECK(samples[2].TriggerType == SRE3021TriggerType::CALIBRATION_TRIGGER && samples[2].SourceId == 2 && samples[2].ChannelId == 0x0100 && samples[2].Sample == 0xFFFF);
+	SRE3021_CHECK(samples[3].TriggerType == SRE3021TriggerType::XA_MULTI_HIT_TRIGGER && samples[3].ChannelId == 0 && samples[3].Sample == 0);
+
+	// Events of several sample counts, each starting 4 + 6 * SampleCount bytes after the previous one
+	SRE3021DecodeArena arena(1 << 20);
+	const int eventCounts[] = { 1, 3, 17 };
+	const int sampleCounts[] = { 1, 2, 11, 128 };
+	for (int eventCount : eventCounts)
+	{
+		for (int sampleCount : sampleCounts)
+		{
+			const std::vector<unsigned __int8> testPacket = MakeMultiPulseHeightPacket(eventCount, sampleCount, MultiPulseHeightDataLength(eventCount, sampleCount));
+			SRE3021_CHECK(DecodeMultiPulseHeightPacket(testPacket, decoded, arena) == SRE3021PacketDecodeStatus::SUCCESS);
+			SRE3021_CHECK(IsMultiPulseHeightTestData(decoded, eventCount, sampleCount));
+		}
+	}
+}
+
+SRE3021_TEST(MultiPulseHeightMaximumCounts)
+{
+	SRE3021DecodeArena arena(1 << 20);
+	SRE3021MultiPulseHeightData decoded;
+
+	// 255 events, the most the 1 byte count holds, with as many samples as fit in a 16 bit DataLength
+	const int maxSamplesOfMaxEvents = ((SRE3021_TEST_MAX_DATA_LENGTH - SRE3021_MULTI_PULSE_HEIGHT_FIELDS_LENGTH) / 255 - SRE3021_MULTI_PULSE_HEIGHT_EVENT_LENGTH) / SRE3021_MULTI_PULSE_HEIGHT_SAMPLE_LENGTH;
+	std::vector<unsigned __int8> packet = MakeMultiPulseHeightPacket(255, maxSamplesOfMaxEvents, MultiPulseHeightDataLength(255, maxSamplesOfMaxEvents));
+	SRE3021_CHECK(DecodeMultiPulseHeightPacket(packet, decoded, arena) == SRE3021PacketDecodeStatus::SUCCESS);
+	SRE3021_CHECK(IsMultiPulseHeightTestData(decoded, 255, maxSamplesOfMaxEvents));
+
+	// One event with every sample a 16 bit DataLength can hold
+	const int maxSamples = (SRE3021_TEST_MAX_DATA_LENGTH - SRE3021_MULTI_PULSE_HEIGHT_FIELDS_LENGTH - SRE3021_MULTI_PULSE_HEIGHT_EVENT_LENGTH) / SRE3021_MULTI_PULSE_HEIGHT_SAMPLE_LENGTH;
+	packet = MakeMultiPulseHeightPacket(1, maxSamples, SRE3021_TEST_MAX_DATA_LENGTH);
+	SRE3021_CHECK(DecodeMultiPulseHeightPacket(packet, decoded, arena) == SRE3021PacketDecodeStatus::SUCCESS);
+	SRE3021_CHECK(IsMultiPulseHeightTestData(decoded, 1, maxSamples));
+
+	// Storage for one sample less than needed
+	std::vector<SRE3021PulseHeightSample> samples(maxSamples - 1);
+	SRE3021PulseHeightEvent event;
+	SRE3021_CHECK(SRE3021PulseHeightDecoder::DecodeMultiPulseHeight(&packet[SRE3021_PACKET_HEADER_LENGTH], SRE3021_TEST_MAX_DATA_LENGTH, decoded,
+		&event, 1, samples.data(), samples.size()) == SRE3021PacketDecodeStatus::ERROR_CAPACITY);
+	SRE3021_CHECK(decoded.EventCount == 1 && decoded.SampleCount == maxSamples);
+
+	// Largest counts the fields hold claim more than the packet has
+	packet = MakeMultiPulseHeightPacket(1, 1, SRE3021_TEST_MAX_DATA_LENGTH);
+	packet.resize(SRE3021_PACKET_HEADER_LENGTH + SRE3021_TEST_MAX_DATA_LENGTH);
+	packet[SRE3021_PACKET_HEADER_LENGTH] = 0xFF;
+	WriteBigEndian16(&packet[SRE3021_PACKET_HEADER_LENGTH + 1], 0xFFFF);
+	SRE3021_CHECK(DecodeMultiPulseHeightPacket(packet, decoded, arena) == SRE3021PacketDecodeStatus::ERROR_DATA_LENGTH);
+	SRE3021_CHECK(decoded.EventCount == 0 && decoded.Events == nullptr);
+}
+
+SRE3021_TEST(MultiPulseHeightTruncated)
+{
+	SRE3021DecodeArena arena(1 << 16);
+	SRE3021MultiPulseHeightData decoded;
+	const int dataLength = MultiPulseHeightDataLength(3, 4);
+	const int truncatedLengths[] = { dataLength - 1, dataLength - SRE3021_MULTI_PULSE_HEIGHT_SAMPLE_LENGTH, SRE3021_MULTI_PULSE_HEIGHT_MIN_LENGTH - 1, 0 };
+	for (int truncatedLength : truncatedLengths)
+	{
+		const std::vector<unsigned __int8> packet = MakeMultiPulseHeightPacket(3, 4, truncatedLength);
+		SRE3021_CHECK(DecodeMultiPulseHeightPacket(packet, decoded, arena) == SRE3021PacketDecodeStatus::ERROR_DATA_LENGTH);
+		SRE3021_CHECK(decoded.EventCount == 0 && decoded.Events == nullptr);
+		SRE3021_CHECK(arena.GetUsed() == 0);
+	}
+
+	// Zero events or zero samples are malformed
+	SRE3021_CHECK(DecodeMultiPulseHeightPacket(MakeMultiPulseHeightPacket(0, 4, SRE3021_MULTI_PULSE_HEIGHT_MIN_LENGTH), decoded, arena) == SRE3021PacketDecodeStatus::ERROR_DATA_LENGTH);
+	std::vector<unsigned __int8> packet = MakeMultiPulseHeightPacket(2, 1, MultiPulseHeightDataLength(2, 1));
+	WriteBigEndian16(&packet[SRE3021_PACKET_HEADER_LENGTH + 1], 0);
+	SRE3021_CHECK(DecodeMultiPulseHeightPacket(packet, decoded, arena) == SRE3021PacketDecodeStatus::ERROR_DATA_LENGTH);
+
+	// Trailing padding after the events is ignored
+	packet = MakeMultiPulseHeightPacket(3, 4, dataLength + 5);
+	packet.resize(packet.size() + 5);
+	SRE3021_CHECK(DecodeMultiPulseHeightPacket(packet, decoded, arena) == SRE3021PacketDecodeStatus::SUCCESS);
+	SRE3021_CHECK(IsMultiPulseHeightTestData(decoded, 3, 4));
+}
+
+// Trigger time packet, header included, with records of time stamp 0x02000000 + i, source i % 4 and channel i % 128
+static std::vector<unsigned __int8> MakeTriggerTimePacket(int eventCount, int dataLength)
+{
+	std::vector<unsigned __int8> packet(SRE3021_PACKET_HEADER_LENGTH + eventCount * SRE3021_TRIGGER_TIME_EVENT_LENGTH);
+	WriteTestHeader(&packet[0], SRE3021PacketType::TRIGGER_TIME_DATA, 0, dataLength);
+	for (int i = 0; i < eventCount; ++i)
+	{
+		unsigned __int8* eventData = &packet[SRE3021_PACKET_HEADER_LENGTH + i * SRE3021_TRIGGER_TIME_EVENT_LENGTH];
+		WriteBigEndian32(eventData, 0x02000000 + i);
+		eventData[4] = static_cast<unsigned __int8>(i % 4);
+		eventData[5] = static_cast<unsigned __int8>(i % 128);
+	}
+	return packet;
+}
+
+static bool IsTriggerTimeTestData(const SRE3021TriggerTimeData& data, int eventCount)
+{
+	if (data.EventCount != eventCount || data.Events == nullptr)
+	{
+		return false;
+	}
+	for (int i = 0; i < eventCount; ++i)
+	{
+		if (data.Events[i].Timestamp != static_cast<unsigned __int32>(0x02000000 + i) || data.Events[i].SourceId != i % 4 || data.Events[i].ChannelId != i % 128)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+SRE3021_TEST(TriggerTimeDecode)
+{
+	SRE3021DecodeArena arena(1 << 20);
+	SRE3021TriggerTimeData decoded;
+
+	// Event i at byte 6 * i
+	const unsigned __int8 data[] = { 0x00, 0x00, 0x01, 0x00, 0x03, 0x40, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x7F };
+	SRE3021TriggerTimeEvent events[2];
+	SRE3021_CHECK(SRE3021PulseHeightDecoder::DecodeTriggerTime(data, static_cast<int>(sizeof(data)), decoded, events, 2) == SRE3021PacketDecodeStatus::SUCCESS);
+	SRE3021_CHECK(decoded.EventCount == 2 && decoded.Events == events);
+	SRE3021_CHECK(events[0].Timestamp == 0x100 && events[0].SourceId == 3 && events[0].ChannelId == 0x40);
+	SRE3021_CHECK(events[1].Timestamp == 0xFFFFFFFF && events[1].SourceId == 0 && events[1].ChannelId == 0x7F);
+	SRE3021_CHECK(SRE3021PulseHeightDecoder::DecodeTriggerTime(data, static_cast<int>(sizeof(data)), decoded, events, 1) == SRE3021PacketDecodeStatus::ERROR_CAPACITY);
+	SRE3021_CHECK(decoded.EventCount == 2);
+
+	// As many records as fit in a 16 bit DataLength
+	const int maxEvents = SRE3021_TEST_MAX_DATA_LENGTH / SRE3021_TRIGGER_TIME_EVENT_LENGTH;
+	std::vector<unsigned __int8> packet = MakeTriggerTimePacket(maxEvents, maxEvents * SRE3021_TRIGGER_TIME_EVENT_LENGTH);
+	SRE3021_CHECK(SRE3021PulseHeightDecoder::DecodeTriggerTime(&packet[SRE3021_PACKET_HEADER_LENGTH], SRE3021HeaderCodec::DecodeDataLength(&packet[0]),
+		decoded, arena) == SRE3021PacketDecodeStatus::SUCCESS);
+	SRE3021_CHECK(IsTriggerTimeTestData(decoded, maxEvents));
+
+	// A record cut short, and no record at all
+	const int truncatedLengths[] = { 5 * SRE3021_TRIGGER_TIME_EVENT_LENGTH - 1, SRE3021_TRIGGER_TIME_EVENT_LENGTH - 1, 0 };
+	for (int truncatedLength : truncatedLengths)
+	{
+		packet = MakeTriggerTimePacket(5, truncatedLength);
+		arena.Reset();
+		SRE3021_CHECK(SRE3021PulseHeightDecoder::DecodeTriggerTime(&packet[SRE3021_PACKET_HEADER_LENGTH], SRE3021HeaderCodec::DecodeDataLength(&packet[0]),
+			decoded, arena) == SRE3021PacketDecodeStatus::ERROR_DATA_LENGTH);
+		SRE3021_CHECK(decoded.EventCount == 0 && decoded.Events == nullptr);
+	}
+}
@@ -0,0 +1,146 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+#include "SRE3021Test.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../SRE3021ReorderBuffer.h"
+
+using namespace hurel::sre3021;
+
+#define SRE3021_TEST_REORDER_THREAD_COUNT (4)
+#define SRE3021_TEST_REORDER_TICKET_COUNT (200000)
+// Every seventh ticket is published as skipped
+#define SRE3021_TEST_REORDER_SKIP_PERIOD (7)
+
+SRE3021_TEST(ReorderBufferDeliversInTicketOrder)
+{
+	SRE3021ReorderBuffer<int> buffer;
+	buffer.Resize(3);
+	SRE3021_CHECK(buffer.Capacity() == 4);
+	SRE3021_CHECK(buffer.WindowEnd() == 4);
+	SRE3021_CHECK(buffer.SlotIndex(5) == 1);
+
+	std::vector<int> delivered;
+	auto deliver = [&delivered](int value) { delivered.push_back(value); };
+	buffer.Slot(2) = 2;
+	buffer.Publish(2);
+	buffer.Publish(1, true);
+	// Ticket 0 holds everything back
+	SRE3021_CHECK(buffer.Drain(deliver) == 0);
+	SRE3021_CHECK(delivered.empty());
+	SRE3021_CHECK(buffer.WindowEnd() == 4);
+
+	buffer.Slot(0) = 0;
+	buffer.Publish(0);
+	SRE3021_CHECK(buffer.Drain(deliver) == 2);
+	SRE3021_CHECK(delivered.size() == 2 && delivered[0] == 0 && delivered[1] == 2);
+	SRE3021_CHECK(buffer.WindowEnd() == 7);
+	SRE3021_CHECK(buffer.InWindow(6) && !buffer.InWindow(7));
+
+	// Slots are reused once the window moved past them
+	buffer.Slot(4) = 4;
+	buffer.Publish(4);
+	buffer.Slot(3) = 3;
+	buffer.Publish(3);
+	int flushCount = 0;
+	SRE3021_CHECK(buffer.Drain(deliver, [&flushCount] { ++flushCount; }) == 2);
+	SRE3021_CHECK(delivered.size() == 4 && delivered[2] == 3 && delivered[3] == 4);
+	SRE3021_CHECK(flushCount == 1);
+	// Nothing delivered, nothing flushed
+	SRE3021_CHECK(buffer.Drain(deliver, [&flushCount] { ++flushCount; }) == 0);
+	SRE3021_CHECK(flushCount == 1);
+}
+
+SRE3021_TEST(ReorderBufferConcurrentPublishAndDrain)
+{
+	SRE3021ReorderBuffer<size_t> buffer;
+	buffer.Resize(64);
+	std::atomic<size_t> nextTicket(0);
+	std::atomic<int> deliveringCount(0);
+	std::atomic<size_t> drainedCount(0);
+	bool isConcurrent = false;
+	std::vector<size_t> delivered;
+	delivered.reserve(SRE3021_TEST_REORDER_TICKET_COUNT);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < SRE3021_TEST_REORDER_THREAD_COUNT; ++t)
+	{
+		threads.push_back(std::thread([&]()
+		{
+			while (true)
+			{
+				const size_t ticket = nextTicket.fetch_add(1);
+				if (ticket >= SRE3021_TEST_REORDER_TICKET_COUNT)
+				{
+					break;
+				}
+				// Like a decode worker, wait until the ticket is in the window
+				while (!buffer.InWindow(ticket))
+				{
+					std::this_thread::yield();
+				}
+				const bool isSkipped = ticket % SRE3021_TEST_REORDER_SKIP_PERIOD == 0;
+				if (!isSkipped)
+				{
+					buffer.Slot(ticket) = ticket;
+				}
+				buffer.Publish(ticket, isSkipped);
+				drainedCount.fetch_add(buffer.Drain([&](size_t value)
+				{
+					// The deliver function never runs on two threads at once, so the vector needs no lock
+					isConcurrent = isConcurrent || deliveringCount.fetch_add(1) != 0;
+					delivered.push_back(value);
+					deliveringCount.fetch_sub(1);
+				}));
+			}
+		}));
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	// Without another Drain: a ticket published while a thread held the delivery role must not have been left behind
+	size_t wrongCount = 0;
+	size_t expectedTicket = 0;
+	for (size_t value : delivered)
+	{
+		if (expectedTicket % SRE3021_TEST_REORDER_SKIP_PERIOD == 0)
+		{
+			++expectedTicket;
+		}
+		wrongCount += value != expectedTicket;
+		++expectedTicket;
+	}
+	const size_t expectedCount = SRE3021_TEST_REORDER_TICKET_COUNT - (SRE3021_TEST_REORDER_TICKET_COUNT + SRE3021_TEST_REORDER_SKIP_PERIOD - 1) / SRE3021_TEST_REORDER_SKIP_PERIOD;
+	SRE3021_CHECK(!isConcurrent);
+	SRE3021_CHECK(wrongCount == 0);
+	SRE3021_CHECK(delivered.size() == expectedCount);
+	SRE3021_CHECK(drainedCount.load() == expectedCount);
+	SRE3021_CHECK(buffer.Drain([](size_t) {}) == 0);
+}
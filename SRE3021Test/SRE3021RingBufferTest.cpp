@@ -0,0 +1,182 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021Test.h"
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "../SRE3021RingBuffer.h"
+#include "../SRE3021MPMCRingBuffer.h"
+#include "../SRE3021PacketPool.h"
+
+using namespace hurel::sre3021;
+
+#define SRE3021_TEST_RING_THREAD_COUNT (4)
+#define SRE3021_TEST_RING_ITEMS_PER_PRODUCER (50000)
+
+SRE3021_TEST(RingBufferKeepsOrder)
+{
+	SRE3021RingBuffer<int> ring(5);
+	SRE3021_CHECK(ring.Capacity() == 8);
+	for (int i = 0; i < 8; ++i)
+	{
+		SRE3021_CHECK(ring.TryPush(i));
+	}
+	SRE3021_CHECK(ring.Full());
+	SRE3021_CHECK(!ring.TryPush(8));
+	int item;
+	for (int i = 0; i < 8; ++i)
+	{
+		SRE3021_CHECK(ring.TryPop(item) && item == i);
+	}
+	SRE3021_CHECK(ring.Empty());
+	SRE3021_CHECK(!ring.TryPop(item));
+}
+
+SRE3021_TEST(MPMCRingBufferTicketLimit)
+{
+	SRE3021MPMCRingBuffer<int> ring(4);
+	for (int i = 0; i < 4; ++i)
+	{
+		SRE3021_CHECK(ring.TryPush(100 + i));
+	}
+	SRE3021_CHECK(ring.Full());
+	SRE3021_CHECK(!ring.TryPush(104));
+	SRE3021_CHECK(ring.PushFailCount() == 1);
+
+	int item;
+	size_t ticket;
+	SRE3021_CHECK(ring.TryPop(item, ticket, 2) && item == 100 && ticket == 0);
+	SRE3021_CHECK(ring.TryPop(item, ticket, 2) && item == 101 && ticket == 1);
+	// Ticket 2 is at the limit and stays queued
+	SRE3021_CHECK(!ring.TryPop(item, ticket, 2));
+	SRE3021_CHECK(ring.Size() == 2);
+
+	// Room freed by a pop is reused at once, tickets keep counting in push order
+	SRE3021_CHECK(ring.TryPush(104));
+	SRE3021_CHECK(ring.TryPop(item, ticket, 10) && item == 102 && ticket == 2);
+	SRE3021_CHECK(ring.TryPop(item) && item == 103);
+	SRE3021_CHECK(ring.TryPop(item, ticket, 10) && item == 104 && ticket == 4);
+	SRE3021_CHECK(ring.Empty());
+	SRE3021_CHECK(ring.HighWaterMark() == 4);
+}
+
+SRE3021_TEST(MPMCRingBufferDeliversEveryItemOnce)
+{
+	SRE3021MPMCRingBuffer<unsigned __int32> ring(64);
+	const unsigned __int32 totalCount = SRE3021_TEST_RING_THREAD_COUNT * SRE3021_TEST_RING_ITEMS_PER_PRODUCER;
+	std::vector<std::atomic<int>> seenCounts(totalCount);
+	for (auto& seenCount : seenCounts)
+	{
+		seenCount.store(0);
+	}
+	std::atomic<unsigned __int32> poppedCount{ 0 };
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < SRE3021_TEST_RING_THREAD_COUNT; ++t)
+	{
+		threads.emplace_back([&ring, t] {
+			for (unsigned __int32 i = 0; i < SRE3021_TEST_RING_ITEMS_PER_PRODUCER; ++i)
+			{
+				const unsigned __int32 item = t * SRE3021_TEST_RING_ITEMS_PER_PRODUCER + i;
+				while (!ring.TryPush(item))
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+		threads.emplace_back([&ring, &seenCounts, &poppedCount, totalCount] {
+			unsigned __int32 item;
+			while (poppedCount.load() < totalCount)
+			{
+				if (ring.TryPop(item))
+				{
+					seenCounts[item].fetch_add(1);
+					poppedCount.fetch_add(1);
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	SRE3021_CHECK(poppedCount.load() == totalCount);
+	SRE3021_CHECK(ring.Empty());
+	int wrongCount = 0;
+	for (auto& seenCount : seenCounts)
+	{
+		wrongCount += seenCount.load() != 1;
+	}
+	SRE3021_CHECK(wrongCount == 0);
+}
+
+SRE3021_TEST(PacketPoolReleaseFromSeveralThreads)
+{
+	const unsigned __int32 slotCount = 1024;
+	SRE3021PacketPool pool;
+	pool.Allocate(slotCount);
+	std::vector<unsigned __int32> acquired(slotCount);
+	for (auto& index : acquired)
+	{
+		SRE3021_CHECK(pool.TryAcquire(index));
+	}
+	unsigned __int32 index;
+	SRE3021_CHECK(!pool.TryAcquire(index));
+	SRE3021_CHECK(pool.GetFreeSlotCount() == 0);
+
+	// Every decode worker releases the slots it finished
+	std::vector<std::thread> threads;
+	for (int t = 0; t < SRE3021_TEST_RING_THREAD_COUNT; ++t)
+	{
+		threads.emplace_back([&pool, &acquired, t, slotCount] {
+			for (unsigned __int32 i = t; i < slotCount; i += SRE3021_TEST_RING_THREAD_COUNT)
+			{
+				pool.Release(acquired[i]);
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	SRE3021_CHECK(pool.GetFreeSlotCount() == slotCount);
+	std::set<unsigned __int32> reacquired;
+	while (pool.TryAcquire(index))
+	{
+		reacquired.insert(index);
+	}
+	SRE3021_CHECK(reacquired.size() == slotCount);
+	SRE3021_CHECK(*reacquired.rbegin() == slotCount - 1);
+}
@@ -0,0 +1,151 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+#include "SRE3021Test.h"
+
+#include <atomic>
+#include <thread>
+
+#include "../SRE3021SequenceTracker.h"
+
+using namespace hurel::sre3021;
+using namespace hurel::sre3021::test;
+
+static bool IsSameStats(const SRE3021SequenceStats& stats, size_t received, size_t lost, size_t duplicate, size_t reordered, size_t outOfWindow)
+{
+	return stats.Received == received && stats.Lost == lost && stats.Duplicate == duplicate && stats.Reordered == reordered && stats.OutOfWindow == outOfWindow;
+}
+
+SRE3021_TEST(SequenceTrackerInOrder)
+{
+	SRE3021SequenceTracker tracker;
+	for (int i = 0; i < 1000; ++i)
+	{
+		tracker.Track(0, i);
+	}
+	SRE3021_CHECK(IsSameStats(tracker.GetStats(0), 1000, 0, 0, 0, 0));
+	SRE3021_CHECK(tracker.GetLossEvents().empty());
+}
+
+SRE3021_TEST(SequenceTrackerReorderWindow)
+{
+	SRE3021SequenceTracker tracker;
+	tracker.Track(0, 0);
+	tracker.Track(0, 1);
+	tracker.Track(0, 5);
+	// 2, 3 and 4 are missing but still in the window, nothing is lost yet
+	SRE3021_CHECK(IsSameStats(tracker.GetStats(0), 3, 0, 0, 0, 0));
+	tracker.Track(0, 3);
+	SRE3021_CHECK(IsSameStats(tracker.GetStats(0), 4, 0, 0, 1, 0));
+	tracker.Track(0, 3);
+	tracker.Track(0, 5);
+	SRE3021_CHECK(IsSameStats(tracker.GetStats(0), 6, 0, 2, 1, 0));
+
+	// Moving the window just past 2 loses it, 4 is still in the window
+	tracker.Track(0, 5 + SRE3021_SEQUENCE_REORDER_WINDOW - 3);
+	SRE3021_CHECK(IsSameStats(tracker.GetStats(0), 7, 1, 2, 1, 0));
+	tracker.Track(0, 4);
+	SRE3021_CHECK(IsSameStats(tracker.GetStats(0), 8, 1, 2, 2, 0));
+	// 2 arrives after it was counted as lost
+	tracker.Track(0, 2);
+	SRE3021_CHECK(IsSameStats(tracker.GetStats(0), 9, 1, 2, 2, 1));
+
+	const std::vector<SRE3021SequenceLossEvent> events = tracker.GetLossEvents();
+	SRE3021_CHECK(events.size() == 2);
+	SRE3021_CHECK(events[0].SystemNumber == 0 && events[0].ExpectedPacketCount == 2 && events[0].ReceivedPacketCount == 5 && events[0].GapLength == 3);
+}
+
+SRE3021_TEST(SequenceTrackerLongGap)
+{
+	SRE3021SequenceTracker tracker;
+	tracker.Track(3, 10);
+	tracker.Track(3, 12);
+	// A jump beyond the window loses 11 and the part of the gap that never enters the window
+	tracker.Track(3, 12 + 1000);
+	const size_t lostCount = 1 + 1000 - SRE3021_SEQUENCE_REORDER_WINDOW;
+	SRE3021_CHECK(IsSameStats(tracker.GetStats(3), 3, lostCount, 0, 0, 0));
+	// Packets of the gap that are still in the window were never seen, they arrive reordered
+	tracker.Track(3, 12 + 999);
+	SRE3021_CHECK(IsSameStats(tracker.GetStats(3), 4, lostCount, 0, 1, 0));
+	tracker.Track(3, 12);
+	SRE3021_CHECK(IsSameStats(tracker.GetStats(3), 5, lostCount, 0, 1, 1));
+	// Other systems are tracked on their own
+	SRE3021_CHECK(IsSameStats(tracker.GetStats(0), 0, 0, 0, 0, 0));
+	SRE3021_CHECK(IsSameStats(tracker.GetTotalStats(), 5, lostCount, 0, 1, 1));
+}
+
+SRE3021_TEST(SequenceTrackerWrap)
+{
+	SRE3021SequenceTracker tracker;
+	// Across the 14 bit wrap in order
+	tracker.Track(1, SRE3021_PACKET_COUNT_MODULO - 2);
+	tracker.Track(1, SRE3021_PACKET_COUNT_MODULO - 1);
+	tracker.Track(1, 0);
+	tracker.Track(1, 1);
+	SRE3021_CHECK(IsSameStats(tracker.GetStats(1), 4, 0, 0, 0, 0));
+	SRE3021_CHECK(tracker.GetLossEvents().empty());
+
+	// Reordered across the wrap
+	tracker.Track(2, SRE3021_PACKET_COUNT_MODULO - 1);
+	tracker.Track(2, 1);
+	tracker.Track(2, 0);
+	SRE3021_CHECK(IsSameStats(tracker.GetStats(2), 3, 0, 0, 1, 0));
+	// The gap after 1 is in the window and only lost once it leaves
+	tracker.Track(2, 1 + SRE3021_SEQUENCE_REORDER_WINDOW);
+	SRE3021_CHECK(tracker.GetStats(2).Lost == 0);
+	tracker.Track(2, 1 + 2 * SRE3021_SEQUENCE_REORDER_WINDOW);
+	SRE3021_CHECK(tracker.GetStats(2).Lost == SRE3021_SEQUENCE_REORDER_WINDOW - 1);
+
+	// A gap across the wrap
+	tracker.Track(4, SRE3021_PACKET_COUNT_MODULO - 1);
+	tracker.Track(4, 2);
+	const std::vector<SRE3021SequenceLossEvent> events = tracker.GetLossEvents();
+	SRE3021_CHECK(!events.empty() && events.back().SystemNumber == 4 && events.back().ExpectedPacketCount == 0 && events.back().GapLength == 2);
+}
+
+SRE3021_TEST(SequenceTrackerConcurrentGetters)
+{
+	SRE3021SequenceTracker tracker;
+	const int packetCount = 200000;
+	std::atomic<bool> isDone(false);
+	bool isMonotonic = true;
+	std::thread reader([&tracker, &isDone, &isMonotonic]()
+	{
+		size_t lastReceived = 0;
+		while (!isDone.load())
+		{
+			const size_t received = tracker.GetTotalStats().Received;
+			isMonotonic = isMonotonic && received >= lastReceived;
+			lastReceived = received;
+		}
+	});
+	for (int i = 0; i < packetCount; ++i)
+	{
+		tracker.Track(i & 1, (i >> 1) & (SRE3021_PACKET_COUNT_MODULO - 1));
+	}
+	isDone.store(true);
+	reader.join();
+	SRE3021_CHECK(isMonotonic);
+	SRE3021_CHECK(IsSameStats(tracker.GetTotalStats(), packetCount, 0, 0, 0, 0));
+}
@@ -0,0 +1,198 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+#include "SRE3021Test.h"
+#include "SRE3021TestPackets.h"
+
+#include <random>
+#include <vector>
+
+#include "../SRE3021PulseHeightDecoder.h"
+#include "../SpectrumEnergy.h"
+
+using namespace hurel::sre3021;
+using namespace hurel::sre3021::test;
+
+// Energy calibration of the benchmarks, as ProcessImgDataEnergyP1 and ProcessImgDataEnergyP2
+#define SRE3021_TEST_ENERGY_P1 (0.5)
+#define SRE3021_TEST_ENERGY_P2 (0.0)
+
+// Single-event pulse-height packet of a single channel readout with one sample, header included
+static void WriteSingleChannelPacket(unsigned __int8* packet, int channel, unsigned int sample, unsigned __int32 timestamp)
+{
+	WriteTestHeader(packet, SRE3021PacketType::PULSE_HEIGHT_DATA, timestamp, SRE3021_PULSE_HEIGHT_FIELDS_LENGTH + 2);
+	unsigned __int8* data = packet + SRE3021_PACKET_HEADER_LENGTH;
+	data[0] = 1;
+	data[1] = static_cast<unsigned __int8>(SRE3021TriggerType::SINGLE_CHANNEL_READOUT_MODE);
+	data[2] = static_cast<unsigned __int8>(channel);
+	data[3] = 0;
+	data[4] = 0;
+	data[5] = 0;
+	data[6] = 1;
+	data[7] = static_cast<unsigned __int8>(sample >> 8 & 0xFF);
+	data[8] = static_cast<unsigned __int8>(sample & 0xFF);
+}
+
+static bool DecodeSingleChannelPacket(const SRE3021ImageDecoder& decoder, const unsigned __int8* packet, SRE3021ChannelEvent& outEvent)
+{
+	unsigned __int16 samples[(SRE3021_UDP_SINGLE_CHANNEL_SLOT_SIZE - SRE3021_PACKET_HEADER_LENGTH - SRE3021_PULSE_HEIGHT_FIELDS_LENGTH) / 2];
+	SRE3021PulseHeightData data;
+	if (SRE3021PulseHeightDecoder::DecodePulseHeight(packet + SRE3021_PACKET_HEADER_LENGTH, SRE3021_PULSE_HEIGHT_FIELDS_LENGTH + 2, data,
+		samples, sizeof(samples) / sizeof(samples[0])) != SRE3021PacketDecodeStatus::SUCCESS)
+	{
+		return false;
+	}
+	decoder.DecodeChannelEvent(data, outEvent);
+	return true;
+}
+
+// The spectrum part of SRE3021API::BasicImageProcessingFunc: events with a single interaction pixel add its energy
+static void AddImageEnergy(const SRE3021ImageData& imageData, SpectrumEnergy& spectrum)
+{
+	int interactionCount = 0;
+	int interactionX = 0;
+	int interactionY = 0;
+	long long backgroundNoise = 0;
+	for (int X = 0; X < 11; ++X)
+	{
+		for (int Y = 0; Y < 11; ++Y)
+		{
+			if (imageData.AnodeTiming[X][Y] > 250)
+			{
+				if (++interactionCount == 2)
+				{
+					return;
+				}
+				interactionX = X;
+				interactionY = Y;
+			}
+			else
+			{
+				backgroundNoise += imageData.AnodeValue[X][Y];
+			}
+		}
+	}
+	if (interactionCount == 1)
+	{
+		spectrum.AddEnergy((static_cast<double>(imageData.AnodeValue[interactionX][interactionY]) - backgroundNoise / 120) * SRE3021_TEST_ENERGY_P1 + SRE3021_TEST_ENERGY_P2);
+	}
+}
+
+// Channels wired to an anode pixel
+static std::vector<int> PixelChannels(const SRE3021ImageDecoder& decoder)
+{
+	std::vector<int> channels;
+	for (int channel = 0; channel < SRE3021_ASIC_CHANNEL_COUNT; ++channel)
+	{
+		if (decoder.GetPixelOfASICChannel(channel) >= 0)
+		{
+			channels.push_back(channel);
+		}
+	}
+	return channels;
+}
+
+SRE3021_TEST(SingleChannelEventDecode)
+{
+	std::mt19937 random(24);
+	TestBaseline baseline;
+	baseline.Randomize(random, 200);
+	SRE3021ImageDecoder decoder;
+	baseline.Apply(decoder);
+
+	unsigned __int8 packet[SRE3021_UDP_SINGLE_CHANNEL_SLOT_SIZE] = {};
+	size_t wrongCount = 0;
+	for (int channel = 0; channel < SRE3021_ASIC_CHANNEL_COUNT; ++channel)
+	{
+		const unsigned int sample = 1000 + channel;
+		WriteSingleChannelPacket(packet, channel, sample, 0);
+		SRE3021ChannelEvent event;
+		if (!DecodeSingleChannelPacket(decoder, packet, event))
+		{
+			++wrongCount;
+			continue;
+		}
+		const int pixel = decoder.GetPixelOfASICChannel(channel);
+		// Value has the anode value baseline of the pixel subtracted, baseline is indexed [X][Y] and Pixel is Y * 11 + X
+		const long long expectedValue = pixel < 0 ? sample : static_cast<long long>(sample) - static_cast<long long>(baseline.AnodeValue[pixel % 11][pixel / 11]);
+		wrongCount += event.ChannelId != channel || event.Pixel != pixel || event.Value != expectedValue;
+	}
+	SRE3021_CHECK(wrongCount == 0);
+	SRE3021_CHECK(PixelChannels(decoder).size() == 121);
+}
+
+SRE3021_BENCHMARK(SingleChannelVsFullImage)
+{
+	std::mt19937 random(24);
+	const size_t eventCount = 4096;
+	const int roundCount = 20;
+	TestBaseline baseline;
+	baseline.Randomize(random, 200);
+	SRE3021ImageDecoder decoder;
+	baseline.Apply(decoder);
+	const double processedCount = static_cast<double>(eventCount) * roundCount;
+
+	// Full image readout: every event is a 524 byte image packet decoded into all 121 pixels
+	const std::vector<unsigned __int8> imagePackets = MakeRandomImagePackets(random, eventCount);
+	SpectrumEnergy imageSpectrum(5.0, 3000);
+	SRE3021ImageData imageData;
+	auto start = std::chrono::steady_clock::now();
+	for (int round = 0; round < roundCount; ++round)
+	{
+		for (size_t i = 0; i < eventCount; ++i)
+		{
+			decoder.Decode(&imagePackets[i * SRE3021_IMAGE_PACKET_LENGTH], imageData);
+			AddImageEnergy(imageData, imageSpectrum);
+		}
+	}
+	ReportRate("Full image decode + spectrum", processedCount, "events/s", SecondsSince(start));
+
+	// Single channel readout: every event is one channel in a 19 byte packet, held in a pool slot
+	const std::vector<int> channels = PixelChannels(decoder);
+	std::uniform_int_distribution<size_t> channelIndex(0, channels.size() - 1);
+	std::uniform_int_distribution<unsigned int> sample(0, 0x3FFF);
+	std::vector<unsigned __int8> channelPackets(eventCount * SRE3021_UDP_SINGLE_CHANNEL_SLOT_SIZE);
+	for (size_t i = 0; i < eventCount; ++i)
+	{
+		WriteSingleChannelPacket(&channelPackets[i * SRE3021_UDP_SINGLE_CHANNEL_SLOT_SIZE], channels[channelIndex(random)], sample(random),
+			static_cast<unsigned __int32>(1000 + 10 * i));
+	}
+	SpectrumEnergy channelSpectrum(5.0, 3000);
+	size_t decodedCount = 0;
+	start = std::chrono::steady_clock::now();
+	for (int round = 0; round < roundCount; ++round)
+	{
+		for (size_t i = 0; i < eventCount; ++i)
+		{
+			SRE3021ChannelEvent event;
+			if (DecodeSingleChannelPacket(decoder, &channelPackets[i * SRE3021_UDP_SINGLE_CHANNEL_SLOT_SIZE], event))
+			{
+				++decodedCount;
+				channelSpectrum.AddEnergy(static_cast<double>(event.Value) * SRE3021_TEST_ENERGY_P1 + SRE3021_TEST_ENERGY_P2);
+			}
+		}
+	}
+	ReportRate("Single channel decode + spectrum", processedCount, "events/s", SecondsSince(start));
+	SRE3021_CHECK(decodedCount == eventCount * roundCount);
+}
@@ -0,0 +1,86 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021Test.h"
+
+#include <cstdio>
+#include <cstring>
+
+using namespace hurel::sre3021::test;
+
+static int FailureCount = 0;
+
+std::vector<TestCase>& hurel::sre3021::test::GetTestCases()
+{
+	static std::vector<TestCase> testCases;
+	return testCases;
+}
+
+void hurel::sre3021::test::ReportFailure(const char* file, int line, const char* expression)
+{
+	printf("%s(%d): check failed: %s\n", file, line, expression);
+	++FailureCount;
+}
+
+void hurel::sre3021::test::ReportRate(const char* name, double count, const char* unit, double seconds)
+{
+	printf("  %-40s %14.0f %s (%.3f s)\n", name, seconds > 0 ? count / seconds : 0.0, unit, seconds);
+}
+
+// SRE3021Test [--bench] [name filter]
+// Runs the unit tests, or the benchmarks with --bench. Returns non zero if any check failed.
+int main(int argc, char* argv[])
+{
+	bool isBenchmark = false;
+	const char* filter = nullptr;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--bench") == 0)
+		{
+			isBenchmark = true;
+		}
+		else
+		{
+			filter = argv[i];
+		}
+	}
+
+	int runCount = 0;
+	for (const TestCase& testCase : GetTestCases())
+	{
+		if (testCase.IsBenchmark != isBenchmark || (filter != nullptr && strstr(testCase.Name, filter) == nullptr))
+		{
+			continue;
+		}
+		const int failureCountBefore = FailureCount;
+		printf("[ RUN  ] %s\n", testCase.Name);
+		fflush(stdout);
+		testCase.Func();
+		printf("[ %s ] %s\n", FailureCount == failureCountBefore ? " OK " : "FAIL", testCase.Name);
+		++runCount;
+	}
+	printf("%d %s, %d failed checks\n", runCount, isBenchmark ? "benchmarks" : "tests", FailureCount);
+	return FailureCount == 0 ? 0 : 1;
+}
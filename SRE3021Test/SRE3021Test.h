@@ -0,0 +1,79 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <vector>
+#include <chrono>
+
+namespace hurel {
+    namespace sre3021 {
+        namespace test {
+            typedef void (*TestFunc)();
+
+            /// <summary>
+            /// A unit test or a benchmark, registered by SRE3021_TEST or SRE3021_BENCHMARK.
+            /// </summary>
+            struct TestCase {
+                const char* Name; TestFunc Func; bool IsBenchmark;
+            };
+
+            std::vector<TestCase>& GetTestCases();
+
+            struct TestRegistrar
+            {
+                TestRegistrar(const char* name, TestFunc func, bool isBenchmark)
+                {
+                    GetTestCases().push_back(TestCase{ name, func, isBenchmark });
+                };
+            };
+
+            void ReportFailure(const char* file, int line, const char* expression);
+
+            /// <summary>
+            /// Print count / seconds as the throughput of a benchmark, e.g. "events/s".
+            /// </summary>
+            void ReportRate(const char* name, double count, const char* unit, double seconds);
+
+            inline double SecondsSince(std::chrono::steady_clock::time_point start)
+            {
+                return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            };
+        };
+    };
+};
+
+#define SRE3021_TEST(name) \
+    static void name(); \
+    static hurel::sre3021::test::TestRegistrar name##Registrar(#name, name, false); \
+    static void name()
+
+#define SRE3021_BENCHMARK(name) \
+    static void name(); \
+    static hurel::sre3021::test::TestRegistrar name##Registrar(#name, name, true); \
+    static void name()
+
+#define SRE3021_CHECK(expression) \
+    do { if (!(expression)) { hurel::sre3021::test::ReportFailure(__FILE__, __LINE__, #expression); } } while (0)
@@ -0,0 +1,130 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include <vector>
+#include <random>
+#include <cstring>
+
+#include "../SRE3021HeaderCodec.h"
+#include "../SRE3021ImageDecoder.h"
+
+namespace hurel {
+    namespace sre3021 {
+        namespace test {
+            /// <summary>
+            /// Anode and cathode baselines indexed [X][Y] like SRE3021API's, filled with random values up to maxValue.
+            /// </summary>
+            struct TestBaseline {
+                size_t AnodeValue[11][11]; size_t AnodeTiming[11][11]; size_t CathodeValue; size_t CathodeTiming;
+
+                void Randomize(std::mt19937& random, unsigned int maxValue)
+                {
+                    std::uniform_int_distribution<unsigned int> value(0, maxValue);
+                    for (int X = 0; X < 11; ++X)
+                    {
+                        for (int Y = 0; Y < 11; ++Y)
+                        {
+                            AnodeValue[X][Y] = value(random);
+                            AnodeTiming[X][Y] = value(random);
+                        }
+                    }
+                    CathodeValue = value(random);
+                    CathodeTiming = value(random);
+                };
+
+                void Apply(SRE3021ImageDecoder& decoder) const
+                {
+                    decoder.SetBaseline(AnodeValue, AnodeTiming, CathodeValue, CathodeTiming);
+                };
+            };
+
+            /// <summary>
+            /// Header of a packet of the given type for system 1, with the time stamp in the reserved field.
+            /// </summary>
+            inline void WriteTestHeader(unsigned __int8* packet, SRE3021PacketType packetType, unsigned __int32 timestamp, int dataLength)
+            {
+                const SRE3021HeaderBytes header = SRE3021HeaderCodec::Encode(SRE3021HeaderFields{ 0, 1, packetType,
+                    SRE3021PacketSequence::STAND_ALONE, 0, timestamp, dataLength });
+                memcpy(packet, header.Bytes, SRE3021_PACKET_HEADER_LENGTH);
+            };
+
+            /// <summary>
+            /// packetCount image packets with random data, packetStride bytes apart, followed by a cache line of padding
+            /// so that the wide kernels may read past the last packet like in a pool slot. Time stamps count up from 1000.
+            /// </summary>
+            inline std::vector<unsigned __int8> MakeRandomImagePackets(std::mt19937& random, size_t packetCount, size_t packetStride = SRE3021_IMAGE_PACKET_LENGTH)
+            {
+                std::vector<unsigned __int8> packets(packetCount * packetStride + 64);
+                std::uniform_int_distribution<unsigned int> byte(0, 255);
+                for (size_t i = 0; i < packetCount; ++i)
+                {
+                    unsigned __int8* packet = &packets[i * packetStride];
+                    for (size_t j = SRE3021_PACKET_HEADER_LENGTH; j < SRE3021_IMAGE_PACKET_LENGTH; ++j)
+                    {
+                        packet[j] = static_cast<unsigned __int8>(byte(random));
+                    }
+                    WriteTestHeader(packet, SRE3021PacketType::IMG_DATA, static_cast<unsigned __int32>(1000 + 10 * i), SRE3021_IMAGE_PACKET_LENGTH - SRE3021_PACKET_HEADER_LENGTH);
+                }
+                return packets;
+            };
+
+            /// <summary>
+            /// Image event of a packet the way the image processing thread used to decode it, one pixel at a time.
+            /// Reference for the decoder tests and the baseline of the decoder benchmarks.
+            /// </summary>
+            inline void DecodeImagePacketReference(const unsigned __int8* bytes, const TestBaseline& baseline, SRE3021ImageData& imageData)
+            {
+                imageData.CathodeValue = static_cast<long long>(bytes[20] << 8 | bytes[21]) - static_cast<long long>(baseline.CathodeValue);
+                imageData.CathodeTiming = static_cast<long long>(bytes[22] << 8 | bytes[23]) - static_cast<long long>(baseline.CathodeTiming);
+                imageData.Timestamp = SRE3021HeaderCodec::DecodeTimestamp(bytes);
+                imageData.ReceiveTime = 0;
+                int imgOrder = 0;
+                for (int Y = 0; Y < 11; ++Y)
+                {
+                    for (int X = 0; X < 11; ++X)
+                    {
+                        unsigned __int8 anodeEByte[2]{ bytes[31 + imgOrder], bytes[30 + imgOrder] };
+                        unsigned __int8 anodeTByte[2]{ bytes[273 + imgOrder], bytes[272 + imgOrder] };
+                        unsigned __int16 anodeE = 0;
+                        unsigned __int16 anodeT = 0;
+                        memcpy(&anodeE, anodeEByte, sizeof(anodeE));
+                        memcpy(&anodeT, anodeTByte, sizeof(anodeT));
+                        imageData.AnodeValue[X][Y] = static_cast<long long>(anodeE) - static_cast<long long>(baseline.AnodeValue[X][Y]);
+                        imageData.AnodeTiming[X][Y] = static_cast<long long>(anodeT) - static_cast<long long>(baseline.AnodeTiming[X][Y]);
+                        imgOrder += 2;
+                    }
+                }
+            };
+
+            inline bool IsSameImageData(const SRE3021ImageData& a, const SRE3021ImageData& b)
+            {
+                return a.CathodeValue == b.CathodeValue && a.CathodeTiming == b.CathodeTiming && a.Timestamp == b.Timestamp
+                    && memcmp(a.AnodeValue, b.AnodeValue, sizeof(a.AnodeValue)) == 0 && memcmp(a.AnodeTiming, b.AnodeTiming, sizeof(a.AnodeTiming)) == 0;
+            };
+        };
+    };
+};
@@ -0,0 +1,74 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+#include "SRE3021Test.h"
+
+#include "../SRE3021TimestampUnwrapper.h"
+
+using namespace hurel::sre3021;
+
+SRE3021_TEST(TimestampUnwrapperWrap)
+{
+	SRE3021TimestampUnwrapper unwrapper;
+	SRE3021_CHECK(unwrapper.GetLatest(1) == 0);
+	SRE3021_CHECK(unwrapper.Unwrap(1, 0xFFFFFFF0u) == 0xFFFFFFF0ULL);
+	SRE3021_CHECK(unwrapper.Unwrap(1, 0x10u) == 0x100000010ULL);
+	SRE3021_CHECK(unwrapper.GetLatest(1) == 0x100000010ULL);
+	// A second wrap
+	SRE3021_CHECK(unwrapper.Unwrap(1, 0x80000000u) == 0x180000000ULL);
+	SRE3021_CHECK(unwrapper.Unwrap(1, 0xF0000000u) == 0x1F0000000ULL);
+	SRE3021_CHECK(unwrapper.Unwrap(1, 0x00000001u) == 0x200000001ULL);
+	// Other systems start on their own
+	SRE3021_CHECK(unwrapper.Unwrap(2, 0x10u) == 0x10ULL);
+	SRE3021_CHECK(unwrapper.Unwrap(2 + SRE3021_TIMESTAMP_SYSTEM_COUNT, 0x20u) == 0x20ULL);
+	SRE3021_CHECK(unwrapper.GetLatest(2) == 0x20ULL);
+}
+
+SRE3021_TEST(TimestampUnwrapperReorder)
+{
+	SRE3021TimestampUnwrapper unwrapper;
+	SRE3021_CHECK(unwrapper.Unwrap(0, 0xFFFFFFF0u) == 0xFFFFFFF0ULL);
+	SRE3021_CHECK(unwrapper.Unwrap(0, 0x10u) == 0x100000010ULL);
+	// Reordered back across the wrap, the latest timestamp stays
+	SRE3021_CHECK(unwrapper.Unwrap(0, 0xFFFFFFFEu) == 0xFFFFFFFEULL);
+	SRE3021_CHECK(unwrapper.GetLatest(0) == 0x100000010ULL);
+	SRE3021_CHECK(unwrapper.Unwrap(0, 0x08u) == 0x100000008ULL);
+	SRE3021_CHECK(unwrapper.Unwrap(0, 0x11u) == 0x100000011ULL);
+}
+
+SRE3021_TEST(TimestampUnwrapperReorderBeforeFirst)
+{
+	SRE3021TimestampUnwrapper unwrapper;
+	SRE3021_CHECK(unwrapper.Unwrap(3, 5u) == 5ULL);
+	// Sent before the first timestamp and before the wrap: below 0, clamped instead of wrapping to about 2^64
+	SRE3021_CHECK(unwrapper.Unwrap(3, 0xFFFFFFFEu) == 0ULL);
+	SRE3021_CHECK(unwrapper.GetLatest(3) == 5ULL);
+	// Reordered but not before the start
+	SRE3021_CHECK(unwrapper.Unwrap(3, 1u) == 1ULL);
+	SRE3021_CHECK(unwrapper.Unwrap(3, 6u) == 6ULL);
+
+	unwrapper.Reset();
+	SRE3021_CHECK(unwrapper.GetLatest(3) == 0);
+	SRE3021_CHECK(unwrapper.Unwrap(3, 0xFFFFFFFEu) == 0xFFFFFFFEULL);
+}
@@ -0,0 +1,154 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021Test.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../SRE3021WaveformProcessor.h"
+
+using namespace hurel::sre3021;
+using namespace hurel::sre3021::test;
+
+static const SRE3021SimdLevel SimdLevels[] = { SRE3021SimdLevel::SCALAR, SRE3021SimdLevel::SSE2, SRE3021SimdLevel::AVX2 };
+static const char* SimdLevelNames[] = { "SCALAR", "SSE2", "AVX2" };
+
+// Noisy preamplifier pulses: a baseline, then a step of random height and start that decays over 400 cells
+static std::vector<SRE3021WaveformData> MakeRandomWaveforms(std::mt19937& random, size_t waveformCount)
+{
+	std::vector<SRE3021WaveformData> waveforms(waveformCount);
+	std::uniform_int_distribution<int> baseline(500, 1500);
+	std::uniform_int_distribution<int> amplitude(0, 8000);
+	std::uniform_int_distribution<int> start(40, 100);
+	std::normal_distribution<double> noise(0.0, 4.0);
+	for (SRE3021WaveformData& waveform : waveforms)
+	{
+		waveform = SRE3021WaveformData{};
+		waveform.IsAnode = true;
+		const int waveformBaseline = baseline(random);
+		const int waveformAmplitude = amplitude(random);
+		const int waveformStart = start(random);
+		for (int n = 0; n < SRE3021_WAVEFORM_CELL_COUNT; ++n)
+		{
+			const double pulse = n < waveformStart ? 0.0 : waveformAmplitude * std::exp(-(n - waveformStart) / 400.0);
+			const double cell = waveformBaseline + pulse + noise(random);
+			waveform.Cells[n] = static_cast<unsigned __int16>(std::min(std::max(cell, 0.0), static_cast<double>(SRE3021_WAVEFORM_ADC_MASK)));
+		}
+	}
+	return waveforms;
+}
+
+static bool IsSameWaveformResult(const SRE3021WaveformResult& a, const SRE3021WaveformResult& b)
+{
+	return a.Baseline == b.Baseline && a.Amplitude == b.Amplitude && a.Time == b.Time && a.RiseTime == b.RiseTime
+		&& a.PeakCell == b.PeakCell && a.IsOverflow == b.IsOverflow;
+}
+
+SRE3021_TEST(WaveformProcessorBatchMatchesSingle)
+{
+	std::mt19937 random(20);
+	// Full lane blocks and a partial one
+	const size_t waveformCount = 3 * SRE3021_WAVEFORM_LANE_COUNT + 5;
+	const std::vector<SRE3021WaveformData> waveforms = MakeRandomWaveforms(random, waveformCount);
+	for (int level = 0; level < 3; ++level)
+	{
+		SRE3021WaveformProcessor processor;
+		processor.SetSimdLevel(SimdLevels[level]);
+		if (processor.GetSimdLevel() != SimdLevels[level])
+		{
+			printf("  %s not supported by this CPU, skipped\n", SimdLevelNames[level]);
+			continue;
+		}
+		std::vector<SRE3021WaveformResult> batchResults(waveformCount);
+		processor.Process(waveforms.data(), waveformCount, batchResults.data());
+		size_t wrongCount = 0;
+		for (size_t i = 0; i < waveformCount; ++i)
+		{
+			SRE3021WaveformResult result;
+			processor.Process(&waveforms[i], 1, &result);
+			wrongCount += !IsSameWaveformResult(result, batchResults[i]);
+		}
+		SRE3021_CHECK(wrongCount == 0);
+		// Pulses rise after the baseline cells
+		SRE3021_CHECK(batchResults[0].Time > SRE3021_WAVEFORM_BASELINE_CELLS);
+	}
+}
+
+SRE3021_BENCHMARK(WaveformProcessorBatch)
+{
+	std::mt19937 random(20);
+	const size_t waveformCount = 4096;
+	const int roundCount = 5;
+	const std::vector<SRE3021WaveformData> waveforms = MakeRandomWaveforms(random, waveformCount);
+	std::vector<SRE3021WaveformResult> results(waveformCount);
+	std::vector<SRE3021WaveformResult> singleResults(waveformCount);
+	const double processedCount = static_cast<double>(waveformCount) * roundCount;
+
+	char name[64];
+	for (int level = 0; level < 3; ++level)
+	{
+		SRE3021WaveformProcessor processor;
+		processor.SetSimdLevel(SimdLevels[level]);
+		if (processor.GetSimdLevel() != SimdLevels[level])
+		{
+			printf("  %s not supported by this CPU, skipped\n", SimdLevelNames[level]);
+			continue;
+		}
+
+		// One waveform per call, as the decode workers did when handing events over in arrival order
+		auto start = std::chrono::steady_clock::now();
+		for (int round = 0; round < roundCount; ++round)
+		{
+			for (size_t i = 0; i < waveformCount; ++i)
+			{
+				processor.Process(&waveforms[i], 1, &singleResults[i]);
+			}
+		}
+		snprintf(name, sizeof(name), "%s Process 1 per call", SimdLevelNames[level]);
+		ReportRate(name, processedCount, "waveforms/s", SecondsSince(start));
+
+		// SRE3021_WAVEFORM_LANE_COUNT per call, as RaiseUDPWaveforms
+		start = std::chrono::steady_clock::now();
+		for (int round = 0; round < roundCount; ++round)
+		{
+			for (size_t i = 0; i < waveformCount; i += SRE3021_WAVEFORM_LANE_COUNT)
+			{
+				processor.Process(&waveforms[i], SRE3021_WAVEFORM_LANE_COUNT, &results[i]);
+			}
+		}
+		snprintf(name, sizeof(name), "%s Process %d per call", SimdLevelNames[level], SRE3021_WAVEFORM_LANE_COUNT);
+		ReportRate(name, processedCount, "waveforms/s", SecondsSince(start));
+
+		size_t wrongCount = 0;
+		for (size_t i = 0; i < waveformCount; ++i)
+		{
+			wrongCount += !IsSameWaveformResult(results[i], singleResults[i]);
+		}
+		SRE3021_CHECK(wrongCount == 0);
+	}
+}
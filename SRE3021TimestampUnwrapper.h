@@ -0,0 +1,97 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include "SRE3021Types.h"
+
+#define SRE3021_TIMESTAMP_SYSTEM_COUNT (32)
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// Extends the 32 bit header timestamp of every SystemNumber to 64 bits.
+        /// A step of less than half the 32 bit range backwards is taken as a reordered packet, not a wrap,
+        /// so the result stays right as long as a SystemNumber sends at least once per half range.
+        /// Unwrap is called by one thread.
+        /// </summary>
+        class SRE3021TimestampUnwrapper
+        {
+        public:
+            SRE3021TimestampUnwrapper()
+            {
+                Reset();
+            };
+
+            void Reset()
+            {
+                for (int i = 0; i < SRE3021_TIMESTAMP_SYSTEM_COUNT; ++i)
+                {
+                    isStarted[i] = false;
+                    latest[i] = 0;
+                }
+            };
+
+            /// <summary>
+            /// The first timestamp of a SystemNumber is taken as is. A reordered packet from before it across the wrap,
+            /// e.g. 0xFFFFFFFE after a first timestamp of 5, would come out below 0 and is clamped to 0.
+            /// </summary>
+            unsigned long long Unwrap(int systemNumber, unsigned __int32 timestamp)
+            {
+                const int i = systemNumber & (SRE3021_TIMESTAMP_SYSTEM_COUNT - 1);
+                if (!isStarted[i])
+                {
+                    isStarted[i] = true;
+                    latest[i] = timestamp;
+                    return latest[i];
+                }
+                // Signed distance to the latest timestamp, modulo 2^32
+                const __int32 step = static_cast<__int32>(timestamp - static_cast<unsigned __int32>(latest[i]));
+                if (step < 0 && static_cast<unsigned long long>(-static_cast<long long>(step)) > latest[i])
+                {
+                    return 0;
+                }
+                const unsigned long long unwrapped = latest[i] + static_cast<long long>(step);
+                if (step > 0)
+                {
+                    latest[i] = unwrapped;
+                }
+                return unwrapped;
+            };
+
+            /// <summary>
+            /// Highest unwrapped timestamp of the SystemNumber so far, 0 before its first packet
+            /// </summary>
+            unsigned long long GetLatest(int systemNumber) const
+            {
+                return latest[systemNumber & (SRE3021_TIMESTAMP_SYSTEM_COUNT - 1)];
+            };
+
+        private:
+            bool isStarted[SRE3021_TIMESTAMP_SYSTEM_COUNT];
+            unsigned long long latest[SRE3021_TIMESTAMP_SYSTEM_COUNT];
+        };
+    };
+};
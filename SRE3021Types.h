@@ -24,7 +24,32 @@
 // IN THE SOFTWARE.
 // ----------------------------------------------------------------------------
 #pragma once
+
+#include <cstddef>
 #define SRE3021_PACKET_HEADER_LENGTH (10)
+#define SRE3021_IMAGE_PACKET_LENGTH (514)
+#define SRE3021_UDP_IMAGE_BUFFER_CAPACITY (16384)
+#define SRE3021_UDP_PACKET_POOL_HEADROOM (256)
+#define SRE3021_UDP_PACKET_POOL_SIZE (SRE3021_UDP_IMAGE_BUFFER_CAPACITY + SRE3021_UDP_PACKET_POOL_HEADROOM)
+#define SRE3021_UDP_IMAGE_BUFFER_HIGH_WATERMARK (0.75)
+#define SRE3021_UDP_IMAGE_BUFFER_LOW_WATERMARK (0.25)
+#define SRE3021_UDP_RECV_BATCH_SIZE (32)
+#define SRE3021_UDP_RAISER_SPIN_BUDGET (1000)
+#define SRE3021_UDP_RAISER_PARK_TIMEOUT_MS (100)
+#define SRE3021_UDP_DECODE_WORKER_MAX (64)
+#define SRE3021_UDP_RECEIVE_BUFFER_SIZE (8 * 1024 * 1024)
+#define SRE3021_UDP_RECEIVE_TIMEOUT_MS (5000)
+#define SRE3021_UDP_IMAGE_PORT (50011)
+// Packet pool slot for multi-event pulse-height packets, the largest UDP payload of a 1500 byte Ethernet frame
+#define SRE3021_UDP_PULSE_HEIGHT_SLOT_SIZE (1472)
+#define SRE3021_UDP_TRIGGER_TIME_SLOT_SIZE (1472)
+#define SRE3021_UDP_IMAGE_FRAME_SLOT_SIZE (1472)
+// Packet pool slot for single channel readout, a pulse-height packet of a few samples
+#define SRE3021_UDP_SINGLE_CHANNEL_SLOT_SIZE (64)
+
+// glibc's <endian.h> defines both as byte order values, which are both true
+#undef LITTLE_ENDIAN
+#undef BIG_ENDIAN
 #define LITTLE_ENDIAN (1)
 #define BIG_ENDIAN (0)
 #define ASICBitSize (650)
@@ -62,8 +87,37 @@ namespace hurel {
             {35, 40, 46, 52, 58, 64, 70, 78, 80, 90, 92}
         };
 
+        /// <summary>
+        /// What the anode timings of an image event hold
+        /// </summary>
+        enum class SRE3021AnodeTimingMode
+        {
+            /// <summary>
+            /// Baseline subtracted anode timing words of an image packet
+            /// </summary>
+            PULSE_TIMING = 0,
+            /// <summary>
+            /// Pulse-height data has no timing word. Anode timing is 1 for channels the ASIC triggered and 0 for the others.
+            /// </summary>
+            TRIGGER_FLAG = 1
+        };
+
+        /// <summary>
+        /// Timestamp is the header time stamp in hardware ticks, extended to 64 bits per SystemNumber.
+        /// ReceiveTime is the host steady_clock time in nanoseconds at which the UDP listener received the packet.
+        /// AnodeTimingMode tells whether AnodeTiming can be cut on.
+        /// </summary>
         struct SRE3021ImageData {
             long long CathodeValue; long long CathodeTiming; long long AnodeValue[11][11]; long long AnodeTiming[11][11];
+            unsigned long long Timestamp; long long ReceiveTime; SRE3021AnodeTimingMode AnodeTimingMode = SRE3021AnodeTimingMode::PULSE_TIMING;
+        };
+
+        /// <summary>
+        /// One channel of a single channel readout. Value is the pulse height with the anode value baseline of its pixel subtracted,
+        /// Pixel is Y * 11 + X, -1 for a channel without an anode pixel. Timestamp and ReceiveTime are as in SRE3021ImageData.
+        /// </summary>
+        struct SRE3021ChannelEvent {
+            unsigned long long Timestamp; long long ReceiveTime; __int32 Value; __int16 ChannelId; __int16 Pixel;
         };
 
         /// <summary>
@@ -96,9 +150,81 @@ namespace hurel {
             /// </summary>
             READBACK_ASIC_REG = 0xC1,
             /// <summary>
+            /// Per channel trigger counts of a counting frame
+            /// </summary>
+            COUNTING_FRAME_DATA = 0xD0,
+            /// <summary>
             /// Image data format from the SRE3021
             /// </summary>
-            IMG_DATA = 0xD1
+            IMG_DATA = 0xD1,
+            /// <summary>
+            /// Several time stamped pulse-height events in one packet
+            /// </summary>
+            MULTI_PULSE_HEIGHT_DATA = 0xD4,
+            /// <summary>
+            /// Pulse heights of one readout
+            /// </summary>
+            PULSE_HEIGHT_DATA = 0xD5,
+            /// <summary>
+            /// Time stamp, source and channel of several triggers
+            /// </summary>
+            TRIGGER_TIME_DATA = 0xD6,
+            /// <summary>
+            /// 160 sampled pipeline cells of one channel
+            /// </summary>
+            PIPELINE_SAMPLING_DATA = 0xD9
+        };
+
+        /// <summary>
+        /// What caused a readout, the "Trigger Type" field of pulse-height data
+        /// </summary>
+        enum class SRE3021TriggerType
+        {
+            /// <summary>
+            /// Readout was forced by the system clock
+            /// </summary>
+            SYSTEM_AUTO_FORCED_READOUT = 0x00,
+            /// <summary>
+            /// Readout was triggered by software
+            /// </summary>
+            SOFTWARE_TRIGGER = 0x01,
+            /// <summary>
+            /// Readout was triggered by the ASIC from a pulse on the input, i.e. a physical event
+            /// </summary>
+            ASIC_TRIGGER = 0x02,
+            /// <summary>
+            /// Readout was forced by the calibration pulse generator
+            /// </summary>
+            CALIBRATION_TRIGGER = 0x03,
+            /// <summary>
+            /// Readout was triggered by an external trigger signal
+            /// </summary>
+            EXTERNAL_TRIGGER = 0x04,
+            /// <summary>
+            /// Readout contains only data from the triggered channel
+            /// </summary>
+            SINGLE_CHANNEL_READOUT_MODE = 0x05,
+            /// <summary>
+            /// Readout contains multi-hit trigger data from an XA ASIC
+            /// </summary>
+            XA_MULTI_HIT_TRIGGER = 0x06,
+            UNDEFINED = 0xFF
+        };
+
+        /// <summary>
+        /// Result of decoding the Packet Data field of a packet
+        /// </summary>
+        enum class SRE3021PacketDecodeStatus
+        {
+            SUCCESS = 0,
+            /// <summary>
+            /// Packet Data is shorter than its own counts require, or has a length the format does not allow
+            /// </summary>
+            ERROR_DATA_LENGTH = 1,
+            /// <summary>
+            /// The storage given for the decoded data is too small
+            /// </summary>
+            ERROR_CAPACITY = 2
         };
 
         /// <summary>
@@ -124,6 +250,137 @@ namespace hurel {
             LAST_PACKET = 3
         };
 
+        /// <summary>
+        /// Receive engine of the UDP listener for image data
+        /// </summary>
+        enum class SRE3021UDPReceiveBackend
+        {
+            /// <summary>
+            /// recvfrom, or recvmmsg where available, on a UDP socket
+            /// </summary>
+            SOCKET = 0,
+            /// <summary>
+            /// io_uring multishot recv into packet pool slots (Linux only)
+            /// </summary>
+            IO_URING = 1,
+            /// <summary>
+            /// AF_PACKET TPACKET_V3 capture ring on a dedicated network interface, bypasses the UDP socket (Linux only)
+            /// </summary>
+            PACKET_MMAP = 2
+        };
+
+        /// <summary>
+        /// What the UDP listener does with an image packet when the image buffer is full
+        /// </summary>
+        enum class SRE3021UDPBackpressurePolicy
+        {
+            /// <summary>
+            /// Drop the new packet
+            /// </summary>
+            DROP_NEWEST = 0,
+            /// <summary>
+            /// Drop the oldest queued packet to make room for the new one
+            /// </summary>
+            DROP_OLDEST = 1,
+            /// <summary>
+            /// Wait for the image processing thread. The kernel drops packets instead once the socket buffer is full.
+            /// </summary>
+            BLOCK_RECEIVER = 2
+        };
+
+        /// <summary>
+        /// Order in which the decode workers hand image events to the image processing functions
+        /// </summary>
+        enum class SRE3021UDPDecodeOrdering
+        {
+            /// <summary>
+            /// Each worker calls the functions as soon as its event is decoded, concurrently with the other workers.
+            /// For consumers where order does not matter, like histograms.
+            /// </summary>
+            NONE = 0,
+            /// <summary>
+            /// Events are handed over one at a time in the order they arrived on the shard, which is PacketCount order
+            /// unless the network reordered the datagrams
+            /// </summary>
+            ARRIVAL = 1
+        };
+
+        /// <summary>
+        /// Event packets the UDP listener accepts on the image port
+        /// </summary>
+        enum class SRE3021AcquisitionMode
+        {
+            /// <summary>
+            /// One image event per 514 byte image packet
+            /// </summary>
+            IMAGE = 0,
+            /// <summary>
+            /// Multi-event pulse-height packets, many time stamped events per datagram. Each event is handed to the
+            /// image processing functions as an image event, see SRE3021ImageDecoder::DecodePulseHeightEvent.
+            /// </summary>
+            MULTI_PULSE_HEIGHT = 1,
+            /// <summary>
+            /// Pipeline sampling packets, one channel waveform per datagram, filtered by SRE3021WaveformProcessor
+            /// and handed to the waveform processing function
+            /// </summary>
+            WAVEFORM = 2,
+            /// <summary>
+            /// Trigger time packets, many triggers per datagram, grouped into coincidences by SRE3021CoincidenceFinder
+            /// and handed to the coincidence processing function
+            /// </summary>
+            TRIGGER_TIME = 3,
+            /// <summary>
+            /// Counting frame packets, added to per channel counters by the UDP listener without queueing them,
+            /// see GetCountingChannelRates
+            /// </summary>
+            COUNTING = 4,
+            /// <summary>
+            /// Image data packets of any size. Images split over several packets are reassembled by the UDP listener.
+            /// Images in the 514 byte SRE3021 layout go to the image processing functions, others to the image frame function.
+            /// </summary>
+            IMAGE_FRAME = 5,
+            /// <summary>
+            /// Single-event pulse-height packets of a single channel readout, see SRE3021API::SetSingleChannelReadout.
+            /// Each packet is handed to the channel event function as one SRE3021ChannelEvent.
+            /// </summary>
+            SINGLE_CHANNEL = 6
+        };
+
+        /// <summary>
+        /// What became of an image data packet handed to SRE3021ImageFrameReassembler
+        /// </summary>
+        enum class SRE3021ImageFrameStatus
+        {
+            /// <summary>
+            /// Stored, the frame still misses packets
+            /// </summary>
+            INCOMPLETE = 0,
+            /// <summary>
+            /// The packet completed its frame
+            /// </summary>
+            COMPLETE = 1,
+            /// <summary>
+            /// A packet of the same frame and position was already stored
+            /// </summary>
+            DUPLICATE = 2,
+            /// <summary>
+            /// Every frame buffer is taken, the packet is dropped
+            /// </summary>
+            NO_FREE_FRAME = 3,
+            /// <summary>
+            /// Packet count, position or length out of range, or not matching the frame
+            /// </summary>
+            INVALID = 4
+        };
+
+        /// <summary>
+        /// Image packets lost on the way to the image processing function, by reason.
+        /// ReceiverBlocked counts waits of the UDP listener under BLOCK_RECEIVER, not drops.
+        /// </summary>
+        struct SRE3021UDPDropStats {
+            size_t ImageBufferFull; size_t ImageBufferEvicted; size_t PacketPoolEmpty; size_t Kernel; size_t ReceiverBlocked;
+        };
+
         /// <summary>
         /// Enum of system register's address
         /// </summary>
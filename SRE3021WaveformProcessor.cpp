@@ -0,0 +1,446 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#include "SRE3021WaveformProcessor.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if SRE3021_HAS_X86_SIMD
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define SRE3021_TARGET_SSE2
+#define SRE3021_TARGET_AVX2
+#else
+#define SRE3021_TARGET_SSE2 __attribute__((target("sse2")))
+#define SRE3021_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace hurel::sre3021;
+
+namespace {
+	struct FilterParams
+	{
+		int BaselineCells; int RiseCells; int GapCells; float DecayFactor; float Gain;
+	};
+
+	// Per lane results of one block of waveforms
+	struct BlockResults
+	{
+		float Baseline[SRE3021_WAVEFORM_LANE_COUNT];
+		float Amplitude[SRE3021_WAVEFORM_LANE_COUNT];
+		float PeakCell[SRE3021_WAVEFORM_LANE_COUNT];
+		float Time10[SRE3021_WAVEFORM_LANE_COUNT];
+		float Time50[SRE3021_WAVEFORM_LANE_COUNT];
+		float Time90[SRE3021_WAVEFORM_LANE_COUNT];
+	};
+
+	const float CrossingFractions[3] = { 0.1f, 0.5f, 0.9f };
+
+	// cells holds one waveform per lane, cell n of lane at cells[n * SRE3021_WAVEFORM_LANE_COUNT + lane].
+	// The baseline is subtracted in place.
+	void FilterLaneScalar(float* cells, int lane, const FilterParams& params, BlockResults& out)
+	{
+		const int stride = SRE3021_WAVEFORM_LANE_COUNT;
+		float baseline = 0.0f;
+		for (int n = 0; n < params.BaselineCells; ++n)
+		{
+			baseline += cells[n * stride + lane];
+		}
+		baseline /= params.BaselineCells;
+		for (int n = 0; n < SRE3021_WAVEFORM_CELL_COUNT; ++n)
+		{
+			cells[n * stride + lane] -= baseline;
+		}
+
+		// Recursive trapezoid: d is the difference of two delayed pulses, summed once for a step and twice
+		// with the pole-zero correction for an exponentially decaying pulse
+		const int k = params.RiseCells;
+		const int l = params.GapCells;
+		float p = 0.0f;
+		float s = 0.0f;
+		float amplitude = -FLT_MAX;
+		int peakCell = 0;
+		float pulseMax = -FLT_MAX;
+		for (int n = 0; n < SRE3021_WAVEFORM_CELL_COUNT; ++n)
+		{
+			const float v = cells[n * stride + lane];
+			float d = v;
+			if (n >= k)
+			{
+				d -= cells[(n - k) * stride + lane];
+			}
+			if (n >= l)
+			{
+				d -= cells[(n - l) * stride + lane];
+			}
+			if (n >= k + l)
+			{
+				d += cells[(n - k - l) * stride + lane];
+			}
+			p += d;
+			s += p + params.DecayFactor * d;
+			const float trapezoid = (params.DecayFactor > 0.0f ? s : p) * params.Gain;
+			if (trapezoid > amplitude)
+			{
+				amplitude = trapezoid;
+				peakCell = n;
+			}
+			pulseMax = std::max(pulseMax, v);
+		}
+
+		float* times[3] = { &out.Time10[lane], &out.Time50[lane], &out.Time90[lane] };
+		for (int i = 0; i < 3; ++i)
+		{
+			const float threshold = CrossingFractions[i] * pulseMax;
+			float time = 0.0f;
+			for (int n = 1; n < SRE3021_WAVEFORM_CELL_COUNT; ++n)
+			{
+				const float previous = cells[(n - 1) * stride + lane];
+				const float current = cells[n * stride + lane];
+				if (current >= threshold && previous < threshold)
+				{
+					time = (n - 1) + (threshold - previous) / (current - previous);
+					break;
+				}
+			}
+			*times[i] = time;
+		}
+		out.Baseline[lane] = baseline;
+		out.Amplitude[lane] = amplitude;
+		out.PeakCell[lane] = static_cast<float>(peakCell);
+	}
+
+#if SRE3021_HAS_X86_SIMD
+	// Interpolated time at which each of four lanes first rises through threshold, 0 if it never does.
+	// Stops as soon as every lane has crossed.
+	SRE3021_TARGET_SSE2 inline __m128 FirstCrossingSSE2(const float* cells, __m128 threshold)
+	{
+		const int stride = SRE3021_WAVEFORM_LANE_COUNT;
+		__m128 isFound = _mm_setzero_ps();
+		__m128 crossingCell = _mm_setzero_ps();
+		__m128 crossingPrevious = _mm_setzero_ps();
+		__m128 crossingCurrent = _mm_set1_ps(1.0f);
+		__m128 previous = _mm_loadu_ps(cells);
+		__m128 cell = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		for (int n = 1; n < SRE3021_WAVEFORM_CELL_COUNT && _mm_movemask_ps(isFound) != 0xF; ++n)
+		{
+			const __m128 current = _mm_loadu_ps(cells + n * stride);
+			const __m128 isCrossing = _mm_andnot_ps(isFound, _mm_and_ps(_mm_cmpge_ps(current, threshold), _mm_cmplt_ps(previous, threshold)));
+			crossingCell = _mm_or_ps(_mm_and_ps(isCrossing, cell), _mm_andnot_ps(isCrossing, crossingCell));
+			crossingPrevious = _mm_or_ps(_mm_and_ps(isCrossing, previous), _mm_andnot_ps(isCrossing, crossingPrevious));
+			crossingCurrent = _mm_or_ps(_mm_and_ps(isCrossing, current), _mm_andnot_ps(isCrossing, crossingCurrent));
+			isFound = _mm_or_ps(isFound, isCrossing);
+			previous = current;
+			cell = _mm_add_ps(cell, one);
+		}
+		const __m128 time = _mm_add_ps(crossingCell, _mm_div_ps(_mm_sub_ps(threshold, crossingPrevious), _mm_sub_ps(crossingCurrent, crossingPrevious)));
+		return _mm_and_ps(isFound, time);
+	}
+
+	SRE3021_TARGET_AVX2 inline __m256 FirstCrossingAVX2(const float* cells, __m256 threshold)
+	{
+		const int stride = SRE3021_WAVEFORM_LANE_COUNT;
+		__m256 isFound = _mm256_setzero_ps();
+		__m256 crossingCell = _mm256_setzero_ps();
+		__m256 crossingPrevious = _mm256_setzero_ps();
+		__m256 crossingCurrent = _mm256_set1_ps(1.0f);
+		__m256 previous = _mm256_load_ps(cells);
+		__m256 cell = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		for (int n = 1; n < SRE3021_WAVEFORM_CELL_COUNT && _mm256_movemask_ps(isFound) != 0xFF; ++n)
+		{
+			const __m256 current = _mm256_load_ps(cells + n * stride);
+			const __m256 isCrossing = _mm256_andnot_ps(isFound,
+				_mm256_and_ps(_mm256_cmp_ps(current, threshold, _CMP_GE_OQ), _mm256_cmp_ps(previous, threshold, _CMP_LT_OQ)));
+			crossingCell = _mm256_blendv_ps(crossingCell, cell, isCrossing);
+			crossingPrevious = _mm256_blendv_ps(crossingPrevious, previous, isCrossing);
+			crossingCurrent = _mm256_blendv_ps(crossingCurrent, current, isCrossing);
+			isFound = _mm256_or_ps(isFound, isCrossing);
+			previous = current;
+			cell = _mm256_add_ps(cell, one);
+		}
+		const __m256 time = _mm256_add_ps(crossingCell, _mm256_div_ps(_mm256_sub_ps(threshold, crossingPrevious), _mm256_sub_ps(crossingCurrent, crossingPrevious)));
+		return _mm256_and_ps(isFound, time);
+	}
+
+	// Four lanes starting at lane, the same steps as FilterLaneScalar with the lanes side by side
+	SRE3021_TARGET_SSE2 void FilterLanesSSE2(float* cells, int lane, const FilterParams& params, BlockResults& out)
+	{
+		const int stride = SRE3021_WAVEFORM_LANE_COUNT;
+		__m128 baseline = _mm_setzero_ps();
+		for (int n = 0; n < params.BaselineCells; ++n)
+		{
+			baseline = _mm_add_ps(baseline, _mm_loadu_ps(cells + n * stride + lane));
+		}
+		baseline = _mm_mul_ps(baseline, _mm_set1_ps(1.0f / params.BaselineCells));
+		for (int n = 0; n < SRE3021_WAVEFORM_CELL_COUNT; ++n)
+		{
+			_mm_storeu_ps(cells + n * stride + lane, _mm_sub_ps(_mm_loadu_ps(cells + n * stride + lane), baseline));
+		}
+
+		const int k = params.RiseCells;
+		const int l = params.GapCells;
+		const __m128 decayFactor = _mm_set1_ps(params.DecayFactor);
+		const __m128 gain = _mm_set1_ps(params.Gain);
+		__m128 p = _mm_setzero_ps();
+		__m128 s = _mm_setzero_ps();
+		__m128 amplitude = _mm_set1_ps(-FLT_MAX);
+		__m128 peakCell = _mm_setzero_ps();
+		__m128 pulseMax = _mm_set1_ps(-FLT_MAX);
+		for (int n = 0; n < SRE3021_WAVEFORM_CELL_COUNT; ++n)
+		{
+			const __m128 v = _mm_loadu_ps(cells + n * stride + lane);
+			__m128 d = v;
+			if (n >= k)
+			{
+				d = _mm_sub_ps(d, _mm_loadu_ps(cells + (n - k) * stride + lane));
+			}
+			if (n >= l)
+			{
+				d = _mm_sub_ps(d, _mm_loadu_ps(cells + (n - l) * stride + lane));
+			}
+			if (n >= k + l)
+			{
+				d = _mm_add_ps(d, _mm_loadu_ps(cells + (n - k - l) * stride + lane));
+			}
+			p = _mm_add_ps(p, d);
+			s = _mm_add_ps(s, _mm_add_ps(p, _mm_mul_ps(decayFactor, d)));
+			const __m128 trapezoid = _mm_mul_ps(params.DecayFactor > 0.0f ? s : p, gain);
+			const __m128 isHigher = _mm_cmpgt_ps(trapezoid, amplitude);
+			amplitude = _mm_max_ps(amplitude, trapezoid);
+			peakCell = _mm_or_ps(_mm_and_ps(isHigher, _mm_set1_ps(static_cast<float>(n))), _mm_andnot_ps(isHigher, peakCell));
+			pulseMax = _mm_max_ps(pulseMax, v);
+		}
+
+		const __m128 times[3] = {
+			FirstCrossingSSE2(cells + lane, _mm_mul_ps(pulseMax, _mm_set1_ps(CrossingFractions[0]))),
+			FirstCrossingSSE2(cells + lane, _mm_mul_ps(pulseMax, _mm_set1_ps(CrossingFractions[1]))),
+			FirstCrossingSSE2(cells + lane, _mm_mul_ps(pulseMax, _mm_set1_ps(CrossingFractions[2]))) };
+		_mm_storeu_ps(out.Baseline + lane, baseline);
+		_mm_storeu_ps(out.Amplitude + lane, amplitude);
+		_mm_storeu_ps(out.PeakCell + lane, peakCell);
+		_mm_storeu_ps(out.Time10 + lane, times[0]);
+		_mm_storeu_ps(out.Time50 + lane, times[1]);
+		_mm_storeu_ps(out.Time90 + lane, times[2]);
+	}
+
+	SRE3021_TARGET_AVX2 void FilterLanesAVX2(float* cells, const FilterParams& params, BlockResults& out)
+	{
+		const int stride = SRE3021_WAVEFORM_LANE_COUNT;
+		__m256 baseline = _mm256_setzero_ps();
+		for (int n = 0; n < params.BaselineCells; ++n)
+		{
+			baseline = _mm256_add_ps(baseline, _mm256_load_ps(cells + n * stride));
+		}
+		baseline = _mm256_mul_ps(baseline, _mm256_set1_ps(1.0f / params.BaselineCells));
+		for (int n = 0; n < SRE3021_WAVEFORM_CELL_COUNT; ++n)
+		{
+			_mm256_store_ps(cells + n * stride, _mm256_sub_ps(_mm256_load_ps(cells + n * stride), baseline));
+		}
+
+		const int k = params.RiseCells;
+		const int l = params.GapCells;
+		const __m256 decayFactor = _mm256_set1_ps(params.DecayFactor);
+		const __m256 gain = _mm256_set1_ps(params.Gain);
+		__m256 p = _mm256_setzero_ps();
+		__m256 s = _mm256_setzero_ps();
+		__m256 amplitude = _mm256_set1_ps(-FLT_MAX);
+		__m256 peakCell = _mm256_setzero_ps();
+		__m256 pulseMax = _mm256_set1_ps(-FLT_MAX);
+		for (int n = 0; n < SRE3021_WAVEFORM_CELL_COUNT; ++n)
+		{
+			const __m256 v = _mm256_load_ps(cells + n * stride);
+			__m256 d = v;
+			if (n >= k)
+			{
+				d = _mm256_sub_ps(d, _mm256_load_ps(cells + (n - k) * stride));
+			}
+			if (n >= l)
+			{
+				d = _mm256_sub_ps(d, _mm256_load_ps(cells + (n - l) * stride));
+			}
+			if (n >= k + l)
+			{
+				d = _mm256_add_ps(d, _mm256_load_ps(cells + (n - k - l) * stride));
+			}
+			p = _mm256_add_ps(p, d);
+			s = _mm256_add_ps(s, _mm256_add_ps(p, _mm256_mul_ps(decayFactor, d)));
+			const __m256 trapezoid = _mm256_mul_ps(params.DecayFactor > 0.0f ? s : p, gain);
+			peakCell = _mm256_blendv_ps(peakCell, _mm256_set1_ps(static_cast<float>(n)), _mm256_cmp_ps(trapezoid, amplitude, _CMP_GT_OQ));
+			amplitude = _mm256_max_ps(amplitude, trapezoid);
+			pulseMax = _mm256_max_ps(pulseMax, v);
+		}
+
+		const __m256 times[3] = {
+			FirstCrossingAVX2(cells, _mm256_mul_ps(pulseMax, _mm256_set1_ps(CrossingFractions[0]))),
+			FirstCrossingAVX2(cells, _mm256_mul_ps(pulseMax, _mm256_set1_ps(CrossingFractions[1]))),
+			FirstCrossingAVX2(cells, _mm256_mul_ps(pulseMax, _mm256_set1_ps(CrossingFractions[2]))) };
+		_mm256_storeu_ps(out.Baseline, baseline);
+		_mm256_storeu_ps(out.Amplitude, amplitude);
+		_mm256_storeu_ps(out.PeakCell, peakCell);
+		_mm256_storeu_ps(out.Time10, times[0]);
+		_mm256_storeu_ps(out.Time50, times[1]);
+		_mm256_storeu_ps(out.Time90, times[2]);
+	}
+#endif
+}
+
+hurel::sre3021::SRE3021WaveformProcessor::SRE3021WaveformProcessor()
+{
+	SetFilter(SRE3021WaveformFilter{ SRE3021_WAVEFORM_BASELINE_CELLS, SRE3021_WAVEFORM_RISE_CELLS, SRE3021_WAVEFORM_FLAT_TOP_CELLS, 0.0, false });
+	simdLevel = SRE3021ImageDecoder::DetectSimdLevel();
+}
+
+SRE3021PacketDecodeStatus hurel::sre3021::SRE3021WaveformProcessor::Decode(const unsigned __int8* data, int dataLength, SRE3021WaveformData& outWaveform, int cellPointer)
+{
+	if (dataLength < SRE3021_PIPELINE_SAMPLING_DATA_LENGTH)
+	{
+		return SRE3021PacketDecodeStatus::ERROR_DATA_LENGTH;
+	}
+	outWaveform.SourceId = data[0];
+	outWaveform.TriggerType = static_cast<SRE3021TriggerType>(data[1]);
+	outWaveform.HoldDelay = SRE3021HeaderCodec::ReadBigEndian16(&data[2]);
+	const unsigned int channel = SRE3021HeaderCodec::ReadBigEndian16(&data[4]);
+	outWaveform.IsAnode = (channel >> 15) != 0;
+	if (outWaveform.IsAnode)
+	{
+		outWaveform.CellPointer = cellPointer;
+		outWaveform.IsTriggered = ((channel >> 8) & 1) != 0;
+		outWaveform.X = (channel >> 4) & 0xF;
+		outWaveform.Y = channel & 0xF;
+	}
+	else
+	{
+		outWaveform.CellPointer = channel & 0xFF;
+		outWaveform.IsTriggered = false;
+		outWaveform.X = -1;
+		outWaveform.Y = -1;
+	}
+	outWaveform.Timestamp = 0;
+	outWaveform.ReceiveTime = 0;
+
+	// The cell under the pointer was written last, the oldest cell is the one after it
+	int first = 0;
+	if (outWaveform.CellPointer >= 0 && outWaveform.CellPointer < SRE3021_WAVEFORM_CELL_COUNT)
+	{
+		first = outWaveform.CellPointer + 1;
+	}
+	const unsigned __int8* cells = data + SRE3021_PIPELINE_SAMPLING_FIELDS_LENGTH;
+	unsigned int overflow = 0;
+	for (int i = 0; i < SRE3021_WAVEFORM_CELL_COUNT; ++i)
+	{
+		int cell = first + i;
+		if (cell >= SRE3021_WAVEFORM_CELL_COUNT)
+		{
+			cell -= SRE3021_WAVEFORM_CELL_COUNT;
+		}
+		const unsigned int value = SRE3021HeaderCodec::ReadBigEndian16(&cells[2 * cell]);
+		overflow |= value;
+		outWaveform.Cells[i] = static_cast<unsigned __int16>(value & SRE3021_WAVEFORM_ADC_MASK);
+	}
+	outWaveform.IsOverflow = (overflow & SRE3021_WAVEFORM_OVERFLOW_BIT) != 0;
+	return SRE3021PacketDecodeStatus::SUCCESS;
+}
+
+void hurel::sre3021::SRE3021WaveformProcessor::SetFilter(const SRE3021WaveformFilter& filter)
+{
+	this->filter = filter;
+	this->filter.BaselineCells = std::min(std::max(filter.BaselineCells, 1), SRE3021_WAVEFORM_CELL_COUNT);
+	this->filter.RiseCells = std::min(std::max(filter.RiseCells, 1), SRE3021_WAVEFORM_CELL_COUNT / 2);
+	this->filter.FlatTopCells = std::min(std::max(filter.FlatTopCells, 0), SRE3021_WAVEFORM_CELL_COUNT / 2);
+	if (filter.DecayCells > 0.0)
+	{
+		// M = 1 / (exp(1 / tau) - 1) turns the exponential decay back into a step
+		const double m = 1.0 / std::expm1(1.0 / filter.DecayCells);
+		decayFactor = static_cast<float>(m);
+		trapezoidGain = static_cast<float>(1.0 / (this->filter.RiseCells * m));
+	}
+	else
+	{
+		decayFactor = 0.0f;
+		trapezoidGain = 1.0f / this->filter.RiseCells;
+	}
+}
+
+void hurel::sre3021::SRE3021WaveformProcessor::SetSimdLevel(SRE3021SimdLevel level)
+{
+	SRE3021SimdLevel detected = SRE3021ImageDecoder::DetectSimdLevel();
+	simdLevel = static_cast<int>(level) < static_cast<int>(detected) ? level : detected;
+}
+
+void hurel::sre3021::SRE3021WaveformProcessor::Process(const SRE3021WaveformData* waveforms, size_t waveformCount, SRE3021WaveformResult* outResults) const
+{
+	const FilterParams params{ filter.BaselineCells, filter.RiseCells, filter.RiseCells + filter.FlatTopCells, decayFactor, trapezoidGain };
+	alignas(32) float cells[SRE3021_WAVEFORM_CELL_COUNT * SRE3021_WAVEFORM_LANE_COUNT];
+	BlockResults block;
+	for (size_t first = 0; first < waveformCount; first += SRE3021_WAVEFORM_LANE_COUNT)
+	{
+		const int laneCount = static_cast<int>(std::min<size_t>(SRE3021_WAVEFORM_LANE_COUNT, waveformCount - first));
+		for (int lane = 0; lane < SRE3021_WAVEFORM_LANE_COUNT; ++lane)
+		{
+			// Lanes past the last waveform repeat it, their results are not used
+			const SRE3021WaveformData& waveform = waveforms[first + std::min(lane, laneCount - 1)];
+			const float sign = filter.InvertCathode && !waveform.IsAnode ? -1.0f : 1.0f;
+			for (int n = 0; n < SRE3021_WAVEFORM_CELL_COUNT; ++n)
+			{
+				cells[n * SRE3021_WAVEFORM_LANE_COUNT + lane] = sign * waveform.Cells[n];
+			}
+		}
+
+		switch (simdLevel)
+		{
+#if SRE3021_HAS_X86_SIMD
+		case SRE3021SimdLevel::AVX2:
+			FilterLanesAVX2(cells, params, block);
+			break;
+		case SRE3021SimdLevel::SSE2:
+			FilterLanesSSE2(cells, 0, params, block);
+			FilterLanesSSE2(cells, 4, params, block);
+			break;
+#endif
+		default:
+			for (int lane = 0; lane < laneCount; ++lane)
+			{
+				FilterLaneScalar(cells, lane, params, block);
+			}
+			break;
+		}
+
+		for (int lane = 0; lane < laneCount; ++lane)
+		{
+			SRE3021WaveformResult& result = outResults[first + lane];
+			result.Baseline = block.Baseline[lane];
+			result.Amplitude = block.Amplitude[lane];
+			result.Time = block.Time50[lane];
+			result.RiseTime = block.Time90[lane] - block.Time10[lane];
+			result.PeakCell = static_cast<int>(block.PeakCell[lane]);
+			result.IsOverflow = waveforms[first + lane].IsOverflow;
+		}
+	}
+}
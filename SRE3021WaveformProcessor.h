@@ -0,0 +1,120 @@
+// ----------------------------------------------------------------------------
+// -                        SRE3021API C++ version                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2022-2022 Choi, Sehoon (triplehoon95@hanyang.ac.kr)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+#pragma once
+
+#include "SRE3021Types.h"
+#include "SRE3021ImageDecoder.h"
+
+// Pipeline sampling data: SourceId, TriggerType (1 byte each), HoldDelay (2 bytes), a 2 byte channel word, then 160 cells of 2 bytes.
+// Channel word: bit 15 channel type (0 cathode, 1 anode). Cathode: bits 7-0 cell pointer.
+// Anode: bit 8 trigger flag, bits 7-4 x address, bits 3-0 y address.
+#define SRE3021_PIPELINE_SAMPLING_DATA_LENGTH (326)
+#define SRE3021_PIPELINE_SAMPLING_FIELDS_LENGTH (6)
+#define SRE3021_WAVEFORM_CELL_COUNT (160)
+// Cells are a 14 bit ADC value and an overflow bit
+#define SRE3021_WAVEFORM_ADC_MASK (0x3FFF)
+#define SRE3021_WAVEFORM_OVERFLOW_BIT (0x4000)
+// Waveforms filtered together, one per float lane of an AVX2 register
+#define SRE3021_WAVEFORM_LANE_COUNT (8)
+#define SRE3021_WAVEFORM_BASELINE_CELLS (32)
+#define SRE3021_WAVEFORM_RISE_CELLS (16)
+#define SRE3021_WAVEFORM_FLAT_TOP_CELLS (8)
+
+namespace hurel {
+    namespace sre3021 {
+        /// <summary>
+        /// One channel of pipeline sampling data. Cells are in time order, oldest first, when the cell pointer is known.
+        /// Timestamp and ReceiveTime are as in SRE3021ImageData.
+        /// </summary>
+        struct SRE3021WaveformData {
+            int SourceId; SRE3021TriggerType TriggerType; int HoldDelay; bool IsAnode; int CellPointer; bool IsTriggered; int X; int Y; bool IsOverflow;
+            unsigned long long Timestamp; long long ReceiveTime;
+            unsigned __int16 Cells[SRE3021_WAVEFORM_CELL_COUNT];
+        };
+
+        /// <summary>
+        /// Trapezoidal shaping parameters in cells. DecayCells is the decay time constant of the preamplifier for the
+        /// pole-zero correction, 0 for a step shaped signal. Cathode signals are inverted when InvertCathode is set,
+        /// so that every pulse rises.
+        /// </summary>
+        struct SRE3021WaveformFilter {
+            int BaselineCells; int RiseCells; int FlatTopCells; double DecayCells; bool InvertCathode;
+        };
+
+        /// <summary>
+        /// Baseline is the mean of the first BaselineCells cells, Amplitude the flat top of the trapezoid.
+        /// Times are in cells from the first cell, interpolated between cells: Time at 50% of the pulse maximum
+        /// and RiseTime from 10% to 90%.
+        /// </summary>
+        struct SRE3021WaveformResult {
+            float Baseline; float Amplitude; float Time; float RiseTime; int PeakCell; bool IsOverflow;
+        };
+
+        /// <summary>
+        /// Decodes pipeline sampling packets and filters their waveforms: baseline restore, trapezoidal shaping and rise time.
+        /// Waveforms are processed SRE3021_WAVEFORM_LANE_COUNT at a time, one per vector lane, with AVX2 or SSE2 when the CPU has it.
+        /// SetFilter must not run concurrently with Process.
+        /// </summary>
+        class SRE3021WaveformProcessor
+        {
+        public:
+            SRE3021WaveformProcessor();
+
+            /// <summary>
+            /// Decode the Packet Data field of a pipeline sampling packet
+            /// </summary>
+            /// <param name="cellPointer">cell pointer of the readout, for anode channels which do not carry it. -1 keeps the packet order.
+            /// Cathode channels use their own.</param>
+            static SRE3021PacketDecodeStatus Decode(const unsigned __int8* data, int dataLength, SRE3021WaveformData& outWaveform, int cellPointer = -1);
+
+            void SetFilter(const SRE3021WaveformFilter& filter);
+
+            SRE3021WaveformFilter GetFilter() const
+            {
+                return filter;
+            };
+
+            void Process(const SRE3021WaveformData* waveforms, size_t waveformCount, SRE3021WaveformResult* outResults) const;
+
+            /// <summary>
+            /// Use a lower instruction set than detected. Requests above the detected level are clamped.
+            /// </summary>
+            void SetSimdLevel(SRE3021SimdLevel level);
+
+            SRE3021SimdLevel GetSimdLevel() const
+            {
+                return simdLevel;
+            };
+
+        private:
+            SRE3021WaveformFilter filter;
+            // Pole-zero factor M of the recursive trapezoid, 0 without correction, and the gain that makes the flat top the pulse height
+            float decayFactor = 0.0f;
+            float trapezoidGain = 1.0f;
+            SRE3021SimdLevel simdLevel = SRE3021SimdLevel::SCALAR;
+        };
+    };
+};
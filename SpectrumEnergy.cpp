@@ -42,13 +42,25 @@ SpectrumEnergy::SpectrumEnergy(double binSize, double maxEnergy)
 
 void SpectrumEnergy::AddEnergy(double energy)
 {
-    for (int i = 0; i < EnergyBin.size() - 1; ++i)
+    if (EnergyBin.size() < 2 || !(energy > EnergyBin.front() && energy < EnergyBin.back()))
     {
-        if (energy < EnergyBin[i + 1] && energy > EnergyBin[i])
-        {
-            ++HistoEnergies[i].Count;
-            break;
-        }
+        return;
+    }
+    // Bins are BinSize wide from 0. Start at the computed bin and step over rounding at the bin edges.
+    const int lastBin = static_cast<int>(EnergyBin.size()) - 2;
+    int i = BinSize > 0 ? static_cast<int>(energy / BinSize) : 0;
+    i = i < 0 ? 0 : (i > lastBin ? lastBin : i);
+    while (i > 0 && energy <= EnergyBin[i])
+    {
+        --i;
+    }
+    while (i < lastBin && energy >= EnergyBin[i + 1])
+    {
+        ++i;
+    }
+    if (energy < EnergyBin[i + 1] && energy > EnergyBin[i])
+    {
+        ++HistoEnergies[i].Count;
     }
 }
 